@@ -21,18 +21,34 @@ using namespace std;
 
 const eChar VERSION[] = "1.0a";
 
+// random data walks through all contexts of
+// the context mixing model, packs and unpacks
+static void testRoundTrip()
+{
+    eByteArray src(256*1024), packed, unpacked;
+    eU32 seed = 0x12345678;
+
+    for (eU32 i=0; i<src.size(); i++)
+        src[i] = (eU8)eRandom(seed);
+
+    eContextMixPacker packer;
+    packer.pack(src, packed);
+    packer.unpack(packed, unpacked);
+
+    if (unpacked.size() != src.size() || !eMemEqual(&unpacked[0], &src[0], src.size()))
+        cout << "Context mixing round-trip failed!" << endl;
+}
+
 static void testAlgos()
 {
-    eByteArray src, dataBwt, dataMtf, dataRle;
-    eBurrowsWheeler bwt;
-    eMoveToFront mtf;
-    eTextRle rle;
+    testRoundTrip();
+
+    eByteArray src, dataRle;
+    ePipelinePacker packer;
 
     src = eFile::readAll("shaders.txt");
 
-    bwt.pack(src, dataRle);
-    //mtf.pack(dataBwt, dataMtf);
-    //rle.pack(dataBwt, dataRle);
+    packer.pack(src, dataRle);
 
     eFile f("shaders_packed");
     f.open(eFOM_WRITE);
@@ -62,6 +78,7 @@ eInt main(eInt argc, eChar *argv[])
 {
     eLeakDetectorStart();
     testAlgos();
+    eJobPool::shutdownDefault();
 
     cout << "-----------------------------------------------------------" << endl;
     cout << "Enigma Pack " << VERSION << " - Brain Control Executable Compressor" << endl;
@@ -159,6 +159,7 @@ void WinMainCRTStartup()
       
 #ifndef eCFG_NO_CLEANUP
         eOpStacking::shutdown();
+        eJobPool::shutdownDefault();
 #endif
     }
 
@@ -144,12 +144,32 @@ void eEditMesh::triangulate()
     m_triangulated = eTRUE;
 }
 
+static eU32 hashEdge(eU32 startPos, eU32 endPos)
+{
+    return eHashInt(startPos*0x9e3779b1+endPos);
+}
+
+// unpaired edges are kept in a hash table keyed
+// by (start position, end position). the twin
+// of an edge is found by looking up the reversed
+// key, so pairing takes expected linear time.
 void eEditMesh::calcAdjacency()
 {
-    eArray<eU32> unpaired;
-    unpaired.reserve(m_faces.size()*eEmFace::MAX_DEGREE); // very conservative
+    ePROFILER_FUNC();
+
+    eU32 edgeCount = 0;
+    for (eU32 i=0; i<m_faces.size(); i++)
+        edgeCount += m_faces[i].count;
+
+    const eU32 tableSize = eNextPowerOf2(edgeCount*2+1);
+    eArray<eInt> buckets(tableSize), chain(edgeCount);
+    eU32 numUnpaired = 0;
+
+    for (eU32 i=0; i<tableSize; i++)
+        buckets[i] = -1;
+
     m_edges.clear();
-    m_edges.reserve(m_faces.size()*3);
+    m_edges.reserve(edgeCount);
 
     for (eU32 i=0; i<m_faces.size(); i++)
     {
@@ -158,7 +178,8 @@ void eEditMesh::calcAdjacency()
 
         for (eU32 j=0; j<face.count; j++)
         {
-            face.edges[j] = m_edges.size();
+            const eU32 edgeIdx = m_edges.size();
+            face.edges[j] = edgeIdx;
             
             eEmEdge &edge = m_edges.append();
             edge.temp = 0;
@@ -172,28 +193,41 @@ void eEditMesh::calcAdjacency()
             edge.prev = oldEdgeCount+(j+face.count-1)%face.count;
             edge.twin = -1;
 
-            // try to find twin for current edge
-            for (eU32 k=0; k<unpaired.size(); k++) // fast as unpaired's size is usually little
+            // try to find twin for current edge and
+            // remove it from the unpaired edges
+            const eU32 twinBucket = hashEdge(edge.endPos, edge.startPos)&(tableSize-1);
+
+            for (eInt k=buckets[twinBucket], prev=-1; k!=-1; prev=k, k=chain[k])
             {
-                const eU32 p = unpaired[k];
-                eEmEdge &pe = m_edges[p];
+                eEmEdge &pe = m_edges[k];
 
                 if (pe.startPos == edge.endPos && pe.endPos == edge.startPos)
                 {
-                    edge.twin = p;
-                    pe.twin = m_edges.size()-1;
-                    unpaired.removeSwap(k);
+                    edge.twin = k;
+                    pe.twin = edgeIdx;
+
+                    if (prev == -1)
+                        buckets[twinBucket] = chain[k];
+                    else
+                        chain[prev] = chain[k];
+
+                    numUnpaired--;
                     break;
                 }
             }
 
             if (edge.twin == -1)
-                unpaired.append(m_edges.size()-1);
+            {
+                const eU32 bucket = hashEdge(edge.startPos, edge.endPos)&(tableSize-1);
+                chain[edgeIdx] = buckets[bucket];
+                buckets[bucket] = edgeIdx;
+                numUnpaired++;
+            }
         }
     }
 
     // is mesh closed or not?
-    m_closed = unpaired.isEmpty();
+    m_closed = (numUnpaired == 0);
 }
 
 void eEditMesh::calcNormals()
@@ -255,22 +289,80 @@ void eEditMesh::setBoundingBox(const eAABB &bbox)
     m_bbox = bbox;
 }
 
-// merges duplicate positions
-void eEditMesh::unifyPositions()
+static eU32 hashCell(eInt x, eInt y, eInt z)
+{
+    return ((eU32)x*73856093)^((eU32)y*19349663)^((eU32)z*83492791);
+}
+
+// merges positions which are closer than epsilon
+// in each coordinate. positions are put into a
+// spatial hash of cells at least epsilon wide, so
+// for each position only the 27 surrounding
+// cells have to be searched for duplicates.
+void eEditMesh::unifyPositions(eF32 epsilon)
 {
+    eASSERT(epsilon > 0.0f);
+
+    // cells are enlarged for far away positions, so
+    // that cell coordinates don't overflow eInt
+    eF32 maxCoord = 0.0f;
+
+    for (eU32 i=0; i<m_vtxPos.size(); i++)
+    {
+        const eVector3 &pos = m_vtxPos[i].pos;
+        maxCoord = eMax(maxCoord, eMax(eAbs(pos.x), eMax(eAbs(pos.y), eAbs(pos.z))));
+    }
+
+    const eU32 tableSize = eNextPowerOf2(m_vtxPos.size()*2+1);
+    const eF32 invCellSize = 1.0f/eMax(epsilon, maxCoord/(eF32)(1<<20));
+    eArray<eInt> buckets(tableSize), chain(m_vtxPos.size());
     eArray<eU32> idxMap(m_vtxPos.size()), vtxMap(m_vtxPos.size());
     eU32 numUniqueVerts = 0;
 
+    for (eU32 i=0; i<tableSize; i++)
+        buckets[i] = -1;
+
     for (eU32 i=0; i<m_vtxPos.size(); i++)
     {
+        const eVector3 &pos = m_vtxPos[i].pos;
+        const eInt cx = eFloor(pos.x*invCellSize);
+        const eInt cy = eFloor(pos.y*invCellSize);
+        const eInt cz = eFloor(pos.z*invCellSize);
         eInt foundAt = -1;
 
-        for (eU32 j=0; j<i && foundAt==-1; j++)
-            if (m_vtxPos[i].pos == m_vtxPos[j].pos)
-                foundAt = j;
+        // only unique positions are in the hash. take
+        // the first one to be deterministic, in case
+        // more than one lies within epsilon.
+        for (eInt z=cz-1; z<=cz+1; z++)
+        {
+            for (eInt y=cy-1; y<=cy+1; y++)
+            {
+                for (eInt x=cx-1; x<=cx+1; x++)
+                {
+                    const eU32 bucket = hashCell(x, y, z)&(tableSize-1);
+
+                    for (eInt j=buckets[bucket]; j!=-1; j=chain[j])
+                    {
+                        const eVector3 &other = m_vtxPos[j].pos;
+
+                        if ((foundAt == -1 || j < foundAt) &&
+                            eAbs(pos.x-other.x) < epsilon &&
+                            eAbs(pos.y-other.y) < epsilon &&
+                            eAbs(pos.z-other.z) < epsilon)
+                        {
+                            foundAt = j;
+                        }
+                    }
+                }
+            }
+        }
 
         if (foundAt == -1)
         {
+            const eU32 bucket = hashCell(cx, cy, cz)&(tableSize-1);
+            chain[i] = buckets[bucket];
+            buckets[bucket] = i;
+
             vtxMap[numUniqueVerts] = i;
             idxMap[i] = numUniqueVerts++;
         }
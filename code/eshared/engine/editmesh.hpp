@@ -85,7 +85,7 @@ public:
     void                calcNormals();
     void                calcAvgNormals();
     void                calcBoundingBox();
-    void                unifyPositions();
+    void                unifyPositions(eF32 epsilon=eALMOST_ZERO);
     void                tidyUp();
     void                setBoundingBox(const eAABB &bbox);
     void                setMaterial(const eMaterial *mat);
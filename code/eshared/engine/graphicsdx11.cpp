@@ -692,7 +692,7 @@ void eGraphicsDx11::beginLoadGeometry(eGeometryDx11 *geo, eU32 vertexCount, ePtr
         }
 
         if (!geo->vb)
-            geo->vb = _createGeoBuffer(eTRUE, eMax(reqVbSize, (eU32)GBS_VB_DYN), eFALSE);
+            geo->vb = _createGeoBuffer(eTRUE, eMax(reqVbSize, (eU32)GBS_VB_USER), eFALSE);
 
         m_geoMapData[0].resize(reqVbSize);
         *vertices = &m_geoMapData[0][0];
@@ -866,12 +866,21 @@ void eGraphicsDx11::renderGeometry(eGeometry *geo, const eArray<eInstVtx> &insts
     if (geo->primType == eGPT_QUADLIST)
     {
         m_devCtx->IASetIndexBuffer(m_geoBufs[GBID_IB_QUAD]->d3dBuf, DXGI_FORMAT_R16_UINT, 0);
-        const eU32 numIndices = triCount*3;
 
-        if (insts.size())
-            m_devCtx->DrawIndexedInstanced(numIndices, insts.size(), 0, 0, 0);
-        else
-            m_devCtx->DrawIndexed(numIndices, 0, 0);
+        // the 16 bit quad index buffer only addresses
+        // 65536 vertices, so larger quad lists are
+        // drawn in batches using a base vertex
+        const eU32 numQuads = geo->usedVerts/4;
+
+        for (eU32 first=0; first<numQuads; first+=GBE_IB_QUAD/6)
+        {
+            const eU32 numIndices = eMin(numQuads-first, (eU32)GBE_IB_QUAD/6)*6;
+
+            if (insts.size())
+                m_devCtx->DrawIndexedInstanced(numIndices, insts.size(), 0, first*4, 0);
+            else
+                m_devCtx->DrawIndexed(numIndices, 0, first*4);
+        }
     }
     else if (geo->indexed)
     {
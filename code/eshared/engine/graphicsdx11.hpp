@@ -364,14 +364,15 @@ private:
 
     enum GeoBufferElements
     {
-        GBE_IB_QUAD             = 0x8000*6,     // 32768 quads
+        GBE_IB_QUAD             = 0x4000*6,     // 16384 quads (65536 vertices)
         GBE_VB_INST             = 65536
     };
 
     enum GeoBufferSize
     {
         GBS_VB_INST             = GBE_VB_INST*sizeof(eInstVtx), // 6.25 MB
-        GBS_VB_DYN              = 24*1024*1024, // 16 MB
+        GBS_VB_DYN              = 64*1024*1024, // 64 MB
+        GBS_VB_USER             = 24*1024*1024, // 24 MB
         GBS_IB_DYN              = 8*1024*1024,  // 6 MB
         GBS_IB_QUAD             = GBE_IB_QUAD*sizeof(eU16)
     };
@@ -20,12 +20,44 @@
 
 const eF32 eParticleSystem::MAX_TIME_STEP = 1.0f/30.0f;
 
+// indices of the random values drawn for each
+// emitted particle
+enum : eU32
+{
+    RND_SIZE,
+    RND_MASS,
+    RND_VEL,
+    RND_DIRX,
+    RND_DIRZ,
+    RND_AREA,
+    RND_FACEU,
+    RND_FACEV,
+    RND_LIFE
+};
+
+// counter based random numbers in [0,1). the
+// values of a particle only depend on its
+// emission number, so the simulation doesn't
+// depend on any global random state.
+static eF32 particleRandom(eU32 particle, eU32 index)
+{
+    eU32 h = ((particle<<4)|index)+0x9e3779b9;
+    h = (h^(h>>16))*0x7feb352d;
+    h = (h^(h>>15))*0x846ca68b;
+    h ^= h>>16;
+    return (eF32)(h>>8)*(1.0f/16777216.0f);
+}
+
+// checkpoint memory of all particle systems,
+// they share one budget
+static volatile eInt g_checkpointMem = 0;
+
 eParticleSystem::eParticleSystem() :
-    m_particles(MAX_PARTICLES),
+    m_remainder(0.0f),
+    m_valid(eFALSE),
+    m_checkpointSteps(CHECKPOINT_STEPS),
+    m_checkpointMem(0),
     m_lastTime(0.0f),
-    m_timer(-1.0f),
-    m_emitTime(0.0f),
-    m_count(0),
     m_tex(nullptr),
     m_emissionFreq(100.0f),
     m_emissionVel(1.0f),
@@ -38,8 +70,13 @@ eParticleSystem::eParticleSystem() :
     m_randomization(0),
     m_sizePath(nullptr),
     m_colorPath(nullptr),
-    m_rotPath(nullptr)
+    m_rotPath(nullptr),
+    m_emitterMode(ePSEM_FACES),
+    m_emitterMesh(nullptr),
+    m_emitterEmitSurfaceArea(0.0f)
 {
+    _initState(m_sim);
+    _initState(m_emitted);
     m_gravityConst = (eVector3*)eAllocAlignedAndZero(4 * sizeof(eF32), 16);
     m_geo = eGfx->addGeometry(eGEO_DYNAMIC, eVTX_PARTICLE, eGPT_QUADLIST, _fillGeoBuffers, this);
 }
@@ -48,141 +85,70 @@ eParticleSystem::~eParticleSystem()
 {
     eGfx->removeGeometry(m_geo);
     eFreeAligned(m_gravityConst);
+    _clearCheckpoints();
+    _freeState(m_sim);
+    _freeState(m_emitted);
 }
 
-// assumes time in second
+// assumes time in second. the simulation runs
+// in fixed time steps from time zero on, so
+// the state only depends on the time and not
+// on the way it was reached. the remainder of
+// the last step isn't simulated on a copy of
+// the state: the particles are advanced by it
+// when they're displayed, only the ones emitted
+// during the remainder are set up separately.
 void eParticleSystem::update(eF32 time)
 {
     ePROFILER_FUNC();
 
-    if (time == m_lastTime)
+    if (time == m_lastTime && m_valid)
         return;
 
-    eU32 seed = eRandomSeed();
-
-    const eF32 deltaTime = eMax(0.0f, time-m_lastTime);
     m_lastTime = time;
-    time = deltaTime;
-    m_bbox.clear();
-    eF32 timeLeft = time > 1.0f ? 1.0f : time;
-    while (timeLeft > 0.0f) {
-        if (timeLeft <= MAX_TIME_STEP) {
-            time = timeLeft;
-            timeLeft = 0.0f;
-        } else {
-            timeLeft -= MAX_TIME_STEP;
-            time = MAX_TIME_STEP;
-        }
+    time = eMax(0.0f, time);
 
-        const eF32 timeNow = m_timer+time;
-
-        // Add life and delete unused particles.
-        eS32 low = 0;
-        eS32 high = m_count - 1;
-        bool upwards = true;
-        while(high >= low) {
-            Particle &p = upwards ? m_particles[low] : m_particles[high];
-            p.timeToLive -= time*p.timeConstant;
-            if(upwards) {
-                if(p.timeToLive >= 0.0f)
-                    low++;
-                else
-                    upwards = false;
-            } else {
-                if(p.timeToLive >= 0.0f) {
-                    m_particles[low++] = p;
-                    upwards = true;
-                }
-                high--;
-            }
-        }
-        m_count = high + 1;
-
-        // calculate movement of particles
-        _moveParticles(&m_particles[0], m_count, m_timer, time);
-
-        // emit new particles
-        if (m_emissionFreq > 0.0f) {
-            eF32 emitDelay = 1.0f/m_emissionFreq;
-            eF32 relTime = m_timer;
-            m_emitTime += time;
-            while (m_emitTime >= emitDelay) {
-                m_emitTime -= emitDelay;
-                eF32 timeRemaining = m_emitTime;
-                // emit new particles
-                if (m_count < MAX_PARTICLES) {
-                    Particle &p = m_particles[m_count];
-                    p.rotation = 0;
-                    p.size = 1.0f * (1.0f - eRandomF(seed) * m_randomization);
-                    p.mass = 1.0f * (1.0f - eRandomF(seed) * m_randomization);
-                    eF32 initVel = m_emissionVel * (1.0f - eRandomF(seed) * m_randomization);
-                    if (m_emitterMesh == nullptr || m_emitterEntities.size() == 0) {
-                        p.dynamicEntity.position.null();
-                        p.dynamicEntity.velocity = eVector3(eRandomF(-1.0f, 1.0f, seed), 1.0f, eRandomF(-1.0f, 1.0f, seed))*initVel;
-                    } else {
-                        // lookup random entity with binary search
-                        eF32 a = eRandomF(seed) * m_emitterEmitSurfaceArea;
-                        eU32 l = 0;
-                        eU32 r = m_emitterEntities.size();
-                        while (l < r) {
-                            eU32 m = (l + r) >> 1;
-                            if (a < m_emitterEntities[m])   r = m;
-                            else                            l = m+1;
-                        }
-                        eU32 f = eClamp((eU32)0, r , m_emitterEntities.size()-1);
-                        eF32 w0 = eRandomF(seed);
-                        eF32 w0Inv = 1.0f - w0;
-
-                        switch (m_emitterMode)
-                        {
-                            case ePSEM_FACES:
-								m_emitterMesh->getPointOnFace(f, eRandomF(), eRandomF(), p.dynamicEntity.position, p.dynamicEntity.velocity);
-                                break;
-
-                            case ePSEM_VERTICES:
-                                const eEmWedge &wedge = m_emitterMesh->getWedge(f);
-                                p.dynamicEntity.position = m_emitterMesh->getPosition(wedge.posIdx).pos;
-                                p.dynamicEntity.velocity = m_emitterMesh->getNormal(wedge.nrmIdx);
-                                break;
-                        }
-
-                        p.dynamicEntity.velocity.normalize();
-                        p.dynamicEntity.velocity *= initVel;
-                    }
-                        
-                    const eF32 lifeTime = m_lifeTime * (1.0f - eRandomF(seed) * m_randomization);
-                    p.timeConstant = (lifeTime <= 0.0f) ? 1.0f : 1.0f / lifeTime;
-                    p.timeToLive = 1.0f - timeRemaining * p.timeConstant;
-                    _moveParticles(&p, 1, timeNow - timeRemaining, timeRemaining);
-                    m_count++;
-                }
-            }
-        }
-        m_timer = timeNow;
-    }
+    const eU32 step = (eU32)(time/MAX_TIME_STEP);
+    const eF32 stepTime = (eF32)step*MAX_TIME_STEP;
+    const eF32 remainder = eMax(0.0f, time-stepTime);
 
-    // update bounding box
-    eVector3 min(eF32_INF);
-    eVector3 max(-eF32_INF);
+    _seek(step);
 
-    for (eU32 i=0; i<m_particles.size(); i++)
-    {
-        const Particle &p = m_particles[i];
-        min.minComponents(p.dynamicEntity.position);
-        max.maxComponents(p.dynamicEntity.position);
-    }
+    m_remainder = remainder;
+    m_emitted.count = 0;
+    m_emitted.emitCount = m_sim.emitCount;
+    m_emitted.step = m_sim.step;
 
-    m_bbox.setMinMax(min, max);
+    if (remainder > 0.0f)
+        _emitParticles(m_emitted, time, MAX_PARTICLES-m_sim.count);
+
+    m_valid = eTRUE;
+    _updateBoundingBox();
 }
 
+// drops the simulated state and all checkpoints.
+// has to be called when the emitter changed.
+void eParticleSystem::reset()
+{
+    _clearCheckpoints();
+    m_sim.count = 0;
+    m_sim.emitCount = 0;
+    m_sim.step = 0;
+    m_emitted.count = 0;
+    m_remainder = 0.0f;
+    m_valid = eFALSE;
+}
 
 void eParticleSystem::setEmitter(const eEditMesh *mesh, ePsEmitterMode mode)
 {
+    if (mesh != m_emitterMesh || mode != m_emitterMode)
+        reset();
+
     m_emitterMode = mode;
+    m_emitterMesh = mesh;
 
     if (mesh)
     {
-        m_emitterMesh = mesh;
         m_emitterEmitSurfaceArea = 0.0f;
 
         switch (mode)
@@ -215,17 +181,26 @@ void eParticleSystem::setStretch(eF32 stretch)
 
 void eParticleSystem::setRandomization(eF32 randomization)
 {
+    if (randomization != m_randomization)
+        reset();
+
     m_randomization = randomization;
 }
 
 void eParticleSystem::setEmission(eF32 emissionFreq, eF32 emissionVel)
 {
+    if (emissionFreq != m_emissionFreq || emissionVel != m_emissionVel)
+        reset();
+
     m_emissionFreq = emissionFreq;
     m_emissionVel = emissionVel;
 }
 
 void eParticleSystem::setLifeTime(eF32 lifeTime)
 {
+    if (lifeTime != m_lifeTime)
+        reset();
+
     m_lifeTime = lifeTime;
 }
 
@@ -239,6 +214,9 @@ void eParticleSystem::setMaterial(eBlendMode blendSrc, eBlendMode blendDst, eBle
 
 void eParticleSystem::setGravity(eF32 gravity, const eVector3 &gravityConst)
 {
+    if (gravity != m_gravity || gravityConst != *m_gravityConst)
+        reset();
+
     m_gravity = gravity;
     *m_gravityConst = gravityConst;
 }
@@ -250,108 +228,634 @@ void eParticleSystem::setPaths(const ePath4Sampler *colorPath, const ePath4Sampl
     m_rotPath = rotPath;
 }
 
-void eParticleSystem::_moveParticles(Particle *particles, eU32 count, eF32 nowTime, eF32 deltaTime)
+// brings the simulation to the given step. it
+// restarts from the latest checkpoint before
+// the step if that's closer than the current
+// state, so seeking to any time visited before
+// simulates at most one checkpoint interval.
+void eParticleSystem::_seek(eU32 step)
 {
-    const eF32 dtHalf = 0.5f * deltaTime;
-    const eF32 dtdtHalf = dtHalf * deltaTime;
+    if (m_checkpoints.isEmpty())
+    {
+        eASSERT(m_sim.step == 0);
+        _addCheckpoint();
+    }
 
-    for (eU32 i=0; i<count; i++)
+    const State &checkpoint = *m_checkpoints[eMin(step/m_checkpointSteps, m_checkpoints.size()-1)];
+
+    if (m_sim.step > step || m_sim.step < checkpoint.step)
+        _copyState(m_sim, checkpoint);
+
+    while (m_sim.step < step)
     {
-        // time step of verlet integration
-        Particle &p = particles[i];
+        _simulate(m_sim, (eF32)m_sim.step*MAX_TIME_STEP, MAX_TIME_STEP);
+        m_sim.step++;
+
+        if (m_sim.step == m_checkpoints.size()*m_checkpointSteps)
+            _addCheckpoint();
+    }
+}
+
+// when the checkpoints of all particle systems
+// exceed their memory budget, every second one
+// of this system is dropped and its checkpoint
+// interval is doubled
+void eParticleSystem::_addCheckpoint()
+{
+    State *checkpoint = new State;
+    _initState(*checkpoint);
+    _copyState(*checkpoint, m_sim);
+    m_checkpoints.append(checkpoint);
 
-        __m128 pos = _mm_loadu_ps(p.dynamicEntity.position);
-        const __m128 oldAccel = _calcAcceleration(p.mass, pos);
+    const eU32 mem = checkpoint->capacity*PS_COUNT*sizeof(eF32);
+    const eU32 memUsed = (eU32)eAtomicAdd(g_checkpointMem, mem);
+    m_checkpointMem += mem;
 
-        __m128 vel = _mm_loadu_ps(p.dynamicEntity.velocity);
-        pos = _mm_add_ps(pos, _mm_mul_ps(vel, _mm_set1_ps(deltaTime)));
-        pos = _mm_add_ps(pos, _mm_mul_ps(oldAccel, _mm_set1_ps(dtdtHalf)));
+    if (memUsed > MAX_CHECKPOINT_MEM && m_checkpoints.size() > 1)
+    {
+        for (eU32 i=1; i<m_checkpoints.size(); i+=2)
+        {
+            const eU32 freed = m_checkpoints[i]->capacity*PS_COUNT*sizeof(eF32);
+            eAtomicAdd(g_checkpointMem, -(eInt)freed);
+            m_checkpointMem -= freed;
+
+            _freeState(*m_checkpoints[i]);
+            eDelete(m_checkpoints[i]);
+        }
 
-        const __m128 newAccel = _calcAcceleration(p.mass, pos);
-        vel = _mm_add_ps(vel, _mm_mul_ps(_mm_set1_ps(dtHalf), _mm_add_ps(newAccel, oldAccel)));
+        const eU32 newCount = (m_checkpoints.size()+1)/2;
+        for (eU32 i=0; i<newCount; i++)
+            m_checkpoints[i] = m_checkpoints[i*2];
 
-        _mm_storeu_ps(&p.dynamicEntity.position.x, pos);
-        _mm_storeu_ps(&p.dynamicEntity.velocity.x, vel);
+        m_checkpoints.resize(newCount);
+        m_checkpointSteps *= 2;
     }
 }
 
-void eParticleSystem::_fillGeoBuffers(eGeometry *geo, ePtr param)
+void eParticleSystem::_clearCheckpoints()
 {
-    const eParticleSystem *psys = (eParticleSystem *)param;
+    for (eU32 i=0; i<m_checkpoints.size(); i++)
+    {
+        _freeState(*m_checkpoints[i]);
+        eDelete(m_checkpoints[i]);
+    }
 
-    if (psys->m_count == 0)
-        return;
+    eAtomicAdd(g_checkpointMem, -(eInt)m_checkpointMem);
+    m_checkpointMem = 0;
+    m_checkpoints.clear();
+    m_checkpointSteps = CHECKPOINT_STEPS;
+}
 
-    eVector3 right, up, view;
-    eGfx->getBillboardVectors(right, up, &view);
-    eMatrix4x4 mat = eGfx->getModelMatrix();
-    view = view*mat;
-    right = right*mat;
-    up = up*mat;
+// existing particles are aged, compacted and
+// moved chunk-wise in parallel. afterwards the
+// chunks are joined in chunk order, so the
+// result doesn't depend on the thread count.
+void eParticleSystem::_simulate(State &state, eF32 startTime, eF32 deltaTime) const
+{
+    const eU32 numChunks = (state.count+CHUNK_SIZE-1)/CHUNK_SIZE;
 
-    view.normalize();
-    right.normalize();
-    up.normalize();
+    SimJob job;
+    job.psys = this;
+    job.state = &state;
+    job.deltaTime = deltaTime;
+    job.first = 0;
+    job.count = state.count;
+    job.liveCounts.resize(numChunks);
 
-    eParticleVtx *vertices = nullptr;
-    eU32 vtxCount=0;
+    eJobPool::getDefault().run(_simulateChunk, &job, numChunks);
 
-    eGfx->beginLoadGeometry(geo, MAX_PARTICLES*4, (ePtr *)&vertices);
+    eU32 count = 0;
+    for (eU32 i=0; i<numChunks; i++)
     {
-        for (eU32 i=0; i<psys->m_count; i++)
+        const eU32 chunkStart = i*CHUNK_SIZE;
+        const eU32 liveCount = job.liveCounts[i];
+
+        if (count != chunkStart && liveCount)
         {
-            const Particle &p = psys->m_particles[i];
+            for (eU32 j=0; j<PS_COUNT; j++)
+                eMemMove(state.streams[j]+count, state.streams[j]+chunkStart, liveCount*sizeof(eF32));
+        }
 
-            eF32 ptime = 1.0f-p.timeToLive;
-            eColor col = eCOL_WHITE;
-            eF32 scale = (!psys->m_sizePath ? eSin(p.timeToLive*ePI) : psys->m_sizePath->evaluate(ptime).x);
+        count += liveCount;
+    }
 
-            if (psys->m_colorPath)
-            {
-                const eVector4 &res = psys->m_colorPath->evaluate(ptime);
-                col.r = eFtoL(res.x);
-                col.g = eFtoL(res.y);
-                col.b = eFtoL(res.z);
-                col.a = eFtoL(res.w);
-            }
-            else 
-                col.a = eFtoL(eClamp(1.0f, eSin(p.timeToLive*ePI), 1.0f)*255.0f);
+    state.count = count;
+    _emitParticles(state, startTime+deltaTime, MAX_PARTICLES-count);
+}
+
+void eParticleSystem::_simulateChunk(ePtr arg, eU32 index)
+{
+    SimJob &job = *(SimJob *)arg;
+    const eU32 first = job.first+index*CHUNK_SIZE;
+    const eU32 count = eMin((eU32)CHUNK_SIZE, job.count-index*CHUNK_SIZE);
+
+    // add life and delete unused particles
+    const eU32 liveCount = job.psys->_ageParticles(*job.state, first, count, job.deltaTime);
+
+    // calculate movement of particles
+    job.psys->_moveParticles(*job.state, first, liveCount, job.deltaTime);
+    job.liveCounts[index] = liveCount;
+}
+
+// the n-th particle is emitted at time n/freq
+// (counted from one). as all its random values
+// are drawn by its emission number, the new
+// particles are set up chunk-wise in parallel.
+void eParticleSystem::_emitParticles(State &state, eF32 endTime, eU32 maxCount) const
+{
+    if (m_emissionFreq <= 0.0f)
+        return;
+
+    // number of particles emitted until end time
+    eU32 emitted = (eU32)eMax(0.0f, endTime*m_emissionFreq);
+    while (emitted > state.emitCount && (eF32)emitted/m_emissionFreq > endTime)
+        emitted--;
+    while ((eF32)(emitted+1)/m_emissionFreq <= endTime)
+        emitted++;
+
+    if (emitted <= state.emitCount)
+        return;
+
+    // particles beyond the limit are skipped
+    const eU32 count = eMin(emitted-state.emitCount, maxCount);
+    _reserve(state, state.count+count);
+
+    SimJob job;
+    job.psys = this;
+    job.state = &state;
+    job.endTime = endTime;
+    job.first = state.count;
+    job.count = count;
+    job.emitIndex = state.emitCount;
+
+    eJobPool::getDefault().run(_emitChunk, &job, (count+CHUNK_SIZE-1)/CHUNK_SIZE);
+
+    state.count += count;
+    state.emitCount = emitted;
+}
+
+// new particles are moved for the rest of the
+// time step after their emission
+void eParticleSystem::_emitChunk(ePtr arg, eU32 index)
+{
+    SimJob &job = *(SimJob *)arg;
+    const eU32 start = index*CHUNK_SIZE;
+    const eU32 count = eMin((eU32)CHUNK_SIZE, job.count-start);
 
-            scale *= p.size;
-            eF32 rot = (!psys->m_rotPath ? 0.0f : psys->m_rotPath->evaluate(ptime).x);
+    eALIGN16 eF32 deltaTimes[CHUNK_SIZE];
+    eMemSet(deltaTimes, 0, sizeof(deltaTimes));
 
-            eVector3 r = right * scale;
-            eVector3 u = up * scale;
-            eVector3 pos2 = p.dynamicEntity.position;
+    for (eU32 i=0; i<count; i++)
+        deltaTimes[i] = job.psys->_emitParticle(*job.state, job.first+start+i, job.emitIndex+start+i, job.endTime);
+
+    job.psys->_moveParticles(*job.state, job.first+start, count, deltaTimes);
+}
+
+// sets up one particle and returns the time
+// left until end time since its emission
+eF32 eParticleSystem::_emitParticle(State &state, eU32 index, eU32 emitIndex, eF32 endTime) const
+{
+    const eU32 i = index;
+    const eU32 n = emitIndex;
+    const eF32 emitTime = (eF32)(n+1)/m_emissionFreq;
+    eVector3 pos, vel;
+
+    state.streams[PS_ROTATION][i] = 0;
+    state.streams[PS_SIZE][i] = 1.0f * (1.0f - particleRandom(n, RND_SIZE) * m_randomization);
+    state.streams[PS_MASS][i] = 1.0f * (1.0f - particleRandom(n, RND_MASS) * m_randomization);
+    eF32 initVel = m_emissionVel * (1.0f - particleRandom(n, RND_VEL) * m_randomization);
+
+    if (m_emitterMesh == nullptr || m_emitterEntities.size() == 0) {
+        pos.null();
+        vel = eVector3(particleRandom(n, RND_DIRX)*2.0f-1.0f, 1.0f, particleRandom(n, RND_DIRZ)*2.0f-1.0f)*initVel;
+    } else {
+        // lookup random entity with binary search
+        eF32 a = particleRandom(n, RND_AREA) * m_emitterEmitSurfaceArea;
+        eU32 l = 0;
+        eU32 r = m_emitterEntities.size();
+        while (l < r) {
+            eU32 m = (l + r) >> 1;
+            if (a < m_emitterEntities[m])   r = m;
+            else                            l = m+1;
+        }
+        eU32 f = eClamp((eU32)0, r , m_emitterEntities.size()-1);
+
+        switch (m_emitterMode)
+        {
+            case ePSEM_FACES:
+                m_emitterMesh->getPointOnFace(f, particleRandom(n, RND_FACEU), particleRandom(n, RND_FACEV), pos, vel);
+                break;
+
+            case ePSEM_VERTICES:
+                const eEmWedge &wedge = m_emitterMesh->getWedge(f);
+                pos = m_emitterMesh->getPosition(wedge.posIdx).pos;
+                vel = m_emitterMesh->getNormal(wedge.nrmIdx);
+                break;
+        }
+
+        vel.normalize();
+        vel *= initVel;
+    }
+
+    state.streams[PS_POSX][i] = pos.x;
+    state.streams[PS_POSY][i] = pos.y;
+    state.streams[PS_POSZ][i] = pos.z;
+    state.streams[PS_VELX][i] = vel.x;
+    state.streams[PS_VELY][i] = vel.y;
+    state.streams[PS_VELZ][i] = vel.z;
+
+    const eF32 timeRemaining = endTime-emitTime;
+    const eF32 lifeTime = m_lifeTime * (1.0f - particleRandom(n, RND_LIFE) * m_randomization);
+    const eF32 timeConst = (lifeTime <= 0.0f) ? 1.0f : 1.0f / lifeTime;
+    state.streams[PS_TIMECONST][i] = timeConst;
+    state.streams[PS_TTL][i] = 1.0f - timeRemaining * timeConst;
+    return timeRemaining;
+}
+
+void eParticleSystem::_initState(State &state)
+{
+    eMemSet(&state, 0, sizeof(state));
+}
+
+void eParticleSystem::_freeState(State &state)
+{
+    eFreeAligned(state.streams[0]);
+    _initState(state);
+}
+
+void eParticleSystem::_copyState(State &dst, const State &src)
+{
+    dst.count = 0;
+    _reserve(dst, src.count);
+
+    for (eU32 i=0; i<PS_COUNT; i++)
+        eMemCopy(dst.streams[i], src.streams[i], src.count*sizeof(eF32));
+
+    dst.count = src.count;
+    dst.emitCount = src.emitCount;
+    dst.step = src.step;
+}
 
-            if(psys->m_stretchAmount != 0.0f) 
+// all streams live in one allocation. the capacity
+// is kept a multiple of four plus four padding
+// elements, so the kernels can always process
+// whole groups of four (lanes beyond the live
+// count are scratch and never read back).
+void eParticleSystem::_reserve(State &state, eU32 count)
+{
+    eASSERT(count <= MAX_PARTICLES);
+
+    if (count+4 <= state.capacity)
+        return;
+
+    eU32 capacity = eMin(eMax(count, state.capacity*2), MAX_PARTICLES);
+    capacity = ((capacity+3)&~3)+4;
+
+    eF32 *oldData = state.streams[0];
+    eF32 *data = (eF32 *)eAllocAlignedAndZero(capacity*PS_COUNT*sizeof(eF32), 16);
+
+    for (eU32 i=0; i<PS_COUNT; i++)
+    {
+        if (state.count)
+            eMemCopy(data+i*capacity, state.streams[i], state.count*sizeof(eF32));
+
+        state.streams[i] = data+i*capacity;
+    }
+
+    eFreeAligned(oldData);
+    state.capacity = capacity;
+}
+
+// ages the particles in the given range four at
+// a time and moves the ones still alive to the
+// range's front, keeping their order. groups
+// without dead particles are moved as a whole.
+// returns the number of particles alive.
+eU32 eParticleSystem::_ageParticles(State &state, eU32 first, eU32 count, eF32 deltaTime) const
+{
+    eASSERT(first%4 == 0);
+
+    const eF32x4 dt = eSimdSetAll(deltaTime);
+    const eF32x4 zero = eSimdZero();
+    eF32 *ttl = state.streams[PS_TTL];
+    const eF32 *timeConst = state.streams[PS_TIMECONST];
+    const eU32 end = first+count;
+    eU32 dst = first;
+
+    for (eU32 i=first; i<end; i+=4)
+    {
+        const eF32x4 t = eSimdNfma(eSimdLoadAligned(ttl+i), eSimdLoadAligned(timeConst+i), dt);
+        eSimdStoreAligned(t, ttl+i);
+
+        eU32 alive = _mm_movemask_ps(_mm_cmpge_ps(t, zero));
+        if (end-i < 4)
+            alive &= (1<<(end-i))-1;
+
+        if (alive == 0xf)
+        {
+            if (dst != i)
             {
-                eVector3 flyDir = p.dynamicEntity.velocity;
-                const eVector3 velNorm = p.dynamicEntity.velocity.normalized();
-                const eF32 rightCos = view*velNorm;
-                const eQuat qr(view, rot);
-                const eQuat qr90(view, -eHALFPI);
-                r = -((velNorm * qr90)*qr) * scale;
-                u = (velNorm * qr) * scale;
-                pos2 = p.dynamicEntity.position+p.dynamicEntity.velocity*psys->m_stretchAmount;
+                for (eU32 j=0; j<PS_COUNT; j++)
+                    eSimdStore(eSimdLoadAligned(state.streams[j]+i), state.streams[j]+dst);
             }
-            else if(rot != 0)
+
+            dst += 4;
+        }
+        else
+        {
+            for (eU32 k=i; alive; alive>>=1, k++)
             {
-                r = (r * eQuat(view, rot));
-                u = (u * eQuat(view, rot));
+                if (alive&1)
+                {
+                    for (eU32 j=0; j<PS_COUNT; j++)
+                        state.streams[j][dst] = state.streams[j][k];
+
+                    dst++;
+                }
             }
+        }
+    }
+
+    return dst-first;
+}
+
+// time step of verlet integration for four
+// particles starting at the given index
+eFORCEINLINE void eParticleSystem::_integrate(State &state, eU32 index, const eF32x4 &deltaTime) const
+{
+    const eU32 i = index;
+    const eF32x4 dtHalf = eSimdMulScalar(deltaTime, 0.5f);
+    const eF32x4 dtdtHalf = eSimdMul(dtHalf, deltaTime);
+
+    eF32x4 posX = eSimdLoad(state.streams[PS_POSX]+i);
+    eF32x4 posY = eSimdLoad(state.streams[PS_POSY]+i);
+    eF32x4 posZ = eSimdLoad(state.streams[PS_POSZ]+i);
+    eF32x4 velX = eSimdLoad(state.streams[PS_VELX]+i);
+    eF32x4 velY = eSimdLoad(state.streams[PS_VELY]+i);
+    eF32x4 velZ = eSimdLoad(state.streams[PS_VELZ]+i);
+    const eF32x4 mass = eSimdLoad(state.streams[PS_MASS]+i);
+
+    eF32x4 oldAccX, oldAccY, oldAccZ;
+    _calcAcceleration(mass, posX, posY, posZ, oldAccX, oldAccY, oldAccZ);
+
+    posX = eSimdFma(eSimdFma(posX, velX, deltaTime), oldAccX, dtdtHalf);
+    posY = eSimdFma(eSimdFma(posY, velY, deltaTime), oldAccY, dtdtHalf);
+    posZ = eSimdFma(eSimdFma(posZ, velZ, deltaTime), oldAccZ, dtdtHalf);
+
+    eF32x4 newAccX, newAccY, newAccZ;
+    _calcAcceleration(mass, posX, posY, posZ, newAccX, newAccY, newAccZ);
+
+    velX = eSimdFma(velX, dtHalf, eSimdAdd(newAccX, oldAccX));
+    velY = eSimdFma(velY, dtHalf, eSimdAdd(newAccY, oldAccY));
+    velZ = eSimdFma(velZ, dtHalf, eSimdAdd(newAccZ, oldAccZ));
+
+    eSimdStore(posX, state.streams[PS_POSX]+i);
+    eSimdStore(posY, state.streams[PS_POSY]+i);
+    eSimdStore(posZ, state.streams[PS_POSZ]+i);
+    eSimdStore(velX, state.streams[PS_VELX]+i);
+    eSimdStore(velY, state.streams[PS_VELY]+i);
+    eSimdStore(velZ, state.streams[PS_VELZ]+i);
+}
+
+// advances one particle by a time step without
+// writing it back. same results as aging and
+// integrating it, as the acceleration doesn't
+// depend on the position. returns if the
+// particle is still alive.
+eBool eParticleSystem::_advanceParticle(const State &state, eU32 index, eF32 deltaTime, eF32 &ttl, eVector3 &pos, eVector3 &vel) const
+{
+    const eU32 i = index;
+    const eF32 dtHalf = deltaTime*0.5f;
+    const eF32 dtdtHalf = dtHalf*deltaTime;
+    const eVector3 &acc = *m_gravityConst;
+
+    ttl = state.streams[PS_TTL][i]-state.streams[PS_TIMECONST][i]*deltaTime;
+    pos.set(state.streams[PS_POSX][i], state.streams[PS_POSY][i], state.streams[PS_POSZ][i]);
+    vel.set(state.streams[PS_VELX][i], state.streams[PS_VELY][i], state.streams[PS_VELZ][i]);
+    pos = (pos+vel*deltaTime)+acc*dtdtHalf;
+    vel = vel+(acc+acc)*dtHalf;
+    return (ttl >= 0.0f);
+}
+
+void eParticleSystem::_moveParticles(State &state, eU32 first, eU32 count, eF32 deltaTime) const
+{
+    eASSERT(first+((count+3)&~3) <= state.capacity);
+    const eF32x4 dt = eSimdSetAll(deltaTime);
+
+    for (eU32 i=first; i<first+count; i+=4)
+        _integrate(state, i, dt);
+}
+
+// moves each particle by its own time step. the
+// time steps array has to be padded to four.
+void eParticleSystem::_moveParticles(State &state, eU32 first, eU32 count, const eF32 *deltaTimes) const
+{
+    eASSERT(first+((count+3)&~3) <= state.capacity);
+
+    for (eU32 i=0; i<count; i+=4)
+        _integrate(state, first+i, eSimdLoad(deltaTimes+i));
+}
+
+// reduces the positions of the live particles
+// four lanes per axis, then combines the lanes.
+// the simulated particles are advanced by the
+// remainder on the fly, dying ones are masked.
+void eParticleSystem::_updateBoundingBox()
+{
+    m_bbox.clear();
+
+    if (!m_sim.count && !m_emitted.count)
+        return;
+
+    const eF32x4 inf = eSimdSetAll(eF32_INF);
+    const eF32x4 negInf = eSimdSetAll(-eF32_INF);
+    eF32x4 minX = inf;
+    eF32x4 minY = minX;
+    eF32x4 minZ = minX;
+    eF32x4 maxX = negInf;
+    eF32x4 maxY = maxX;
+    eF32x4 maxZ = maxX;
+
+    const eF32x4 dt = eSimdSetAll(m_remainder);
+    const eF32x4 dtdtHalf = eSimdSetAll(m_remainder*m_remainder*0.5f);
+    const eF32x4 accX = eSimdSetAll(m_gravityConst->x);
+    const eF32x4 accY = eSimdSetAll(m_gravityConst->y);
+    const eF32x4 accZ = eSimdSetAll(m_gravityConst->z);
+    const eF32x4 zero = eSimdZero();
+    eF32 * const *streams = m_sim.streams;
+
+    const eU32 count4 = m_sim.count&~3;
+    for (eU32 i=0; i<count4; i+=4)
+    {
+        const eF32x4 ttl = eSimdNfma(eSimdLoadAligned(streams[PS_TTL]+i), eSimdLoadAligned(streams[PS_TIMECONST]+i), dt);
+        const eF32x4 alive = _mm_cmpge_ps(ttl, zero);
+
+        const eF32x4 posX = eSimdFma(eSimdFma(eSimdLoadAligned(streams[PS_POSX]+i), eSimdLoadAligned(streams[PS_VELX]+i), dt), accX, dtdtHalf);
+        const eF32x4 posY = eSimdFma(eSimdFma(eSimdLoadAligned(streams[PS_POSY]+i), eSimdLoadAligned(streams[PS_VELY]+i), dt), accY, dtdtHalf);
+        const eF32x4 posZ = eSimdFma(eSimdFma(eSimdLoadAligned(streams[PS_POSZ]+i), eSimdLoadAligned(streams[PS_VELZ]+i), dt), accZ, dtdtHalf);
+
+        minX = eSimdMin(minX, _mm_or_ps(_mm_and_ps(alive, posX), _mm_andnot_ps(alive, inf)));
+        minY = eSimdMin(minY, _mm_or_ps(_mm_and_ps(alive, posY), _mm_andnot_ps(alive, inf)));
+        minZ = eSimdMin(minZ, _mm_or_ps(_mm_and_ps(alive, posZ), _mm_andnot_ps(alive, inf)));
+        maxX = eSimdMax(maxX, _mm_or_ps(_mm_and_ps(alive, posX), _mm_andnot_ps(alive, negInf)));
+        maxY = eSimdMax(maxY, _mm_or_ps(_mm_and_ps(alive, posY), _mm_andnot_ps(alive, negInf)));
+        maxZ = eSimdMax(maxZ, _mm_or_ps(_mm_and_ps(alive, posZ), _mm_andnot_ps(alive, negInf)));
+    }
+
+    eALIGN16 eF32 lanes[6][4];
+    eSimdStoreAligned(minX, lanes[0]);
+    eSimdStoreAligned(minY, lanes[1]);
+    eSimdStoreAligned(minZ, lanes[2]);
+    eSimdStoreAligned(maxX, lanes[3]);
+    eSimdStoreAligned(maxY, lanes[4]);
+    eSimdStoreAligned(maxZ, lanes[5]);
+
+    eVector3 min(eF32_INF);
+    eVector3 max(-eF32_INF);
+
+    for (eU32 i=0; i<4; i++)
+    {
+        min.minComponents(eVector3(lanes[0][i], lanes[1][i], lanes[2][i]));
+        max.maxComponents(eVector3(lanes[3][i], lanes[4][i], lanes[5][i]));
+    }
+
+    eF32 ttl;
+    eVector3 pos, vel;
+
+    for (eU32 i=count4; i<m_sim.count; i++)
+    {
+        if (_advanceParticle(m_sim, i, m_remainder, ttl, pos, vel))
+        {
+            min.minComponents(pos);
+            max.maxComponents(pos);
+        }
+    }
+
+    for (eU32 i=0; i<m_emitted.count; i++)
+    {
+        _advanceParticle(m_emitted, i, 0.0f, ttl, pos, vel);
+        min.minComponents(pos);
+        max.maxComponents(pos);
+    }
+
+    if (min.x <= max.x)
+        m_bbox.setMinMax(min, max);
+}
+
+void eParticleSystem::_fillGeoBuffers(eGeometry *geo, ePtr param)
+{
+    const eParticleSystem *psys = (eParticleSystem *)param;
 
-            const eVector3 mid = (p.dynamicEntity.position + pos2) * 0.5f;
+    const eU32 count = psys->m_sim.count+psys->m_emitted.count;
 
-            vertices[vtxCount+0].set(pos2                     + u, eVector2(0.0f, 0.0f), col);
-            vertices[vtxCount+1].set(mid                      + r, eVector2(1.0f, 0.0f), col);
-            vertices[vtxCount+2].set(p.dynamicEntity.position - u, eVector2(1.0f, 1.0f), col);
-            vertices[vtxCount+3].set(mid                      - r, eVector2(0.0f, 1.0f), col);
+    if (!psys->m_valid || count == 0)
+        return;
+
+    FillJob job;
+    job.psys = psys;
+    job.vertices = nullptr;
+
+    eGfx->getBillboardVectors(job.right, job.up, &job.view);
+    eMatrix4x4 mat = eGfx->getModelMatrix();
+    job.view = job.view*mat;
+    job.right = job.right*mat;
+    job.up = job.up*mat;
+
+    job.view.normalize();
+    job.right.normalize();
+    job.up.normalize();
+
+    // each particle writes its own four vertices,
+    // so the chunks can be filled in parallel
+    eGfx->beginLoadGeometry(geo, count*4, (ePtr *)&job.vertices);
+    eJobPool::getDefault().run(_fillChunk, &job, (count+CHUNK_SIZE-1)/CHUNK_SIZE);
+    eGfx->endLoadGeometry(geo, count*4);
+}
+
+void eParticleSystem::_fillChunk(ePtr arg, eU32 index)
+{
+    const FillJob &job = *(FillJob *)arg;
+    const eParticleSystem *psys = job.psys;
+    const State &sim = psys->m_sim;
+    const State &emitted = psys->m_emitted;
+    const eVector3 &right = job.right;
+    const eVector3 &up = job.up;
+    const eVector3 &view = job.view;
+
+    const eU32 start = index*CHUNK_SIZE;
+    const eU32 end = eMin(start+CHUNK_SIZE, sim.count+emitted.count);
+    eParticleVtx *vertices = job.vertices;
+    eU32 vtxCount = start*4;
+
+    for (eU32 i=start; i<end; i++)
+    {
+        // simulated particles are advanced by the
+        // remainder, emitted ones are up to date
+        const eBool simulated = (i < sim.count);
+        const State &state = (simulated ? sim : emitted);
+        const eU32 j = (simulated ? i : i-sim.count);
+
+        eF32 timeToLive;
+        eVector3 position, velocity;
 
+        if (!psys->_advanceParticle(state, j, (simulated ? psys->m_remainder : 0.0f), timeToLive, position, velocity))
+        {
+            // died during the remainder
+            const eColor none(0, 0, 0, 0);
+            vertices[vtxCount+0].set(position, eVector2(0.0f, 0.0f), none);
+            vertices[vtxCount+1].set(position, eVector2(1.0f, 0.0f), none);
+            vertices[vtxCount+2].set(position, eVector2(1.0f, 1.0f), none);
+            vertices[vtxCount+3].set(position, eVector2(0.0f, 1.0f), none);
             vtxCount += 4;
+            continue;
+        }
+
+        eF32 ptime = 1.0f-timeToLive;
+        eColor col = eCOL_WHITE;
+        eF32 scale = (!psys->m_sizePath ? eSin(timeToLive*ePI) : psys->m_sizePath->evaluate(ptime).x);
+
+        if (psys->m_colorPath)
+        {
+            const eVector4 &res = psys->m_colorPath->evaluate(ptime);
+            col.r = eFtoL(res.x);
+            col.g = eFtoL(res.y);
+            col.b = eFtoL(res.z);
+            col.a = eFtoL(res.w);
+        }
+        else 
+            col.a = eFtoL(eClamp(1.0f, eSin(timeToLive*ePI), 1.0f)*255.0f);
+
+        scale *= state.streams[PS_SIZE][j];
+        eF32 rot = (!psys->m_rotPath ? 0.0f : psys->m_rotPath->evaluate(ptime).x);
+
+        eVector3 r = right * scale;
+        eVector3 u = up * scale;
+        eVector3 pos2 = position;
+
+        if(psys->m_stretchAmount != 0.0f) 
+        {
+            const eVector3 velNorm = velocity.normalized();
+            const eQuat qr(view, rot);
+            const eQuat qr90(view, -eHALFPI);
+            r = -((velNorm * qr90)*qr) * scale;
+            u = (velNorm * qr) * scale;
+            pos2 = position+velocity*psys->m_stretchAmount;
+        }
+        else if(rot != 0)
+        {
+            r = (r * eQuat(view, rot));
+            u = (u * eQuat(view, rot));
         }
+
+        const eVector3 mid = (position + pos2) * 0.5f;
+
+        vertices[vtxCount+0].set(pos2     + u, eVector2(0.0f, 0.0f), col);
+        vertices[vtxCount+1].set(mid      + r, eVector2(1.0f, 0.0f), col);
+        vertices[vtxCount+2].set(position - u, eVector2(1.0f, 1.0f), col);
+        vertices[vtxCount+3].set(mid      - r, eVector2(0.0f, 1.0f), col);
+
+        vtxCount += 4;
     }
-    eGfx->endLoadGeometry(geo, vtxCount);
 }
 
 // implementation of particle system instance
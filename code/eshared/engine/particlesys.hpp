@@ -26,20 +26,60 @@ class eParticleSystem
     friend class eParticleSysInst;
 
 private:
-    struct DynamicEntity
+    // particles are stored as structure of arrays
+    // (one 16 byte aligned stream per attribute),
+    // so the kernels process four of them at once
+    enum ParticleStream
     {
-        eVector3            position; // [m]
-        eVector3            velocity; // [m/s]
+        PS_POSX,            // [m]
+        PS_POSY,
+        PS_POSZ,
+        PS_VELX,            // [m/s]
+        PS_VELY,
+        PS_VELZ,
+        PS_TTL,             // (0..1]
+        PS_TIMECONST,       // 1/ttl_max
+        PS_ROTATION,
+        PS_MASS,
+        PS_SIZE,
+        PS_COUNT
     };
 
-    struct Particle
+    // complete simulation state after a number of
+    // fixed time steps. used for the simulation
+    // itself and for the checkpoints seeking
+    // restarts from.
+    struct State
     {
-        DynamicEntity       dynamicEntity;
-        eF32                timeToLive;   // (0..1]
-        eF32                timeConstant; // 1/ttl_max
-        eF32                rotation;
-        eF32                mass;
-        eF32                size;
+        eF32 *              streams[PS_COUNT];
+        eU32                capacity;
+        eU32                count;
+        eU32                emitCount;  // particles emitted so far
+        eU32                step;
+    };
+
+    // parameters of the parallel passes. the
+    // particles are split into chunks of
+    // CHUNK_SIZE and each chunk is one job.
+    struct SimJob
+    {
+        const eParticleSystem * psys;
+        State *             state;
+        eF32                deltaTime;
+        eF32                endTime;
+        eU32                first;      // first particle of chunk 0
+        eU32                count;
+        eU32                emitIndex;  // emission number of first particle
+        eArray<eU32>        liveCounts;
+    };
+
+    struct FillJob
+    {
+        const eParticleSystem * psys;
+        eParticleVtx *      vertices;
+        eVector3            right;
+        eVector3            up;
+        eVector3            view;
     };
 
 public:
@@ -47,6 +87,7 @@ public:
     ~eParticleSystem();
 
     void                    update(eF32 time);
+    void                    reset();
 
     void                    setEmitter(const eEditMesh *mesh, ePsEmitterMode mode);
     void                    setStretch(eF32 stretch);
@@ -58,17 +99,43 @@ public:
     void                    setPaths(const ePath4Sampler *colorPath, const ePath4Sampler *sizePath, const ePath4Sampler *rotPath);
 
 private:
-    void                    _moveParticles(Particle *particles, eU32 count, eF32 nowTime, eF32 deltaTime);
+    void                    _simulate(State &state, eF32 startTime, eF32 deltaTime) const;
+    void                    _emitParticles(State &state, eF32 endTime, eU32 maxCount) const;
+    eF32                    _emitParticle(State &state, eU32 index, eU32 emitIndex, eF32 endTime) const;
+    eU32                    _ageParticles(State &state, eU32 first, eU32 count, eF32 deltaTime) const;
+    void                    _moveParticles(State &state, eU32 first, eU32 count, eF32 deltaTime) const;
+    void                    _moveParticles(State &state, eU32 first, eU32 count, const eF32 *deltaTimes) const;
+    void                    _integrate(State &state, eU32 index, const eF32x4 &deltaTime) const;
+    eBool                   _advanceParticle(const State &state, eU32 index, eF32 deltaTime, eF32 &ttl, eVector3 &pos, eVector3 &vel) const;
+    void                    _seek(eU32 step);
+    void                    _addCheckpoint();
+    void                    _clearCheckpoints();
+    void                    _updateBoundingBox();
     static void             _fillGeoBuffers(eGeometry *geo, ePtr param);
+    static void             _simulateChunk(ePtr arg, eU32 index);
+    static void             _emitChunk(ePtr arg, eU32 index);
+    static void             _fillChunk(ePtr arg, eU32 index);
 
 private:
-    eFORCEINLINE __m128 _calcAcceleration(eF32 mass, const __m128 pos) const
+    eFORCEINLINE void _calcAcceleration(const eF32x4 &mass, const eF32x4 &posX, const eF32x4 &posY, const eF32x4 &posZ,
+                                        eF32x4 &accX, eF32x4 &accY, eF32x4 &accZ) const
     {
-        return _mm_load_ps(&m_gravityConst->x);
+        accX = eSimdSetAll(m_gravityConst->x);
+        accY = eSimdSetAll(m_gravityConst->y);
+        accZ = eSimdSetAll(m_gravityConst->z);
     }
 
 private:
-    static const eU32       MAX_PARTICLES = 20000;
+    static void             _initState(State &state);
+    static void             _freeState(State &state);
+    static void             _copyState(State &dst, const State &src);
+    static void             _reserve(State &state, eU32 count);
+
+private:
+    static const eU32       MAX_PARTICLES = 512*1024;
+    static const eU32       CHECKPOINT_STEPS = 30;
+    static const eU32       CHUNK_SIZE = 4096;
+    static const eU32       MAX_CHECKPOINT_MEM = 256*1024*1024; // of all particle systems
     static const eF32       MAX_TIME_STEP;
 
 private:
@@ -83,13 +150,16 @@ private:
 
     eGeometry *             m_geo;
     eTexture2d *            m_tex;
-    eArray<Particle>        m_particles;
     eAABB                   m_bbox;
 
+    State                   m_sim;
+    State                   m_emitted;      // emitted during the remainder
+    eF32                    m_remainder;    // time displayed beyond m_sim
+    eBool                   m_valid;
+    eArray<State *>         m_checkpoints;
+    eU32                    m_checkpointSteps;
+    eU32                    m_checkpointMem;
     eF32                    m_lastTime;
-    eF32                    m_timer;
-    eF32                    m_emitTime;
-    eU32                    m_count;
 
     const ePath4Sampler *    m_sizePath;
     const ePath4Sampler *    m_colorPath;
@@ -165,6 +165,7 @@ eIOperator::eIOperator() :
     m_changed(eTRUE),
     m_visited(eFALSE),
     m_visited2(eFALSE),
+    m_jobIndex(0),
     m_subTime(0.0f)
 {
     // generate a new random ID
@@ -193,7 +194,6 @@ eOpProcessResult eIOperator::process(eF32 time, eOpCallback callback, ePtr param
 
     eIOpPtrArray stackOps;
     eOpProcessResult res = eOPR_NOCHANGES;
-    eU32 opCount = 0;
 
     stackOps.reserve(eDemoData::getTotalOpCount());
     getOpsInStack(stackOps);
@@ -217,7 +217,7 @@ eOpProcessResult eIOperator::process(eF32 time, eOpCallback callback, ePtr param
     if (callback && !callback(0, stackOps.size(), param))
         res = eOPR_CANCELED;
 
-    _processIntern(time, callback, param, opCount, stackOps.size(), res);
+    _processStack(time, callback, param, stackOps.size(), res);
 
     for (eU32 i=0; i<stackOps.size(); i++)
     {
@@ -234,15 +234,136 @@ eOpProcessResult eIOperator::process(eF32 time, eOpCallback callback, ePtr param
     return res;
 }
 
-void eIOperator::_processIntern(eF32 time, eOpCallback callback, ePtr param, eU32 &opCount, eU32 opsTotal, eOpProcessResult &res)
+// operator stacks are processed as a dependency
+// counted job graph. all ops whose inputs are done
+// form the next wave. CPU-only ops of a wave run
+// in parallel on the job pool, all others as well
+// as parameter animation, progress callbacks and
+// memory management stay on the calling thread.
+struct eOpJob
+{
+    eIOperator *                op;
+    eF32                        time;
+    eU32                        numPending; // inputs not processed yet
+    eU32                        depStart;   // range of dependent jobs
+    eU32                        depEnd;
+};
+
+void eIOperator::_processStack(eF32 time, eOpCallback callback, ePtr param, eU32 opsTotal, eOpProcessResult &res)
+{
+    // collect jobs in the order of the depth first
+    // traversal, which determines the time each op
+    // is processed with (sub-times accumulate)
+    eArray<eOpJob> jobs;
+    jobs.reserve(opsTotal);
+    _addJobs(time, jobs);
+
+    // link jobs with their dependent jobs
+    eArray<eU32> depCounts(jobs.size());
+
+    for (eU32 i=0; i<jobs.size(); i++)
+    {
+        eOpJob &job = jobs[i];
+        job.numPending = 0;
+
+        for (eU32 j=0; j<job.op->m_inputOps.size(); j++)
+        {
+            const eU32 index = job.op->m_inputOps[j]->m_jobIndex;
+
+            // inputs not part of the job list were
+            // processed by an enclosing process() call
+            if (index < jobs.size() && jobs[index].op == job.op->m_inputOps[j])
+            {
+                depCounts[index]++;
+                job.numPending++;
+            }
+        }
+    }
+
+    eU32 numDeps = 0;
+
+    for (eU32 i=0; i<jobs.size(); i++)
+    {
+        jobs[i].depStart = jobs[i].depEnd = numDeps;
+        numDeps += depCounts[i];
+    }
+
+    eArray<eU32> deps(numDeps);
+
+    for (eU32 i=0; i<jobs.size(); i++)
+    {
+        for (eU32 j=0; j<jobs[i].op->m_inputOps.size(); j++)
+        {
+            const eU32 index = jobs[i].op->m_inputOps[j]->m_jobIndex;
+            if (index < jobs.size() && jobs[index].op == jobs[i].op->m_inputOps[j])
+                deps[jobs[index].depEnd++] = i;
+        }
+    }
+
+    // process jobs wave by wave
+    eArray<eU32> ready, nextReady;
+    eIOpPtrArray parallelOps;
+    eU32 opCount = 0;
+
+    for (eU32 i=0; i<jobs.size(); i++)
+        if (!jobs[i].numPending)
+            ready.append(i);
+
+    while (!ready.isEmpty() && res != eOPR_CANCELED)
+    {
+        // scripts may change the op and its outputs,
+        // so animate before deciding what to execute
+        parallelOps.clear();
+
+        for (eU32 i=0; i<ready.size(); i++)
+        {
+            eIOperator *op = jobs[ready[i]].op;
+            op->_animateParameters(jobs[ready[i]].time);
+
+            if (op->m_changed)
+            {
+                res = eOPR_CHANGES;
+
+                if (op->_canExecuteParallel())
+                    parallelOps.append(op);
+                else
+                {
+                    op->_preExecute();
+                    op->_callExecute();
+                }
+            }
+        }
+
+        eJobPool::getDefault().run(_executeJob, &parallelOps, parallelOps.size());
+
+        // update status information and release
+        // dependent ops in the order ops got ready
+        nextReady.clear();
+
+        for (eU32 i=0; i<ready.size(); i++)
+        {
+            const eOpJob &job = jobs[ready[i]];
+
+            if (callback && !callback(++opCount, opsTotal, param))
+                res = eOPR_CANCELED;
+
+            job.op->_postExecute();
+
+            for (eU32 j=job.depStart; j<job.depEnd; j++)
+                if (--jobs[deps[j]].numPending == 0)
+                    nextReady.append(deps[j]);
+        }
+
+        ready = nextReady;
+    }
+}
+
+void eIOperator::_addJobs(eF32 time, eArray<eOpJob> &jobs)
 {
 #ifdef ePLAYER
     eASSERT((m_metaInfos->type == ePLAYER_OPTYPE_eDemoOp) || (m_numVisits < m_outputOps.size()));
 #endif
 
-	//if (m_id == 106 && m_numVisits > 0)
-	//	_asm int 3;
-
     if (!m_visited)
     {
         // sequencer operators have a subtract time set
@@ -250,54 +371,64 @@ void eIOperator::_processIntern(eF32 time, eOpCallback callback, ePtr param, eU3
         // sequencer entry times
         time -= m_subTime;
 
-        // recursively process input opereators
         m_visited = eTRUE;
         for (eU32 i=0; i<m_inputOps.size(); i++)
-        {
-            m_inputOps[i]->_processIntern(time, callback, param, opCount, opsTotal, res);
-            if (res == eOPR_CANCELED)
-                return;
-        }
+            m_inputOps[i]->_addJobs(time, jobs);
 
-        // update operator and reexecute if dirty
-        _animateParameters(time);
-        if (m_changed)
-        {
-            _preExecute();
-            _callExecute();
-            res = eOPR_CHANGES;
-        }
+        m_jobIndex = jobs.size();
+        eOpJob &job = jobs.append(eOpJob());
+        job.op = this;
+        job.time = time;
+    }
+}
 
-        // update status information
-        opCount++;
-        if (callback && !callback(opCount, opsTotal, param))
-            res = eOPR_CANCELED;
+// mesh and path operators only work on the CPU.
+// ops reading back bitmaps from the GPU and all
+// other classes (creating GPU resources or nesting
+// process() calls) are executed on the main thread,
+// unless an operator overrides this.
+eBool eIOperator::_canExecuteParallel() const
+{
+    if (m_metaInfos->output != eOC_MESH && m_metaInfos->output != eOC_PATH)
+        return eFALSE;
 
-        // perform operator memory management
+    for (eU32 i=0; i<m_inputOps.size(); i++)
+        if (m_inputOps[i]->getResultClass() == eOC_BMP)
+            return eFALSE;
+
+    return eTRUE;
+}
+
+void eIOperator::_executeJob(ePtr arg, eU32 index)
+{
+    eIOperator *op = (*(eIOpPtrArray *)arg)[index];
+    op->_preExecute();
+    op->_callExecute();
+}
+
+// perform operator memory management
+void eIOperator::_postExecute()
+{
 #ifdef eEDITOR
-        m_memMgr.touch(this);
-        m_memMgr.tidyUp();
+    m_memMgr.touch(this);
+    m_memMgr.tidyUp();
 #else
-        // in player free all operators which won't be referenced
-        // anymore and which are not part of an animated stack
-        for (eU32 i=0; i<m_inputOps.size(); i++)
-        {
-            eIOperator *op = m_inputOps[i];
-            op->m_numVisits++; // important: postpone increment to caller!
-/*
-			if (op->m_id == 106)
-				__asm int 3;
-*/
-            // is any output animiated?
-            eBool animed = eFALSE;
-            for (eU32 j=0; j<op->m_outputOps.size(); j++)
-                animed |= op->m_outputOps[j]->isAnimated();
-
-            if (op->m_numVisits == op->m_outputOps.size() && !animed)
-                op->freeResult(); // do not set to changed here (no reexecute wanted!)
-        }
-#endif
+    // in player free all operators which won't be referenced
+    // anymore and which are not part of an animated stack
+    for (eU32 i=0; i<m_inputOps.size(); i++)
+    {
+        eIOperator *op = m_inputOps[i];
+        op->m_numVisits++; // important: postpone increment to caller!
+
+        // is any output animiated?
+        eBool animed = eFALSE;
+        for (eU32 j=0; j<op->m_outputOps.size(); j++)
+            animed |= op->m_outputOps[j]->isAnimated();
+
+        if (op->m_numVisits == op->m_outputOps.size() && !animed)
+            op->freeResult(); // do not set to changed here (no reexecute wanted!)
     }
+#endif
 }
 
 eU32 eIOperator::getResultSize() const
@@ -649,6 +780,13 @@ eBool eIOperator::getBlocked() const
     return m_blocked;
 }
 
+// if the operator would be executed on the job
+// pool when processing its stack
+eBool eIOperator::getExecuteParallel() const
+{
+    return _canExecuteParallel();
+}
+
 const ePoint & eIOperator::getPosition() const
 {
     return m_pos;
@@ -18,6 +18,7 @@
 class eIOperator;
 class eIBitmapOp;
 struct eOpMetaInfos;
+struct eOpJob;
 
 typedef eArray<eIOperator *> eIOpPtrArray;
 typedef eArray<const eIOperator *> eIOpConstPtrArray;
@@ -198,6 +199,7 @@ public:
     void                        setHidden(eBool hidden);
 
     eBool                       getBlocked() const;
+    eBool                       getExecuteParallel() const;
     const ePoint &              getPosition() const;
     const eString &             getUserName() const;
     eBool                       getBypassed() const;
@@ -216,13 +218,17 @@ public:
 
 protected:
     virtual void                _preExecute();
+    virtual eBool               _canExecuteParallel() const;
     void                        _initialize();
     void                        _setupParams();
     void                        _deinitialize();
     void                        _callExecute();
 
 private:
-    void                        _processIntern(eF32 time, eOpCallback callback, ePtr param, eU32 &opCount, eU32 opsTotal, eOpProcessResult &res);
+    void                        _processStack(eF32 time, eOpCallback callback, ePtr param, eU32 opsTotal, eOpProcessResult &res);
+    void                        _addJobs(eF32 time, eArray<eOpJob> &jobs);
+    void                        _postExecute();
+    static void                 _executeJob(ePtr arg, eU32 index);
     void                        _animateParameters(eF32 time);
     void                        _clearParameters();
     void                        _getOpsInStackVisit(eIOpPtrArray &ops);
@@ -235,6 +241,7 @@ protected:
     eBool                       m_changed;
     mutable eBool               m_visited;      // for graph traversal jobs
     mutable eBool               m_visited2;     // for nested graph traversals
+    eU32                        m_jobIndex;     // for parallel stack processing
     eF32                        m_subTime;      // for demo playback to calculate relative time
     eIOpPtrArray                m_aboveOps;     // operators above this one
     eIOpPtrArray                m_belowOps;     // operators below this one
@@ -331,6 +331,8 @@ eOP_DEF_MODEL(eParticleSystemOp, "Particles", 'a', 0, 0, eOP_INPUTS())
             m_sizePath.sample(sizeOp->getResult().path);
         if (rotOp && rotOp->getChanged())
             m_rotPath.sample(rotOp->getResult().path);
+        if (emitterOp && emitterOp->getChanged())
+            m_psys.reset();
       
         m_psys.setEmitter(emitterOp ? &emitterOp->getResult().mesh : nullptr, (ePsEmitterMode&)emitterMode);
         m_psys.setStretch(stretch);
@@ -351,6 +353,23 @@ eOP_DEF_MODEL(eParticleSystemOp, "Particles", 'a', 0, 0, eOP_INPUTS())
     eOP_VAR(ePath4Sampler       m_rotPath);
     eOP_VAR(eParticleSystem     m_psys);
     eOP_VAR(eParticleSysInst *  m_psysInst);
+
+    // particle systems are simulated on the CPU and
+    // only touch their own data. their GPU resources
+    // are created on init and filled when rendering.
+    // of the linked texture only the texture pointer
+    // is read, so link inputs don't keep them on the
+    // main thread and several particle systems can
+    // be updated at the same time.
+    protected:
+        virtual eBool _canExecuteParallel() const
+        {
+            for (eU32 i=0; i<m_aboveOps.size(); i++)
+                if (m_aboveOps[i]->getResultClass() == eOC_BMP)
+                    return eFALSE;
+
+            return eTRUE;
+        }
 eOP_END(eParticleSystemOp);
 #endif
 
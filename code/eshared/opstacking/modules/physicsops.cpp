@@ -226,7 +226,7 @@ eOP_DEF_MESH(eSliceOp, "Slice", ' ', 1, 1, eOP_INPUTS(eOC_MESH))
                     break;
             }
 
-            eU32 *wdgs = eALLOC_STACK(eU32, holeContour.size());
+            eArray<eU32> wdgs(holeContour.size());
             for (eU32 j=0; j<holeContour.size(); j++)
                 wdgs[j] = holeContour[j].startWdg;
 
@@ -255,7 +255,7 @@ eOP_DEF_MESH(eSliceOp, "Slice", ' ', 1, 1, eOP_INPUTS(eOC_MESH))
                     wdgs[j] = mesh.addWedge(mesh.getWedge(wdgs[j]).posIdx, mesh.addNormal(eVector3()), mesh.addProperty(eVector2(), eCOL_WHITE));
                 }
 
-                mesh.addFace(wdgs, holeContour.size(), nullptr);
+                mesh.addFace(&wdgs[0], holeContour.size(), nullptr);
             }
         }
 
@@ -359,7 +359,9 @@ eOP_DEF_MODEL(eExplodeOp, "Explode", ' ', 1, 1, eOP_INPUTS(eOC_MESH|eOC_MODEL))
         eOP_PAR_FLOAT(eExplodeOp, delay, "Delay", 0.0f, eF32_MAX, 1.0f,
 		eOP_PAR_END))))))))
     {
-        // initialize
+        // fragments, their render meshes and mass
+        // properties only depend on the input mesh,
+        // so they are set up once per input change
         if (getAboveOp(0)->getChanged())
         {
             _clear();
@@ -368,20 +370,26 @@ eOP_DEF_MODEL(eExplodeOp, "Explode", ' ', 1, 1, eOP_INPUTS(eOC_MESH|eOC_MODEL))
             {
                 const eEditMesh &mesh = ((eIMeshOp *)getAboveOp(0))->getResult().mesh;
 
-                eArray<eU32> tags;
-                for (eU32 i=0; i<mesh.getFaceCount(); i++)
-                    tags.appendUnique(mesh.getFace(i).tag);
+                eArray<eEditMesh *> parts;
+                _partitionMeshByTag(mesh, parts);
+                m_rbs.resize(parts.size());
 
-                m_rbs.resize(tags.size());
-
-                for (eU32 i=0; i<tags.size(); i++)
+                for (eU32 i=0; i<parts.size(); i++)
                 {
-                    m_rbs[i].em = new eEditMesh;
-                    _extractMeshByTag(mesh, tags[i], *m_rbs[i].em);
+                    m_rbs[i].em = parts[i];
                     m_rbs[i].mesh = new eMesh;
                     m_rbs[i].mesh->fromEditMesh(*m_rbs[i].em, (getAboveOp(0)->isAnimated() ? eMT_DYNAMIC : eMT_STATIC));
                     m_rbs[i].mi = new eMeshInst(*m_rbs[i].mesh, eFALSE);
                 }
+
+                eJobPool::getDefault().run(_calcPhysicalPropertiesJob, &m_rbs, m_rbs.size());
+
+                for (eU32 i=0; i<m_rbs.size(); i++)
+                {
+                    m_rbs[i].rotAxis.set(1.0f, 1.0f, 1.0f);
+                    m_rbs[i].rotAxis = m_rbs[i].rotAxis.random();
+                    m_rbs[i].rotAxis.normalize();
+                }
             }
             else if (getAboveOp(0)->getResultClass() == eOC_MODEL)
             {
@@ -391,6 +399,7 @@ eOP_DEF_MODEL(eExplodeOp, "Explode", ' ', 1, 1, eOP_INPUTS(eOC_MESH|eOC_MODEL))
 
                 //eF32 dt = time;//-m_lastTime;
 
+        // resetting only recomputes the velocities
         if (time <= ignitionTime || getAboveOp(0)->getChanged() || m_explPos != explPos || m_explSpeed != explSpeed || m_gravity != gravity || m_angVel != angVel || m_ignitionTime != ignitionTime)
         {
             m_explPos = explPos;
@@ -491,8 +500,6 @@ eOP_DEF_MODEL(eExplodeOp, "Explode", ' ', 1, 1, eOP_INPUTS(eOC_MESH|eOC_MODEL))
 
     void _initRigidBody(RigidBody &rb, const eVector3 &exploPos, const eVector3 &exploSpeed)
     {
-        _calcPhysicalProperties(rb);
-
         eVector3 dir = rb.massCenter-exploPos;
         eF32 dist = dir.length();
         dir.normalize();
@@ -505,9 +512,6 @@ eOP_DEF_MODEL(eExplodeOp, "Explode", ' ', 1, 1, eOP_INPUTS(eOC_MESH|eOC_MODEL))
         const eVector3 angVel = 0.1f;//rb.inertia.inverse()*torque;
 
         rb.angVel = angVel.length();
-        rb.rotAxis.set(1.0f,1.0f,1.0f);// = angVel.normalized();
-        rb.rotAxis = rb.rotAxis.random();
-        rb.rotAxis.normalize();
         rb.linearVel = force;
     }
 
@@ -517,21 +521,38 @@ eOP_DEF_MODEL(eExplodeOp, "Explode", ' ', 1, 1, eOP_INPUTS(eOC_MESH|eOC_MODEL))
         return mtxRot*inertiaTensor*mtxRot.transposed();
     }
 
-int A;   /* alpha */
-int B;   /* beta */
-int C;   /* gamma */
-double P1, Pa, Pb, Paa, Pab, Pbb, Paaa, Paab, Pabb, Pbbb; /* projection integrals */
-double Fa, Fb, Fc, Faa, Fbb, Fcc, Faaa, Fbbb, Fccc, Faab, Fbbc, Fcca; /* face integrals */
-double T0, T1[3], T2[3], TP[3]; /* volume integrals */
+    static void _calcPhysicalPropertiesJob(ePtr arg, eU32 index)
+    {
+        _calcPhysicalProperties((*(eArray<RigidBody> *)arg)[index]);
+    }
 
-    void _calcPhysicalProperties(RigidBody &rb)
+    static void _calcPhysicalProperties(RigidBody &rb)
     {
-        compVolumeIntegrals(*rb.em);
+        VolumeIntegrals vi;
+        vi.compVolumeIntegrals(*rb.em);
 
-        rb.vol = (eF32)T0;
+        rb.vol = (eF32)vi.T0;
         rb.massCenter.null();
         rb.inertia.identity();
 
+        // center of mass and inertia tensor around it
+        // for density 1 (mass equals volume)
+        if (eAbs((eF32)vi.T0) > eALMOST_ZERO)
+        {
+            const double r[3] = {vi.T1[X]/vi.T0, vi.T1[Y]/vi.T0, vi.T1[Z]/vi.T0};
+
+            rb.massCenter.set((eF32)r[X], (eF32)r[Y], (eF32)r[Z]);
+            rb.inertia(X, X) = (eF32)(vi.T2[Y]+vi.T2[Z]-vi.T0*(SQR(r[Y])+SQR(r[Z])));
+            rb.inertia(Y, Y) = (eF32)(vi.T2[Z]+vi.T2[X]-vi.T0*(SQR(r[Z])+SQR(r[X])));
+            rb.inertia(Z, Z) = (eF32)(vi.T2[X]+vi.T2[Y]-vi.T0*(SQR(r[X])+SQR(r[Y])));
+            rb.inertia(X, Y) = rb.inertia(Y, X) = (eF32)(-vi.TP[X]+vi.T0*r[X]*r[Y]);
+            rb.inertia(Y, Z) = rb.inertia(Z, Y) = (eF32)(-vi.TP[Y]+vi.T0*r[Y]*r[Z]);
+            rb.inertia(Z, X) = rb.inertia(X, Z) = (eF32)(-vi.TP[Z]+vi.T0*r[Z]*r[X]);
+            return;
+        }
+
+        // open or flat fragments have no volume,
+        // fall back to the vertex average
         if (!rb.mesh->getVertexCount())
             return;
 
@@ -540,198 +561,302 @@ double T0, T1[3], T2[3], TP[3]; /* volume integrals */
         rb.massCenter /= (eF32)rb.mesh->getVertexCount();
     }
 
-    void _extractMeshByTag(const eEditMesh &mesh, eU32 tag, eEditMesh &res)
+    struct Remap
     {
-        eU32 *remapWdg = eALLOC_STACK(eU32, mesh.getWedgeCount());
-        eMemSet(remapWdg, 0xff, sizeof(eU32)*mesh.getWedgeCount());
-        eU32 *remapPos = eALLOC_STACK(eU32, mesh.getPositionCount());
-        eMemSet(remapPos, 0xff, sizeof(eU32)*mesh.getPositionCount());
-        eU32 *remapNrm = eALLOC_STACK(eU32, mesh.getNormalCount());
-        eMemSet(remapNrm, 0xff, sizeof(eU32)*mesh.getNormalCount());
-        eU32 *remapProp = eALLOC_STACK(eU32, mesh.getPropertyCount());
-        eMemSet(remapProp, 0xff, sizeof(eU32)*mesh.getPropertyCount());
+        eU32        part;
+        eU32        index;
+    };
 
-        for (eU32 i=0; i<mesh.getFaceCount(); i++)
+    // splits the mesh into one mesh per face tag,
+    // ordered by first appearance of the tags. faces
+    // are bucketed by tag first, so every face is
+    // visited once instead of once per tag. remap
+    // entries remember the part they were made for
+    // and never have to be reset between parts.
+    static void _partitionMeshByTag(const eEditMesh &mesh, eArray<eEditMesh *> &parts)
+    {
+        const eU32 faceCount = mesh.getFaceCount();
+        parts.clear();
+
+        if (!faceCount)
+            return;
+
+        // find part of each face using an open
+        // addressing hash table on the tags
+        eArray<eU32> tags;
+        eArray<eU32> slots(32); // part+1, 0 if empty
+        eArray<eU32> faceParts(faceCount);
+        eMemSet(&slots[0], 0, sizeof(eU32)*slots.size());
+
+        for (eU32 i=0; i<faceCount; i++)
         {
-            const eEmFace &face = mesh.getFace(i);
-            if (face.tag == tag)
+            const eU32 tag = mesh.getFace(i).tag;
+            eU32 slot = eHashInt(tag)&(slots.size()-1);
+
+            while (slots[slot] && tags[slots[slot]-1] != tag)
+                slot = (slot+1)&(slots.size()-1);
+
+            if (slots[slot])
+                faceParts[i] = slots[slot]-1;
+            else
             {
-                eU32 newWdgs[8];
+                faceParts[i] = tags.size();
+                tags.append(tag);
+                slots[slot] = tags.size();
+
+                if (tags.size()*2 > slots.size())
+                {
+                    slots.resize(slots.size()*2);
+                    eMemSet(&slots[0], 0, sizeof(eU32)*slots.size());
+
+                    for (eU32 j=0; j<tags.size(); j++)
+                    {
+                        eU32 k = eHashInt(tags[j])&(slots.size()-1);
+                        while (slots[k])
+                            k = (k+1)&(slots.size()-1);
+                        slots[k] = j+1;
+                    }
+                }
+            }
+        }
+
+        // sort faces by part, keeping their order
+        const eU32 partCount = tags.size();
+        eArray<eU32> partEnds(partCount);
+        eArray<eU32> sortedFaces(faceCount);
+        eMemSet(&partEnds[0], 0, sizeof(eU32)*partCount);
+
+        for (eU32 i=0; i<faceCount; i++)
+            partEnds[faceParts[i]]++;
+        for (eU32 i=0, sum=0; i<partCount; i++)
+        {
+            const eU32 cnt = partEnds[i];
+            partEnds[i] = sum;
+            sum += cnt;
+        }
+        for (eU32 i=0; i<faceCount; i++)
+            sortedFaces[partEnds[faceParts[i]]++] = i;
+
+        // build parts
+        eArray<Remap> remapWdg(mesh.getWedgeCount());
+        eArray<Remap> remapPos(mesh.getPositionCount());
+        eArray<Remap> remapNrm(mesh.getNormalCount());
+        eArray<Remap> remapProp(mesh.getPropertyCount());
+        eMemSet(&remapWdg[0], 0xff, sizeof(Remap)*remapWdg.size());
+        eMemSet(&remapPos[0], 0xff, sizeof(Remap)*remapPos.size());
+        eMemSet(&remapNrm[0], 0xff, sizeof(Remap)*remapNrm.size());
+        eMemSet(&remapProp[0], 0xff, sizeof(Remap)*remapProp.size());
+
+        parts.resize(partCount);
+
+        for (eU32 i=0, f=0; i<partCount; i++)
+        {
+            eEditMesh &res = *(parts[i] = new eEditMesh);
+
+            for (; f<partEnds[i]; f++)
+            {
+                const eEmFace &face = mesh.getFace(sortedFaces[f]);
+                eU32 newWdgs[eEmFace::MAX_DEGREE];
 
                 for (eU32 j=0; j<face.count; j++)
                 {
                     const eEmWedge &wedge = mesh.getWedge(face.wdgIdx[j]);
+                    Remap &pos = remapPos[wedge.posIdx];
+                    Remap &nrm = remapNrm[wedge.nrmIdx];
+                    Remap &prop = remapProp[wedge.propsIdx];
+                    Remap &wdg = remapWdg[face.wdgIdx[j]];
 
-                    if (remapPos[wedge.posIdx] == 0xffffffff)
+                    if (pos.part != i)
                     {
-                        remapPos[wedge.posIdx] = res.getPositionCount();
-                        res.addPosition(mesh.getPosition(wedge.posIdx).pos);
+                        pos.part = i;
+                        pos.index = res.addPosition(mesh.getPosition(wedge.posIdx).pos);
                     }
 
-                    if (remapNrm[wedge.nrmIdx] == 0xffffffff)
+                    if (nrm.part != i)
                     {
-                        remapNrm[wedge.nrmIdx] = res.getNormalCount();
-                        res.addNormal(mesh.getNormal(wedge.nrmIdx));
+                        nrm.part = i;
+                        nrm.index = res.addNormal(mesh.getNormal(wedge.nrmIdx));
                     }
 
-                    if (remapProp[wedge.propsIdx] == 0xffffffff)
+                    if (prop.part != i)
                     {
-                        remapProp[wedge.propsIdx] = res.getPropertyCount();
                         const eEmVtxProps &p = mesh.getProperty(wedge.propsIdx);
-                        res.addProperty(p.uv, p.col);
+                        prop.part = i;
+                        prop.index = res.addProperty(p.uv, p.col);
                     }
 
-                    if (remapWdg[face.wdgIdx[j]] == 0xffffffff)
+                    if (wdg.part != i)
                     {
-                        remapWdg[face.wdgIdx[j]] = res.getWedgeCount();
-                        res.addWedge(remapPos[wedge.posIdx], remapNrm[wedge.nrmIdx], remapProp[wedge.propsIdx]);
+                        wdg.part = i;
+                        wdg.index = res.addWedge(pos.index, nrm.index, prop.index);
                     }
 
-                    newWdgs[j] = remapWdg[face.wdgIdx[j]];
+                    newWdgs[j] = wdg.index;
                 }
 
                 res.addFace(newWdgs, face.count, face.mat);
             }
-
-            res.calcNormals();
-            res.calcBoundingBox();
         }
+
+        eJobPool::getDefault().run(_finishPartJob, &parts, partCount);
     }
 
-    // compute various integrations over projection of face
-    void compProjectionIntegrals(eEditMesh &m, eEmFace &f)
+    static void _finishPartJob(ePtr arg, eU32 index)
     {
-        double a0, a1, da;
-        double b0, b1, db;
-        double a0_2, a0_3, a0_4, b0_2, b0_3, b0_4;
-        double a1_2, a1_3, b1_2, b1_3;
-        double C1, Ca, Caa, Caaa, Cb, Cbb, Cbbb;
-        double Cab, Kab, Caab, Kaab, Cabb, Kabb;
-        eU32 i;
-
-        P1 = Pa = Pb = Paa = Pab = Pbb = Paaa = Paab = Pabb = Pbbb = 0.0;
-
-        for (i = 0; i < f.count; i++) {
-
-            a0 = m.getPosition(f.posIdx[i]).pos[A];
-            b0 = m.getPosition(f.posIdx[i]).pos[B];
-            a1 = m.getPosition(f.posIdx[(i+1)%f.count]).pos[A];
-            b1 = m.getPosition(f.posIdx[(i+1)%f.count]).pos[B];
-
-            da = a1 - a0;
-            db = b1 - b0;
-            a0_2 = a0 * a0; a0_3 = a0_2 * a0; a0_4 = a0_3 * a0;
-            b0_2 = b0 * b0; b0_3 = b0_2 * b0; b0_4 = b0_3 * b0;
-            a1_2 = a1 * a1; a1_3 = a1_2 * a1; 
-            b1_2 = b1 * b1; b1_3 = b1_2 * b1;
-
-            C1 = a1 + a0;
-            Ca = a1*C1 + a0_2; Caa = a1*Ca + a0_3; Caaa = a1*Caa + a0_4;
-            Cb = b1*(b1 + b0) + b0_2; Cbb = b1*Cb + b0_3; Cbbb = b1*Cbb + b0_4;
-            Cab = 3*a1_2 + 2*a1*a0 + a0_2; Kab = a1_2 + 2*a1*a0 + 3*a0_2;
-            Caab = a0*Cab + 4*a1_3; Kaab = a1*Kab + 4*a0_3;
-            Cabb = 4*b1_3 + 3*b1_2*b0 + 2*b1*b0_2 + b0_3;
-            Kabb = b1_3 + 2*b1_2*b0 + 3*b1*b0_2 + 4*b0_3;
-
-            P1 += db*C1;
-            Pa += db*Ca;
-            Paa += db*Caa;
-            Paaa += db*Caaa;
-            Pb += da*Cb;
-            Pbb += da*Cbb;
-            Pbbb += da*Cbbb;
-            Pab += db*(b1*Cab + b0*Kab);
-            Paab += db*(b1*Caab + b0*Kaab);
-            Pabb += da*(a1*Cabb + a0*Kabb);
-        }
-
-        P1 /= 2.0;
-        Pa /= 6.0;
-        Paa /= 12.0;
-        Paaa /= 20.0;
-        Pb /= -6.0;
-        Pbb /= -12.0;
-        Pbbb /= -20.0;
-        Pab /= 24.0;
-        Paab /= 60.0;
-        Pabb /= -60.0;
+        eEditMesh *part = (*(eArray<eEditMesh *> *)arg)[index];
+        part->calcNormals();
+        part->calcBoundingBox();
     }
 
-    void compFaceIntegrals(eEditMesh &m, eEmFace &f)
+    // volume integrals after Mirtich ("fast and
+    // accurate computation of polyhedral mass
+    // properties"). the intermediate results live
+    // in here instead of in globals, so bodies can
+    // be processed in parallel.
+    struct VolumeIntegrals
     {
-        const eF32 *n;
-        double w;
-        double k1, k2, k3, k4;
+        int A;   /* alpha */
+        int B;   /* beta */
+        int C;   /* gamma */
+        double P1, Pa, Pb, Paa, Pab, Pbb, Paaa, Paab, Pabb, Pbbb; /* projection integrals */
+        double Fa, Fb, Fc, Faa, Fbb, Fcc, Faaa, Fbbb, Fccc, Faab, Fbbc, Fcca; /* face integrals */
+        double T0, T1[3], T2[3], TP[3]; /* volume integrals */
+
+        // compute various integrations over projection of face
+        void compProjectionIntegrals(const eEditMesh &m, const eEmFace &f)
+        {
+            double a0, a1, da;
+            double b0, b1, db;
+            double a0_2, a0_3, a0_4, b0_2, b0_3, b0_4;
+            double a1_2, a1_3, b1_2, b1_3;
+            double C1, Ca, Caa, Caaa, Cb, Cbb, Cbbb;
+            double Cab, Kab, Caab, Kaab, Cabb, Kabb;
+            eU32 i;
+
+            P1 = Pa = Pb = Paa = Pab = Pbb = Paaa = Paab = Pabb = Pbbb = 0.0;
+
+            for (i = 0; i < f.count; i++) {
+
+                a0 = m.getPosition(f.posIdx[i]).pos[A];
+                b0 = m.getPosition(f.posIdx[i]).pos[B];
+                a1 = m.getPosition(f.posIdx[(i+1)%f.count]).pos[A];
+                b1 = m.getPosition(f.posIdx[(i+1)%f.count]).pos[B];
+
+                da = a1 - a0;
+                db = b1 - b0;
+                a0_2 = a0 * a0; a0_3 = a0_2 * a0; a0_4 = a0_3 * a0;
+                b0_2 = b0 * b0; b0_3 = b0_2 * b0; b0_4 = b0_3 * b0;
+                a1_2 = a1 * a1; a1_3 = a1_2 * a1; 
+                b1_2 = b1 * b1; b1_3 = b1_2 * b1;
+
+                C1 = a1 + a0;
+                Ca = a1*C1 + a0_2; Caa = a1*Ca + a0_3; Caaa = a1*Caa + a0_4;
+                Cb = b1*(b1 + b0) + b0_2; Cbb = b1*Cb + b0_3; Cbbb = b1*Cbb + b0_4;
+                Cab = 3*a1_2 + 2*a1*a0 + a0_2; Kab = a1_2 + 2*a1*a0 + 3*a0_2;
+                Caab = a0*Cab + 4*a1_3; Kaab = a1*Kab + 4*a0_3;
+                Cabb = 4*b1_3 + 3*b1_2*b0 + 2*b1*b0_2 + b0_3;
+                Kabb = b1_3 + 2*b1_2*b0 + 3*b1*b0_2 + 4*b0_3;
+
+                P1 += db*C1;
+                Pa += db*Ca;
+                Paa += db*Caa;
+                Paaa += db*Caaa;
+                Pb += da*Cb;
+                Pbb += da*Cbb;
+                Pbbb += da*Cbbb;
+                Pab += db*(b1*Cab + b0*Kab);
+                Paab += db*(b1*Caab + b0*Kaab);
+                Pabb += da*(a1*Cabb + a0*Kabb);
+            }
 
-        compProjectionIntegrals(m, f);
+            P1 /= 2.0;
+            Pa /= 6.0;
+            Paa /= 12.0;
+            Paaa /= 20.0;
+            Pb /= -6.0;
+            Pbb /= -12.0;
+            Pbbb /= -20.0;
+            Pab /= 24.0;
+            Paab /= 60.0;
+            Pabb /= -60.0;
+        }
 
-        //w = f->w;
+        void compFaceIntegrals(const eEditMesh &m, const eEmFace &f)
+        {
+            const eF32 *n;
+            double w;
+            double k1, k2, k3, k4;
 
-        w = - f.normal[X] * m.getPosition(f.posIdx[0]).pos[X]
-            - f.normal[Y] * m.getPosition(f.posIdx[0]).pos[Y]
-            - f.normal[Z] * m.getPosition(f.posIdx[0]).pos[Z];
+            compProjectionIntegrals(m, f);
 
-        n = f.normal;
-        k1 = 1 / n[C]; k2 = k1 * k1; k3 = k2 * k1; k4 = k3 * k1;
+            //w = f->w;
 
-        Fa = k1 * Pa;
-        Fb = k1 * Pb;
-        Fc = -k2 * (n[A]*Pa + n[B]*Pb + w*P1);
+            w = - f.normal[X] * m.getPosition(f.posIdx[0]).pos[X]
+                - f.normal[Y] * m.getPosition(f.posIdx[0]).pos[Y]
+                - f.normal[Z] * m.getPosition(f.posIdx[0]).pos[Z];
 
-        Faa = k1 * Paa;
-        Fbb = k1 * Pbb;
-        Fcc = k3 * (SQR(n[A])*Paa + 2*n[A]*n[B]*Pab + SQR(n[B])*Pbb
-            + w*(2*(n[A]*Pa + n[B]*Pb) + w*P1));
+            n = f.normal;
+            k1 = 1 / n[C]; k2 = k1 * k1; k3 = k2 * k1; k4 = k3 * k1;
 
-        Faaa = k1 * Paaa;
-        Fbbb = k1 * Pbbb;
-        Fccc = -k4 * (CUBE(n[A])*Paaa + 3*SQR(n[A])*n[B]*Paab 
-            + 3*n[A]*SQR(n[B])*Pabb + CUBE(n[B])*Pbbb
-            + 3*w*(SQR(n[A])*Paa + 2*n[A]*n[B]*Pab + SQR(n[B])*Pbb)
-            + w*w*(3*(n[A]*Pa + n[B]*Pb) + w*P1));
+            Fa = k1 * Pa;
+            Fb = k1 * Pb;
+            Fc = -k2 * (n[A]*Pa + n[B]*Pb + w*P1);
 
-        Faab = k1 * Paab;
-        Fbbc = -k2 * (n[A]*Pabb + n[B]*Pbbb + w*Pbb);
-        Fcca = k3 * (SQR(n[A])*Paaa + 2*n[A]*n[B]*Paab + SQR(n[B])*Pabb
-            + w*(2*(n[A]*Paa + n[B]*Pab) + w*Pa));
-    }
+            Faa = k1 * Paa;
+            Fbb = k1 * Pbb;
+            Fcc = k3 * (SQR(n[A])*Paa + 2*n[A]*n[B]*Pab + SQR(n[B])*Pbb
+                + w*(2*(n[A]*Pa + n[B]*Pb) + w*P1));
 
-    void compVolumeIntegrals(eEditMesh &m)
-    {
-        double nx, ny, nz;
-        T0 = T1[X] = T1[Y] = T1[Z] = T2[X] = T2[Y] = T2[Z] = TP[X] = TP[Y] = TP[Z] = 0;
-
-        for (eU32 i = 0; i < m.getFaceCount(); i++) {
-
-            eEmFace &f = m.getFace(i);
-
-            nx = eAbs(f.normal.x);
-            ny = eAbs(f.normal.y);
-            nz = eAbs(f.normal.z);
-            if (nx > ny && nx > nz) C = X;
-            else C = (ny > nz) ? Y : Z;
-            A = (C + 1) % 3;
-            B = (A + 1) % 3;
-
-            compFaceIntegrals(m, f);
-
-            T0 += f.normal[X] * ((A == X) ? Fa : ((B == X) ? Fb : Fc));
-
-            T1[A] += f.normal[A] * Faa;
-            T1[B] += f.normal[B] * Fbb;
-            T1[C] += f.normal[C] * Fcc;
-            T2[A] += f.normal[A] * Faaa;
-            T2[B] += f.normal[B] * Fbbb;
-            T2[C] += f.normal[C] * Fccc;
-            TP[A] += f.normal[A] * Faab;
-            TP[B] += f.normal[B] * Fbbc;
-            TP[C] += f.normal[C] * Fcca;
+            Faaa = k1 * Paaa;
+            Fbbb = k1 * Pbbb;
+            Fccc = -k4 * (CUBE(n[A])*Paaa + 3*SQR(n[A])*n[B]*Paab 
+                + 3*n[A]*SQR(n[B])*Pabb + CUBE(n[B])*Pbbb
+                + 3*w*(SQR(n[A])*Paa + 2*n[A]*n[B]*Pab + SQR(n[B])*Pbb)
+                + w*w*(3*(n[A]*Pa + n[B]*Pb) + w*P1));
+
+            Faab = k1 * Paab;
+            Fbbc = -k2 * (n[A]*Pabb + n[B]*Pbbb + w*Pbb);
+            Fcca = k3 * (SQR(n[A])*Paaa + 2*n[A]*n[B]*Paab + SQR(n[B])*Pabb
+                + w*(2*(n[A]*Paa + n[B]*Pab) + w*Pa));
         }
 
-        T1[X] /= 2; T1[Y] /= 2; T1[Z] /= 2;
-        T2[X] /= 3; T2[Y] /= 3; T2[Z] /= 3;
-        TP[X] /= 2; TP[Y] /= 2; TP[Z] /= 2;
-    }
+        void compVolumeIntegrals(const eEditMesh &m)
+        {
+            double nx, ny, nz;
+            T0 = T1[X] = T1[Y] = T1[Z] = T2[X] = T2[Y] = T2[Z] = TP[X] = TP[Y] = TP[Z] = 0;
+
+            for (eU32 i = 0; i < m.getFaceCount(); i++) {
+
+                const eEmFace &f = m.getFace(i);
+
+                nx = eAbs(f.normal.x);
+                ny = eAbs(f.normal.y);
+                nz = eAbs(f.normal.z);
+                if (nx > ny && nx > nz) C = X;
+                else C = (ny > nz) ? Y : Z;
+                A = (C + 1) % 3;
+                B = (A + 1) % 3;
+
+                compFaceIntegrals(m, f);
+
+                T0 += f.normal[X] * ((A == X) ? Fa : ((B == X) ? Fb : Fc));
+
+                T1[A] += f.normal[A] * Faa;
+                T1[B] += f.normal[B] * Fbb;
+                T1[C] += f.normal[C] * Fcc;
+                T2[A] += f.normal[A] * Faaa;
+                T2[B] += f.normal[B] * Fbbb;
+                T2[C] += f.normal[C] * Fccc;
+                TP[A] += f.normal[A] * Faab;
+                TP[B] += f.normal[B] * Fbbc;
+                TP[C] += f.normal[C] * Fcca;
+            }
+
+            T1[X] /= 2; T1[Y] /= 2; T1[Z] /= 2;
+            T2[X] /= 3; T2[Y] /= 3; T2[Z] /= 3;
+            TP[X] /= 2; TP[Y] /= 2; TP[Z] /= 2;
+        }
+    };
 
     eOP_VAR(eArray<RigidBody> m_rbs);
     eOP_VAR(eF32              m_lastTime);
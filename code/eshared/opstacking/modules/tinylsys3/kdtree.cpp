@@ -19,180 +19,272 @@
 #include "../../../eshared.hpp"
 #include "kdtree.hpp"
 
-eGenericKDTree::eGenericKDTree() {
-	this->randomSeed = 12342;
-}
+// moves the nth smallest key to position nth,
+// smaller ones before and bigger ones after it
+static void selectNth(eU32* order, eU32 count, eU32 nth, const eArray<eVector3>& positions, eU32 axis) {
+	eInt lo = 0;
+	eInt hi = count - 1;
+	while(hi > lo) {
+		// median of three pivot
+		const eF32 a = positions[order[lo]][axis];
+		const eF32 b = positions[order[(lo + hi) / 2]][axis];
+		const eF32 c = positions[order[hi]][axis];
+		const eF32 pivot = eMax(eMin(a, b), eMin(eMax(a, b), c));
+
+		eInt i = lo;
+		eInt j = hi;
+		while(i <= j) {
+			while(positions[order[i]][axis] < pivot)
+				i++;
+			while(positions[order[j]][axis] > pivot)
+				j--;
+			if(i <= j) {
+				eSwap(order[i], order[j]);
+				i++;
+				j--;
+			}
+		}
 
-void eGenericKDTree::clear() {
-	m_leafs.clear();
+		if((eInt)nth <= j)
+			hi = j;
+		else if((eInt)nth >= i)
+			lo = i;
+		else
+			return;
+	}
 }
 
-void eGenericKDTree::add(const eVector3& position, const void* value) {
-	Entry e;
-	e.m_position = position;
-	e.m_leaf = value;
-	m_leafs.append(e);
+eGenericKDTree::eGenericKDTree() {
+	m_count = 0;
+	m_numLeafs = 0;
 }
-void eGenericKDTree::remove(const void* val, Node& node) {
-	ePROFILER_ZONE("KDTree Remove");
-	for(eU32 i = node.m_leafStartIdx; i < node.m_leafStartIdx + node.m_leafCnt; i++) {
-		if(m_leafs[i].m_leaf == val) {
-			// found, remove it
-			node.m_leafCnt--;
-			m_leafs[i] = m_leafs[node.m_leafStartIdx + node.m_leafCnt];
-			i--;
-		}
-	}
-	// now update parents
-	Node* curNode = node.m_parent;
-	while(curNode != nullptr) {
-		curNode->m_leafCnt--;
-		for(eU32 i = 0; i < 2; i++) 
-			if(curNode->m_children[i]) {
-				if(m_nodeArray[curNode->m_children[i]].m_leafCnt == 0) 
-					curNode->m_children[i] = 0;
-			}
-		curNode = curNode->m_parent;
+
+// the tree is split level by level, all nodes
+// of a level are split in parallel
+void eGenericKDTree::build(const eArray<eVector3>& positions) {
+	ePROFILER_FUNC();
+	const eU32 count = positions.size();
+	m_count = count;
+	m_numLeafs = 1;
+	while(count > m_numLeafs * KDTREE2_LEAF_SIZE)
+		m_numLeafs *= 2;
+
+	m_splitValues.resize(m_numLeafs - 1);
+	m_splitAxes.resize(m_numLeafs - 1);
+	m_counts.resize(2 * m_numLeafs - 1);
+	m_x.resize(m_numLeafs * KDTREE2_LEAF_SIZE);
+	m_y.resize(m_numLeafs * KDTREE2_LEAF_SIZE);
+	m_z.resize(m_numLeafs * KDTREE2_LEAF_SIZE);
+	m_indices.resize(m_numLeafs * KDTREE2_LEAF_SIZE);
+	m_slots.resize(count);
+	m_order.resize(count);
+	for(eU32 i = 0; i < count; i++)
+		m_order[i] = i;
+
+	BuildJob job;
+	job.tree = this;
+	job.positions = &positions;
+	for(eU32 first = 0; first < m_numLeafs - 1; first = first * 2 + 1) {
+		job.first = first;
+		eJobPool::getDefault().run(splitNode, &job, first + 1);
 	}
+	job.first = m_numLeafs - 1;
+	eJobPool::getDefault().run(fillLeaf, &job, m_numLeafs);
+
+	for(eInt i = m_numLeafs - 2; i >= 0; i--)
+		m_counts[i] = m_counts[2 * i + 1] + m_counts[2 * i + 2];
 }
 
-void eGenericKDTree::finishLoading() {
-	m_leafsBuffer.reserve(m_leafs.size());
-	m_nodeArray.clear();
-	m_nodeArray.reserve(m_leafs.size());
-	{
-		ePROFILER_ZONE("KD Tree: Finish Loading");
-		splitLeafs(nullptr, 0, 0, m_leafs.size());
+// removed points are moved to infinity, empty
+// subtrees are skipped by queries
+void eGenericKDTree::remove(eU32 index) {
+	const eU32 slot = m_slots[index];
+	if(slot == KDTREE2_NO_INDEX)
+		return;
+
+	m_slots[index] = KDTREE2_NO_INDEX;
+	m_indices[slot] = KDTREE2_NO_INDEX;
+	m_x[slot] = eF32_MAX;
+	m_y[slot] = eF32_MAX;
+	m_z[slot] = eF32_MAX;
+
+	eU32 node = m_numLeafs - 1 + slot / KDTREE2_LEAF_SIZE;
+	m_counts[node]--;
+	while(node > 0) {
+		node = (node - 1) / 2;
+		m_counts[node]--;
 	}
 }
 
+eU32 eGenericKDTree::getKNearest(Result* results, eU32 k, const eVector3& position) const {
+	eASSERT(k <= KDTREE2_MAX_K);
+	if((k == 0) || (m_count == 0) || (m_counts[0] == 0))
+		return 0;
 
-eU32 eGenericKDTree::findKAndSort(eU32 axis, eU32 start, eU32 len, eU32 rank) {
-	eASSERT(len > 0);
-	// copy all entries
-	m_leafsBuffer.clear();
-	for(eU32 i = start; i < start + len; i++) 
-		m_leafsBuffer.append(m_leafs[i]);
-
-	const eF32 pivot = m_leafsBuffer[eRandom(0, len, this->randomSeed)].m_position[axis];
-
-	eU32 s = 0;
-	eU32 b = 0;
-	eU32 eqTrans = len >> 1;
-	for(eU32 i = 0; i < len; i++) {
-		eBool isSmaller = m_leafsBuffer[i].m_position[axis] < pivot;
-		if(m_leafsBuffer[i].m_position[axis] == pivot)
-			if(eqTrans > 0)
-				eqTrans--;
-			else
-				isSmaller = eTRUE;
-		if(isSmaller) {
-			m_leafs[start + s] = m_leafsBuffer[i];
-			s++;
-		} else {
-			b++;
-			m_leafs[start + len - b] = m_leafsBuffer[i];
+	const eF32x4 posX = eSimdSetAll(position.x);
+	const eF32x4 posY = eSimdSetAll(position.y);
+	const eF32x4 posZ = eSimdSetAll(position.z);
+	eF32 maxDistSqr = eF32_MAX;
+	eU32 numRes = 0;
+
+	// far children with the distance to their
+	// splitting plane
+	eU32 stackNodes[64];
+	eF32 stackDists[64];
+	eU32 sp = 0;
+	stackNodes[sp] = 0;
+	stackDists[sp++] = 0.0f;
+
+	while(sp > 0) {
+		sp--;
+		if(stackDists[sp] >= maxDistSqr)
+			continue;
+
+		// descend to leaf
+		eU32 node = stackNodes[sp];
+		while(node < m_numLeafs - 1) {
+			const eF32 diff = position[m_splitAxes[node]] - m_splitValues[node];
+			const eU32 nearNode = 2 * node + ((diff < 0.0f) ? 1 : 2);
+			const eU32 farNode = 2 * node + ((diff < 0.0f) ? 2 : 1);
+			if(m_counts[farNode] > 0) {
+				stackNodes[sp] = farNode;
+				stackDists[sp++] = diff * diff;
+			}
+			node = nearNode;
+		}
+		if(m_counts[node] == 0)
+			continue;
+
+		// test leaf block 4 points at a time
+		const eU32 block = (node - (m_numLeafs - 1)) * KDTREE2_LEAF_SIZE;
+		for(eU32 i = block; i < block + KDTREE2_LEAF_SIZE; i += 4) {
+			const eF32x4 dx = eSimdSub(eSimdLoad(&m_x[i]), posX);
+			const eF32x4 dy = eSimdSub(eSimdLoad(&m_y[i]), posY);
+			const eF32x4 dz = eSimdSub(eSimdLoad(&m_z[i]), posZ);
+			const eF32x4 distSqr = eSimdFma(eSimdFma(eSimdMul(dx, dx), dy, dy), dz, dz);
+			if(!_mm_movemask_ps(_mm_cmplt_ps(distSqr, eSimdSetAll(maxDistSqr))))
+				continue;
+
+			eALIGN16 eF32 dists[4];
+			eSimdStoreAligned(distSqr, dists);
+			for(eU32 j = 0; j < 4; j++) {
+				if(dists[j] >= maxDistSqr)
+					continue;
+
+				// insert into sorted results
+				eU32 pos = (numRes < k) ? numRes++ : k - 1;
+				while((pos > 0) && (results[pos - 1].distanceSqr > dists[j])) {
+					results[pos] = results[pos - 1];
+					pos--;
+				}
+				results[pos].distanceSqr = dists[j];
+				results[pos].index = m_indices[i + j];
+				if(numRes == k)
+					maxDistSqr = results[k - 1].distanceSqr;
+			}
 		}
 	}
-	if(rank == s) 
-		return s;
-	if(s < rank)
-		return s + findKAndSort(axis, start + s, b, rank - s);
-	return findKAndSort(axis, start, s, rank);
+	return numRes;
 }
 
+void eGenericKDTree::queryKNearest(const eArray<eVector3>& positions, eU32 k, eArray<Result>& results) const {
+	ePROFILER_FUNC();
+	const eU32 count = positions.size();
+	results.resize(count * k);
+	if(results.isEmpty())
+		return;
+
+	QueryJob job;
+	job.tree = this;
+	job.positions = &positions;
+	job.k = k;
+	job.results = &results[0];
+	eJobPool::getDefault().run(queryChunk, &job, (count + KDTREE2_QUERY_CHUNK - 1) / KDTREE2_QUERY_CHUNK);
+}
 
-eU32 eGenericKDTree::splitLeafs(Node* parent, eU32 axis, eU32 startIdx, eU32 len) {
-	eU32 nodeIdx = m_nodeArray.size();
-	Node& node = m_nodeArray.append();
-	node.m_parent = parent;
+// nodes split their range at the middle,
+// so ranges follow from the path to the node
+void eGenericKDTree::getNodeRange(eU32 node, eU32& start, eU32& end) const {
+	eU32 path[32];
+	eU32 depth = 0;
+	for(; node > 0; node = (node - 1) / 2)
+		path[depth++] = node;
 
-	node.m_leafStartIdx = startIdx;
-	node.m_leafCnt = len;
+	start = 0;
+	end = m_count;
+	while(depth > 0) {
+		const eU32 mid = start + (end - start) / 2;
+		if(path[--depth] & 1)
+			end = mid;
+		else
+			start = mid;
+	}
+}
 
-	if(len <= KDTREE2_MAX_CHILDREN_PER_NODE) {
-		node.m_children[0] = 0;
-		node.m_children[1] = 0;
-	} else {
-		axis = (axis + 1) % 3;
+void eGenericKDTree::splitNode(ePtr arg, eU32 index) {
+	const BuildJob& job = *(BuildJob*)arg;
+	eGenericKDTree& tree = *job.tree;
+	const eU32 node = job.first + index;
+	eU32 start, end;
+	tree.getNodeRange(node, start, end);
 
-		eU32 firstHalfLength = findKAndSort(axis, startIdx, len, len >> 1);
-		node.m_splitVal = m_leafs[startIdx + firstHalfLength].m_position[axis];
+	const eArray<eVector3>& positions = *job.positions;
 
-		node.m_children[0] = splitLeafs(&node, axis, startIdx, firstHalfLength); 
-		node.m_children[1] = splitLeafs(&node, axis, startIdx + firstHalfLength, len - firstHalfLength);
+	// split along the longest extent
+	eVector3 vmin(eF32_MAX);
+	eVector3 vmax(-eF32_MAX);
+	for(eU32 i = start; i < end; i++) {
+		vmin.minComponents(positions[tree.m_order[i]]);
+		vmax.maxComponents(positions[tree.m_order[i]]);
 	}
-	return nodeIdx;
+	const eVector3 extent = vmax - vmin;
+	eU32 axis = (extent.x >= extent.y) ? 0 : 1;
+	if(extent.z > extent[axis])
+		axis = 2;
+
+	const eU32 mid = (end - start) / 2;
+	selectNth(&tree.m_order[start], end - start, mid, positions, axis);
+	tree.m_splitAxes[node] = axis;
+	tree.m_splitValues[node] = positions[tree.m_order[start + mid]][axis];
 }
 
-void eGenericKDTree::getKNearest(eArray<Result>& results, eU32 k, const eVector3& position) {
-	ePROFILER_FUNC();
-	results.clear();
-	results.resize(k + KDTREE2_MAX_CHILDREN_PER_NODE);
-	// a small hack, set maximum element distance so that it is always defined
-	eF32& maxElementDistanceSqr = (*((&results[0]) + k - 1)).distanceSqr;
-	maxElementDistanceSqr = eF32_MAX;
-	eU32 numRes = 0;
-	getKNearest(m_nodeArray[0], results, numRes, 0, k, position, maxElementDistanceSqr);
-	results.resize(numRes);
-#ifdef eDEBUG
-/*
-	if(distFunc == nullptr) {
-		const Entry* closest = nullptr;
-		eF32 closestDist = eF32_MAX;
-		for(eU32 i = 0; i < m_leafs.size(); i++) {
-			eF32 dist = (m_leafs[i].m_aabb.getCenter() - position).sqrLength();
-			if((closest == nullptr) ||
-				(dist < closestDist)) {
-					closest = &m_leafs[i];
-					closestDist = dist;
-			}
+void eGenericKDTree::fillLeaf(ePtr arg, eU32 index) {
+	const BuildJob& job = *(BuildJob*)arg;
+	eGenericKDTree& tree = *job.tree;
+	eU32 start, end;
+	tree.getNodeRange(job.first + index, start, end);
+	eASSERT(end - start <= KDTREE2_LEAF_SIZE);
+
+	const eU32 block = index * KDTREE2_LEAF_SIZE;
+	for(eU32 i = 0; i < KDTREE2_LEAF_SIZE; i++) {
+		const eU32 slot = block + i;
+		if(start + i < end) {
+			const eU32 point = tree.m_order[start + i];
+			const eVector3& pos = (*job.positions)[point];
+			tree.m_x[slot] = pos.x;
+			tree.m_y[slot] = pos.y;
+			tree.m_z[slot] = pos.z;
+			tree.m_indices[slot] = point;
+			tree.m_slots[point] = slot;
+		} else {
+			tree.m_x[slot] = eF32_MAX;
+			tree.m_y[slot] = eF32_MAX;
+			tree.m_z[slot] = eF32_MAX;
+			tree.m_indices[slot] = KDTREE2_NO_INDEX;
 		}
-		eASSERT(closest->m_leaf == results[0].t);
 	}
-*/
-#endif
+	tree.m_counts[job.first + index] = end - start;
 }
 
-void eGenericKDTree::getKNearest(Node& node, eArray<Result>& results, eU32& numRes, eU32 axis, eU32 k, const eVector3& position, eF32& maxElementDistanceSqr) {
-	if(node.m_children[0] || node.m_children[1]) {
-		// tree node
-		axis = (axis + 1) % 3;
-
-		eU32 children[] = {node.m_children[0], node.m_children[1]};
-		// determine order
-		if(position[axis] >= node.m_splitVal)
-			eSwap(children[0], children[1]);
-
-		if(children[0])
-			getKNearest(m_nodeArray[children[0]], results, numRes, axis, k, position, maxElementDistanceSqr);
-		if(children[1] &&
-			((numRes != k) || (eSqr(position[axis] - node.m_splitVal) < maxElementDistanceSqr)))
-				getKNearest(m_nodeArray[children[1]], results, numRes, axis, k, position, maxElementDistanceSqr);
-	} else {
-		// leaf node
-		for(eU32 i = node.m_leafStartIdx; i < node.m_leafStartIdx + node.m_leafCnt; i++) {
-			const eF32 distanceSqr = (m_leafs[i].m_position - position).sqrLength();
-			if(distanceSqr >= maxElementDistanceSqr)
-				continue;
-			
-			// increase results size up to k
-			numRes = eMin(k, numRes + 1);
-			
-			// move result elements and find insertion index
-			eU32 rpos = numRes;
-			while((rpos > 0) && (results[rpos - 1].distanceSqr > distanceSqr)) {
-				results[rpos] = results[rpos - 1];
-				rpos--;
-			}
-			
-			// set result
-			Result &r = results[rpos];
-			r.distanceSqr = distanceSqr;
-			r.t = m_leafs[i].m_leaf;
-			r.node = &node;
-
+void eGenericKDTree::queryChunk(ePtr arg, eU32 index) {
+	const QueryJob& job = *(QueryJob*)arg;
+	const eArray<eVector3>& positions = *job.positions;
+	const eU32 end = eMin((index + 1) * KDTREE2_QUERY_CHUNK, positions.size());
+	for(eU32 i = index * KDTREE2_QUERY_CHUNK; i < end; i++) {
+		Result* results = job.results + i * job.k;
+		for(eU32 j = job.tree->getKNearest(results, job.k, positions[i]); j < job.k; j++) {
+			results[j].distanceSqr = eF32_MAX;
+			results[j].index = KDTREE2_NO_INDEX;
 		}
 	}
 }
-
@@ -16,48 +16,64 @@
 
 #include "../../../eshared.hpp"
 
-#define KDTREE2_MAX_CHILDREN_PER_NODE	64
+#define KDTREE2_LEAF_SIZE		16
+#define KDTREE2_MAX_K			32
+#define KDTREE2_NO_INDEX		0xffffffff
+#define KDTREE2_QUERY_CHUNK		1024
 
+// k-d tree stored implicitly in arrays: node n
+// has children 2n+1 and 2n+2, the tree is
+// balanced down to leaves of at most 16 points.
+// every leaf owns a 16 point block of the SoA
+// position streams, unused slots lie at infinity.
 class eGenericKDTree {
 public:
-	class Entry {
-	public:
-		eVector3	m_position;
-		const void*	m_leaf;
-	};
-
-	typedef struct Node {
-		eU32			m_children[2];
-		Node*			m_parent;
-		eU32			m_leafStartIdx;
-		eU32			m_leafCnt;
-		eF32			m_splitVal;
-	};
-
-	eU32 randomSeed;
-	eGenericKDTree();
-	void clear();
-	void add(const eVector3& position, const void* value);
-	void remove(const void* val, Node& node);
-	void finishLoading();
-	eU32 findKAndSort(eU32 axis, eU32 start, eU32 len, eU32 rank);
-	eU32 splitLeafs(Node* parent, eU32 axis, eU32 start, eU32 len);
-
 	typedef struct Result {
 		eF32			distanceSqr;
-		const void*		t;
-		Node*			node;
+		eU32			index;
 	};
 
-	void getKNearest(eArray<Result>& results, eU32 k, const eVector3& position);
+	eGenericKDTree();
+	void build(const eArray<eVector3>& positions);
+	void remove(eU32 index);
+
+	// results are sorted by distance, returns
+	// the number of points found (at most k)
+	eU32 getKNearest(Result* results, eU32 k, const eVector3& position) const;
+	// k results per position, missing ones have
+	// index KDTREE2_NO_INDEX. runs on the job pool.
+	void queryKNearest(const eArray<eVector3>& positions, eU32 k, eArray<Result>& results) const;
 
 private:
+	typedef struct BuildJob {
+		eGenericKDTree*		tree;
+		const eArray<eVector3>*	positions;
+		eU32				first;
+	};
+
+	typedef struct QueryJob {
+		const eGenericKDTree*	tree;
+		const eArray<eVector3>*	positions;
+		eU32					k;
+		Result*					results;
+	};
 
-	void getKNearest(Node& node, eArray<Result>& results, eU32& numRes, eU32 axis, eU32 k, const eVector3& position, eF32& maxElementDistanceSqr);
+	void getNodeRange(eU32 node, eU32& start, eU32& end) const;
+	static void splitNode(ePtr arg, eU32 index);
+	static void fillLeaf(ePtr arg, eU32 index);
+	static void queryChunk(ePtr arg, eU32 index);
 
-	eArray<Node>	m_nodeArray;
-	eArray<Entry>	m_leafs;
-	eArray<Entry>	m_leafsBuffer;
+	eU32			m_count;
+	eU32			m_numLeafs;
+	eArray<eF32>	m_splitValues;
+	eArray<eU32>	m_splitAxes;
+	eArray<eU32>	m_counts;		// points left in subtree
+	eArray<eU32>	m_order;		// point indices while building
+	eArray<eF32>	m_x;
+	eArray<eF32>	m_y;
+	eArray<eF32>	m_z;
+	eArray<eU32>	m_indices;		// point index per slot
+	eArray<eU32>	m_slots;		// slot per point index
 };
 
 #endif // GENERIC_KDTREE_HPP
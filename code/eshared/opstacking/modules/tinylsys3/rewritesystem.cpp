@@ -28,8 +28,9 @@ void eRewriteSystem::readRules(const eString& ruleString) {
 	// clear rules
 	for(eU32 i = 0; i < 256; i++)
 		m_rules[i].clear();
-
-	m_ruleString = ruleString;
+	m_successors.clear();
+	m_code.clear();
+	m_stackDepth = 0;
 
 	eU32 pos = 0;
 	// read rules
@@ -37,16 +38,37 @@ void eRewriteSystem::readRules(const eString& ruleString) {
 		Rule r;
 		// read rule axiom symbol
 		eU32 axSym = ruleString[pos++];
-		r.conditionStart = pos;
-		while(ruleString[pos] != LSYS3_RULE_SEPARATOR)
-			pos++;
-		r.conditionEnd = pos;
-		r.prodStart = ++pos;
+		eU32 conditionStart = pos;
 		while(ruleString[pos] != LSYS3_RULE_SEPARATOR)
 			pos++;
-		r.prodEnd = pos++;
+		compileValInstanciation(ruleString, conditionStart, pos, r.condition);
+
+		// read successors
+		eU32 prodEnd = ++pos;
+		while(ruleString[prodEnd] != LSYS3_RULE_SEPARATOR)
+			prodEnd++;
+		r.firstSuccessor = m_successors.size();
+		while(pos < prodEnd) {
+			Successor& succ = m_successors.append();
+			succ.symbol = ruleString[pos++];
+			succ.code = LSYS3_NO_CODE;
+			if((pos < prodEnd - 1) && (ruleString[pos] == '('))
+				pos = compileValInstanciation(ruleString, pos, prodEnd, succ.code);
+		}
+		r.numSuccessors = m_successors.size() - r.firstSuccessor;
+		pos = prodEnd + 1;
 		m_rules[axSym].append(r);
 	}
+
+	// nesting too deep for execute()'s stack,
+	// reject the rules so nothing is rewritten
+	if(m_stackDepth > LSYS3_STACK_SIZE) {
+		for(eU32 i = 0; i < 256; i++)
+			m_rules[i].clear();
+		m_successors.clear();
+		m_code.clear();
+		m_stackDepth = 0;
+	}
 };
 
 void eRewriteSystem::apply(const eRewriteSystem::SymInstance& axiom, eArray<eRewriteSystem::SymInstance>& result, eU32 iterations, eU32 randomSeed) {
@@ -56,82 +78,215 @@ void eRewriteSystem::apply(const eRewriteSystem::SymInstance& axiom, eArray<eRew
 	eArray<SymInstance>* prevProd = &m_buf0;
 	eArray<SymInstance>* curProd  = &m_buf1;
 	curProd->append(axiom);
+
+	eU32 maxRules = 0;
+	for(eU32 i = 0; i < 256; i++)
+		maxRules = eMax(maxRules, m_rules[i].size());
+
 	for(eU32 it = 0; it < iterations; it++) {
 		eSwap(prevProd, curProd);
-		curProd->clear();
-		for(eU32 p = 0; p < prevProd->size(); p++) {
-			SymInstance& curSym = (*prevProd)[p];
-			eArray<Rule>& rules = m_rules[curSym.symbol];
-			if(rules.size() == 0) {
-				// copy symbol
-				curProd->append(curSym);
-			} else {
-				// find rule
-				ruleProbabilities.clear();
-				eF32 probSum = 0.0f;
-				for(eU32 i = 0; i < rules.size(); i++) {
-					Rule& rule = rules[i];
-					// calculate probability
-					SymInstance test = NewSymInstance(0, nullptr, 0);
-					eU32 pos = readValInstanciation(m_ruleString, rule.conditionStart, rule.conditionEnd, test.params, curSym.params);
-					eF32 probability = test.params[0];
-					ruleProbabilities.append(probability);
-					probSum += probability;
-				}
+		const eU32 numChunks = (prevProd->size() + LSYS3_CHUNK_SIZE - 1) / LSYS3_CHUNK_SIZE;
+		m_chunks.resize(numChunks);
+		m_choices.resize(prevProd->size());
+		m_probabilities.resize(prevProd->size() * maxRules);
+		m_probSums.resize(prevProd->size());
 
-				if(probSum == 0.0f) {
-					// no rule applies, just copy
-					curProd->append(curSym);
-				} else {
-					// apply random rule
-					eF32 r = eRandomF(localRanSeed) * probSum;
-					eF32 p = 0.0f;
-					eU32 ridx = 0;
-					while(ridx < ruleProbabilities.size()) {
-						p += ruleProbabilities[ridx];
-						if(p > r) {
-							// this rule will be applied
-							Rule& rule = rules[ridx];
-							eU32 pos = rule.prodStart;
-							while(pos < rule.prodEnd) {
-								curProd->append(NewSymInstance(m_ruleString[pos++], nullptr, 0));
-								SymInstance& nsym = curProd->last();
-								if((pos < rule.prodEnd - 1) && (m_ruleString[pos] == '('))
-									pos = readValInstanciation(m_ruleString, pos, rule.prodEnd, nsym.params, curSym.params);
-							}
-							break;
-						}
-						ridx++;
+		RewriteJob job;
+		job.rs = this;
+		job.prevProd = prevProd;
+		job.curProd = curProd;
+		job.iteration = it;
+		job.randomSeed = randomSeed;
+		job.maxRules = maxRules;
+
+		// rules are chosen with one random sequence
+		// in symbol order, like a serial rewrite.
+		// chunks jump ahead to their first number.
+		// the rule probabilities are evaluated while
+		// counting and kept for choosing the rules.
+		eJobPool::getDefault().run(countDraws, &job, numChunks);
+		for(eU32 i = 0; i < numChunks; i++) {
+			m_chunks[i].seed = localRanSeed;
+			localRanSeed = jumpSeed(localRanSeed, m_chunks[i].numDraws);
+		}
+		eJobPool::getDefault().run(chooseRules, &job, numChunks);
+
+		eU32 length = 0;
+		for(eU32 i = 0; i < numChunks; i++) {
+			m_chunks[i].offset = length;
+			length += m_chunks[i].length;
+		}
+		curProd->resize(length);
+		eJobPool::getDefault().run(writeProductions, &job, numChunks);
+	}
+	// copy curProd to result
+	result.append(*curProd);
+}
+
+void eRewriteSystem::countDraws(ePtr arg, eU32 index) {
+	const RewriteJob& job = *(RewriteJob*)arg;
+	const eArray<SymInstance>& prevProd = *job.prevProd;
+	const eU32 start = index * LSYS3_CHUNK_SIZE;
+	const eU32 end = eMin(start + LSYS3_CHUNK_SIZE, prevProd.size());
+	eRewriteSystem& rs = *job.rs;
+	eU32 numDraws = 0;
+	for(eU32 p = start; p < end; p++) {
+		const SymInstance& curSym = prevProd[p];
+		if(!rs.m_rules[curSym.symbol].isEmpty()) {
+			eU32 opSeed = operatorSeed(job.randomSeed, job.iteration, p, 0);
+			rs.m_probSums[p] = rs.ruleProbabilities(curSym, opSeed, &rs.m_probabilities[p * job.maxRules]);
+			if(rs.m_probSums[p] != 0.0f)
+				numDraws++;
+		}
+	}
+	job.rs->m_chunks[index].numDraws = numDraws;
+}
+
+void eRewriteSystem::chooseRules(ePtr arg, eU32 index) {
+	const RewriteJob& job = *(RewriteJob*)arg;
+	const eArray<SymInstance>& prevProd = *job.prevProd;
+	Chunk& chunk = job.rs->m_chunks[index];
+	const eU32 start = index * LSYS3_CHUNK_SIZE;
+	const eU32 end = eMin(start + LSYS3_CHUNK_SIZE, prevProd.size());
+	eU32 localRanSeed = chunk.seed;
+	chunk.length = 0;
+	for(eU32 p = start; p < end; p++) {
+		const SymInstance& curSym = prevProd[p];
+		const eArray<Rule>& rules = job.rs->m_rules[curSym.symbol];
+		eU32& choice = job.rs->m_choices[p];
+		choice = LSYS3_COPY_SYMBOL;
+		if(!rules.isEmpty()) {
+			const eF32 probSum = job.rs->m_probSums[p];
+			const eF32* probabilities = &job.rs->m_probabilities[p * job.maxRules];
+			if(probSum != 0.0f) {
+				// choose random rule, none if probabilities
+				// are negative
+				eF32 r = eRandomF(localRanSeed) * probSum;
+				eF32 sum = 0.0f;
+				choice = LSYS3_DROP_SYMBOL;
+				for(eU32 ridx = 0; ridx < rules.size(); ridx++) {
+					sum += probabilities[ridx];
+					if(sum > r) {
+						choice = ridx;
+						chunk.length += rules[ridx].numSuccessors;
+						break;
 					}
 				}
+				continue;
+			}
+		}
+		// no rule applies, just copy
+		chunk.length++;
+	}
+}
+
+void eRewriteSystem::writeProductions(ePtr arg, eU32 index) {
+	const RewriteJob& job = *(RewriteJob*)arg;
+	const eRewriteSystem& rs = *job.rs;
+	const eArray<SymInstance>& prevProd = *job.prevProd;
+	const eU32 start = index * LSYS3_CHUNK_SIZE;
+	const eU32 end = eMin(start + LSYS3_CHUNK_SIZE, prevProd.size());
+	if(rs.m_chunks[index].length == 0)
+		return;
+
+	SymInstance* out = &(*job.curProd)[rs.m_chunks[index].offset];
+	for(eU32 p = start; p < end; p++) {
+		const SymInstance& curSym = prevProd[p];
+		const eU32 choice = rs.m_choices[p];
+		if(choice == LSYS3_COPY_SYMBOL)
+			*out++ = curSym;
+		else if(choice != LSYS3_DROP_SYMBOL) {
+			// apply rule
+			const Rule& rule = rs.m_rules[curSym.symbol][choice];
+			eU32 opSeed = operatorSeed(job.randomSeed, job.iteration, p, 1);
+			for(eU32 s = 0; s < rule.numSuccessors; s++) {
+				const Successor& succ = rs.m_successors[rule.firstSuccessor + s];
+				*out = NewSymInstance(succ.symbol, nullptr, 0);
+				if(succ.code != LSYS3_NO_CODE)
+					rs.execute(succ.code, out->params, curSym.params, opSeed);
+				out++;
 			}
 		}
 	}
-	// copy curProd to result
-	result.append(*curProd);
 }
 
+// calculates the probabilities of all rules
+// for the symbol, returns their sum
+eF32 eRewriteSystem::ruleProbabilities(const SymInstance& sym, eU32 opSeed, eF32* probabilities) const {
+	const eArray<Rule>& rules = m_rules[sym.symbol];
+	eF32 probSum = 0.0f;
+	for(eU32 i = 0; i < rules.size(); i++) {
+		const Rule& rule = rules[i];
+		eF32 probability = 1.0f;
+		if(rule.condition != LSYS3_NO_CODE) {
+			SymInstance test = NewSymInstance(0, nullptr, 0);
+			execute(rule.condition, test.params, sym.params, opSeed);
+			probability = test.params[0];
+		}
+		probabilities[i] = probability;
+		probSum += probability;
+	}
+	return probSum;
+}
 
+// seed for the random operator while rewriting
+// a single symbol, so it doesn't depend on the
+// order symbols are rewritten in
+eU32 eRewriteSystem::operatorSeed(eU32 randomSeed, eU32 iteration, eU32 index, eU32 stream) {
+	eU32 h = randomSeed;
+	const eU32 keys[] = {iteration, index, stream};
+	for(eU32 i = 0; i < 3; i++) {
+		h ^= keys[i] + 0x9e3779b9 + (h << 6) + (h >> 2);
+		h ^= h >> 16;
+		h *= 0x7feb352d;
+		h ^= h >> 15;
+		h *= 0x846ca68b;
+		h ^= h >> 16;
+	}
+	// park-miller seeds have to be in 1,..,m-1
+	return h % 0x7ffffffe + 1;
+}
+
+// advances a park-miller seed by the given number
+// of steps: seed*16807^steps mod (2^31-1)
+eU32 eRewriteSystem::jumpSeed(eU32 seed, eU32 steps) {
+	const eU64 m = 0x7fffffff;
+	eU64 mul = 16807;
+	eU64 res = seed;
+	while(steps) {
+		if(steps & 1)
+			res = (res * mul) % m;
+		mul = (mul * mul) % m;
+		steps >>= 1;
+	}
+	return (eU32)res;
+}
 
-// calculates the expression in the string
-// returns the position after second number
-eS32 eRewriteSystem::calculateTerm(const eString& s, int start, int end, const eF32* params, eF32& result) {
+
+
+// compiles the expression in the string
+// returns the position after second number.
+// terms are evaluated strictly from left to
+// right, nested terms in source order before.
+eS32 eRewriteSystem::compileTerm(const eString& s, int start, int end, eU32 depth) {
 	int pos = start;
-	eF32 tuple[] = {0,0,0,0,0,0,0,0,0,0};
-	eU32 ops[] = {0,0,0,0,0,0,0,0,0,0};
-	eU32 tpos = 0;
-	eU32 opPos = 0;
+	eArray<eU32> ops;
+	eBool assigned = eFALSE; // current operand has a value
 	eU32 c;
 	while((pos < end) && ((c = s[pos]) != ',') && (c != ')')) {
 		if(c == '(') {
-			pos = calculateTerm(s, pos + 1, end, params, tuple[tpos]);
+			if(assigned)
+				dropValue();
+			pos = compileTerm(s, pos + 1, end, depth + ops.size());
 			eASSERT(pos != -1);
+			assigned = eTRUE;
 			pos++;
 		} else {
 			eS32 oldPos = pos;
 			// try to read constant
 			eF32 number = 0;
 			eF32 v = 1.0f;
+			eBool isNumber = eFALSE;
 			while(pos < end) {
 				int cc = s[pos] - '0';
 				if(cc == '.' - '0')
@@ -143,71 +298,134 @@ eS32 eRewriteSystem::calculateTerm(const eString& s, int start, int end, const e
 							number += v * cc;
 							v /= 10.0f;
 						}
-					tuple[tpos] = number;
+					isNumber = eTRUE;
 				}
 				else break;
 				pos++;
 			}
+			if(isNumber) {
+				if(assigned)
+					dropValue();
+				emit(OP_CONST, 0, number);
+				assigned = eTRUE;
+			}
  			// try to read symbol
 			for(eU32 i = 0; i < LSYS3_NUM_PARAMS; i++)
 				if('a' + i == c) {
-					tuple[tpos] = params[i];
+					if(assigned)
+						dropValue();
+					emit(OP_PARAM, i, 0.0f);
+					assigned = eTRUE;
 					pos++;
 				}
 			if(pos == oldPos) {
 				// is an operator
 				pos++;  
-				ops[opPos++] = c;	
-				tpos++;
+				if(!assigned)
+					emit(OP_CONST, 0, 0.0f);
+				ops.append(c);
+				assigned = eFALSE;
 			};
 		}
 	}
 
-	result = tuple[0];
-	for(eU32 o = 0; o < opPos; o++) {
-		eU32 op = ops[o];
-		eF32 t0 = result;
-		eF32 t1 = tuple[o + 1];
-		switch(op) {
-		case '+': result = t0 + t1; break;
-		case '-': result = t0 - t1; break;
-		case '*': result = t0 * t1; break;
-		case '/': result = t0 / t1; break;
-		case '<': result = (t0 < t1) ? 1.0f : 0.0f; break;
-		case '=': result = (t0 == t1) ? 1.0f : 0.0f; break;
-		case '>': result = (t0 > t1) ? 1.0f : 0.0f; break;
-		case '_': result = (t0 <= t1) ? 1.0f : 0.0f; break;
-		case '~': result = t0 * eSin(t1); break;
-		case '#': result = t0 + eRandomF() * t1; break;
-		case '^': 
-			result = ePow(t0, t1); break;
-		default:
-			result = t0; // single term
-		}
+	if(!assigned)
+		emit(OP_CONST, 0, 0.0f);
+	if(!ops.isEmpty()) {
+		emit(OP_FOLD, ops.size(), 0.0f);
+		for(eU32 o = 0; o < ops.size(); o++)
+			emit(OP_OPERATOR, ops[o], 0.0f);
 	}
+	m_stackDepth = eMax(m_stackDepth, depth + ops.size() + 1);
 	return pos;
 }
 
-eS32 eRewriteSystem::readValInstanciation(const eString& s, int start, int end, eF32* params, const eF32* prevParams) {
+eS32 eRewriteSystem::compileValInstanciation(const eString& s, int start, int end, eU32& code) {
 	int pos = start;
-	int v = 0;
+	eU32 v = 0;
 
+	code = LSYS3_NO_CODE;
 	if((pos >= end) || (s[pos] != '(')) {
 		return pos;
 	} else {
+		code = m_code.size();
 		pos++;
 		while((pos < end) && (s[pos] != ')')) {
 			if(s[pos] == ',') {
 				pos++;
 				continue;
 			}
-			pos = calculateTerm(s, pos, end, prevParams, params[v++]); 
+			pos = compileTerm(s, pos, end, 0);
 			eASSERT(pos != -1);
+			if(v < LSYS3_NUM_PARAMS)
+				emit(OP_STORE, v++, 0.0f);
+			else
+				emit(OP_DROP, 0, 0.0f);
 		}
+		emit(OP_END, 0, 0.0f);
 	}
 	return pos + 1;
 }
 
+void eRewriteSystem::emit(eU32 opcode, eU32 arg, eF32 value) {
+	Instruction& ins = m_code.append();
+	ins.opcode = opcode;
+	ins.arg = arg;
+	ins.value = value;
+}
+
+// an overwritten operand only has to be
+// evaluated if it has side effects
+void eRewriteSystem::dropValue() {
+	const eU32 last = m_code.last().opcode;
+	if((last == OP_CONST) || (last == OP_PARAM))
+		m_code.removeLast();
+	else
+		emit(OP_DROP, 0, 0.0f);
+}
+
+void eRewriteSystem::execute(eU32 code, eF32* params, const eF32* prevParams, eU32& opSeed) const {
+	eF32 stack[LSYS3_STACK_SIZE];
+	eU32 sp = 0;
+	for(const Instruction* ins = &m_code[code]; ins->opcode != OP_END; ins++) {
+		switch(ins->opcode) {
+		case OP_CONST: stack[sp++] = ins->value; break;
+		case OP_PARAM: stack[sp++] = prevParams[ins->arg]; break;
+		case OP_DROP: sp--; break;
+		case OP_STORE: params[ins->arg] = stack[--sp]; break;
+		case OP_FOLD: {
+			const eU32 count = ins->arg;
+			sp -= count;
+			eF32 result = stack[sp - 1];
+			for(eU32 o = 0; o < count; o++)
+				result = operate((++ins)->arg, result, stack[sp + o], opSeed);
+			stack[sp - 1] = result;
+			break;
+		}
+		default:
+			eASSERT(eFALSE);
+		}
+	}
+}
+
+eF32 eRewriteSystem::operate(eU32 op, eF32 t0, eF32 t1, eU32& opSeed) {
+	switch(op) {
+	case '+': return t0 + t1;
+	case '-': return t0 - t1;
+	case '*': return t0 * t1;
+	case '/': return t0 / t1;
+	case '<': return (t0 < t1) ? 1.0f : 0.0f;
+	case '=': return (t0 == t1) ? 1.0f : 0.0f;
+	case '>': return (t0 > t1) ? 1.0f : 0.0f;
+	case '_': return (t0 <= t1) ? 1.0f : 0.0f;
+	case '~': return t0 * eSin(t1);
+	case '#': return t0 + eRandomF(opSeed) * t1;
+	case '^': return ePow(t0, t1);
+	default:
+		return t0; // single term
+	}
+}
+
 #ifdef eEDITOR
 eString eRewriteSystem::toString(eArray<eRewriteSystem::SymInstance>& r, eBool withParams) {
 	eString s = "";
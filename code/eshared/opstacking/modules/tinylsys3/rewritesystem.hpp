@@ -19,6 +19,11 @@
 
 #define LSYS3_NUM_PARAMS 8
 #define LSYS3_RULE_SEPARATOR ';'
+#define LSYS3_STACK_SIZE 64
+#define LSYS3_NO_CODE 0xffffffff
+#define LSYS3_CHUNK_SIZE 4096
+#define LSYS3_COPY_SYMBOL 0xffffffff
+#define LSYS3_DROP_SYMBOL 0xfffffffe
 
 class eRewriteSystem {
 public:
@@ -27,27 +32,88 @@ public:
 		eF32 params[LSYS3_NUM_PARAMS];
 	};
 
+	// rule conditions and parameter instanciations
+	// are compiled by readRules() into code for a
+	// small stack machine, so apply() doesn't touch
+	// the rule string at all.
+	enum Opcode {
+		OP_END,
+		OP_CONST,		// push value
+		OP_PARAM,		// push parameter arg of the predecessor
+		OP_DROP,		// discard top of stack
+		OP_FOLD,		// fold arg+1 values from left to right with the arg OP_OPERATORs following
+		OP_OPERATOR,	// arg is the operator character
+		OP_STORE		// pop into parameter arg
+	};
+
+	typedef struct Instruction {
+		eU16 opcode;
+		eU16 arg;
+		eF32 value;
+	};
+
+	typedef struct Successor {
+		eU32 symbol;
+		eU32 code;
+	};
+
 	typedef struct Rule {
-		eU32 conditionStart;
-		eU32 conditionEnd;
-		eU32 prodStart;
-		eU32 prodEnd;
+		eU32 condition;
+		eU32 firstSuccessor;
+		eU32 numSuccessors;
 	};
 
-	eString			m_ruleString;
-	eArray<Rule>	m_rules[256];
-	eArray<eF32> ruleProbabilities;
+	// predecessors are rewritten in chunks. all
+	// chunks count their random numbers, choose
+	// their rules and then write the productions
+	// at the prefix sum of the production lengths.
+	typedef struct Chunk {
+		eU32 numDraws;
+		eU32 seed;
+		eU32 length;
+		eU32 offset;
+	};
+
+	typedef struct RewriteJob {
+		eRewriteSystem*				rs;
+		const eArray<SymInstance>*	prevProd;
+		eArray<SymInstance>*		curProd;
+		eU32						iteration;
+		eU32						randomSeed;
+		eU32						maxRules;
+	};
+
+	eArray<Rule>		m_rules[256];
+	eArray<Successor>	m_successors;
+	eArray<Instruction>	m_code;
+	eU32				m_stackDepth;
+	eArray<Chunk>		m_chunks;
+	eArray<eU32>		m_choices;		// applied rule per predecessor
+	eArray<eF32>		m_probabilities;	// rule probabilities per predecessor, maxRules apart
+	eArray<eF32>		m_probSums;		// their sum per predecessor
 	eArray<SymInstance>		m_buf0, m_buf1;
 
 	static SymInstance NewSymInstance(eU32 c, const eF32* params, eU32 cnt);
 	void readRules(const eString& ruleString);
 	void apply(const SymInstance& axiom, eArray<SymInstance>& result, eU32 iterations, eU32 randomSeed);
 
-	// calculates the expression in the string
-	// returns the position after second number
-	static eS32 calculateTerm(const eString& s, int start, int end, const eF32* params, eF32& result);
-	static eS32 readValInstanciation(const eString& s, int start, int end, eF32* params, const eF32* prevParams);
 	static eString toString(eArray<SymInstance>& r, eBool withParams);
+
+private:
+	// compiles the expression in the string
+	// returns the position after second number
+	eS32 compileTerm(const eString& s, int start, int end, eU32 depth);
+	eS32 compileValInstanciation(const eString& s, int start, int end, eU32& code);
+	void emit(eU32 opcode, eU32 arg, eF32 value);
+	void dropValue();
+	void execute(eU32 code, eF32* params, const eF32* prevParams, eU32& opSeed) const;
+	eF32 ruleProbabilities(const SymInstance& sym, eU32 opSeed, eF32* probabilities) const;
+	static eF32 operate(eU32 op, eF32 t0, eF32 t1, eU32& opSeed);
+	static eU32 operatorSeed(eU32 randomSeed, eU32 iteration, eU32 index, eU32 stream);
+	static eU32 jumpSeed(eU32 seed, eU32 steps);
+	static void countDraws(ePtr arg, eU32 index);
+	static void chooseRules(ePtr arg, eU32 index);
+	static void writeProductions(ePtr arg, eU32 index);
 };
 
 #endif // REWRITESYSTEM_HPP
\ No newline at end of file
@@ -0,0 +1,314 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *   This file is part of
+ *       ______        _                             __ __
+ *      / ____/____   (_)____ _ ____ ___   ____ _   / // /
+ *     / __/  / __ \ / // __ `// __ `__ \ / __ `/  / // /_
+ *    / /___ / / / // // /_/ // / / / / // /_/ /  /__  __/
+ *   /_____//_/ /_//_/ \__, //_/ /_/ /_/ \__,_/     /_/.   
+ *                    /____/                              
+ *
+ *   Copyright  2003-2012 Brain Control, all rights reserved.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "../../../eshared.hpp"
+#include "spatialgrid.hpp"
+
+static const eU32 NO_POINT = eU32_MAX;
+static const eInt MAX_CELL = 1 << 20;
+
+// cell coordinates are clamped to +-2^20 (like
+// the weld cells of eEditMesh), so huge or non
+// finite positions can't overflow eInt. points
+// beyond share the border cells.
+static eInt clampCell(eF32 x) {
+	if(!(x >= (eF32)-MAX_CELL)) // also true for nan
+		return -MAX_CELL;
+	if(x > (eF32)MAX_CELL)
+		return MAX_CELL;
+	return eFloor(x);
+}
+
+eSpatialGrid::eSpatialGrid() {
+	clear(1.0f, 0);
+}
+
+void eSpatialGrid::clear(eF32 cellSize, eU32 expectedCount) {
+	eASSERT(cellSize > 0.0f);
+	m_cellSize = cellSize;
+	m_cellSizeInv = 1.0f / cellSize;
+	m_next.clear();
+	m_prev.clear();
+	m_positions.clear();
+	m_cells.clear();
+	m_next.reserve(expectedCount);
+	m_prev.reserve(expectedCount);
+	m_positions.reserve(expectedCount);
+	m_cells.reserve(expectedCount);
+	m_min.x = m_min.y = m_min.z = eS32_MAX;
+	m_max.x = m_max.y = m_max.z = eS32_MIN;
+	m_boundsDirty = eFALSE;
+
+	// about two buckets per point keeps the
+	// number of foreign cells per bucket low
+	eU32 bucketCount = 1024;
+	while(bucketCount < expectedCount * 2)
+		bucketCount <<= 1;
+	rehash(bucketCount);
+}
+
+eU32 eSpatialGrid::add(const eVector3& position) {
+	const eU32 index = m_positions.size();
+	m_positions.append(position);
+	m_cells.append(getCell(position));
+	m_next.append(NO_POINT);
+	m_prev.append(NO_POINT);
+
+	if(m_positions.size() * 2 > m_buckets.size())
+		rehash(m_buckets.size() * 2);
+	else
+		link(index);
+	return index;
+}
+
+// only points changing their cell are relinked
+void eSpatialGrid::update(eU32 index, const eVector3& position) {
+	eASSERT(index < m_positions.size());
+	m_positions[index] = position;
+
+	const Cell cell = getCell(position);
+	const Cell& old = m_cells[index];
+	if(cell.x == old.x && cell.y == old.y && cell.z == old.z)
+		return;
+
+	if(old.x == m_min.x || old.y == m_min.y || old.z == m_min.z ||
+	   old.x == m_max.x || old.y == m_max.y || old.z == m_max.z)
+		m_boundsDirty = eTRUE;
+
+	unlink(index);
+	m_cells[index] = cell;
+	link(index);
+}
+
+// update() only grows the range of occupied
+// cells. call this after moving the points, so
+// queries don't scan cells which were left.
+void eSpatialGrid::updateBounds() {
+	if(!m_boundsDirty)
+		return;
+
+	m_min.x = m_min.y = m_min.z = eS32_MAX;
+	m_max.x = m_max.y = m_max.z = eS32_MIN;
+	for(eU32 i = 0; i < m_cells.size(); i++)
+		growBounds(m_cells[i]);
+	m_boundsDirty = eFALSE;
+}
+
+eU32 eSpatialGrid::getCount() const {
+	return m_positions.size();
+}
+
+eF32 eSpatialGrid::getCellSize() const {
+	return m_cellSize;
+}
+
+// returns if any point lies closer than radius
+eBool eSpatialGrid::isOccupied(const eVector3& position, eF32 radius) const {
+	const eF32 radiusSqr = radius * radius;
+	const Cell lo = getCell(position - eVector3(radius));
+	const Cell hi = getCell(position + eVector3(radius));
+
+	for(eInt z = eMax(lo.z, m_min.z); z <= eMin(hi.z, m_max.z); z++)
+		for(eInt y = eMax(lo.y, m_min.y); y <= eMin(hi.y, m_max.y); y++)
+			for(eInt x = eMax(lo.x, m_min.x); x <= eMin(hi.x, m_max.x); x++) {
+				const Cell cell = {x, y, z};
+				for(eU32 i = m_buckets[getBucket(cell)]; i != NO_POINT; i = m_next[i]) {
+					const Cell& c = m_cells[i];
+					if(c.x != x || c.y != y || c.z != z)
+						continue;
+
+					if((m_positions[i] - position).sqrLength() < radiusSqr)
+						return eTRUE;
+				}
+			}
+	return eFALSE;
+}
+
+void eSpatialGrid::getInRadius(eArray<Result>& results, const eVector3& position, eF32 radius) const {
+	results.clear();
+	const eF32 radiusSqr = radius * radius;
+	const Cell lo = getCell(position - eVector3(radius));
+	const Cell hi = getCell(position + eVector3(radius));
+
+	for(eInt z = eMax(lo.z, m_min.z); z <= eMin(hi.z, m_max.z); z++)
+		for(eInt y = eMax(lo.y, m_min.y); y <= eMin(hi.y, m_max.y); y++)
+			for(eInt x = eMax(lo.x, m_min.x); x <= eMin(hi.x, m_max.x); x++) {
+				const Cell cell = {x, y, z};
+				for(eU32 i = m_buckets[getBucket(cell)]; i != NO_POINT; i = m_next[i]) {
+					const Cell& c = m_cells[i];
+					if(c.x != x || c.y != y || c.z != z)
+						continue;
+
+					const eF32 distanceSqr = (m_positions[i] - position).sqrLength();
+					if(distanceSqr < radiusSqr) {
+						Result& r = results.append();
+						r.distanceSqr = distanceSqr;
+						r.index = i;
+					}
+				}
+			}
+}
+
+// visits shells of cells around the position's
+// cell with growing radius. after shell r all
+// points closer than r cells are known, so the
+// search stops as soon as the k-th result is
+// closer than that (or all cells were visited).
+// results are sorted by distance, ties by index.
+// if the shells walk more cells than there are
+// points (far away positions or a sparse range)
+// all points are tested instead.
+void eSpatialGrid::getKNearest(eArray<Result>& results, eU32 k, const eVector3& position) const {
+	results.clear();
+	if(k == 0 || m_positions.isEmpty())
+		return;
+
+	const Cell center = getCell(position);
+
+	// shells closer than the occupied range are
+	// empty, so far away positions start at it
+	const eInt first = eMax(eMax(eMax(m_min.x - center.x, center.x - m_max.x),
+								 eMax(m_min.y - center.y, center.y - m_max.y)),
+							eMax(eMax(m_min.z - center.z, center.z - m_max.z), 0));
+
+	const eInt loX = m_min.x - center.x;
+	const eInt hiX = m_max.x - center.x;
+	eU32 work = 0;
+
+	for(eInt r = first; ; r++) {
+		for(eInt dz = eMax(-r, m_min.z - center.z); dz <= eMin(r, m_max.z - center.z); dz++) {
+			const eInt z = center.z + dz;
+
+			for(eInt dy = eMax(-r, m_min.y - center.y); dy <= eMin(r, m_max.y - center.y); dy++) {
+				const eInt y = center.y + dy;
+
+				// inside the shell only the two outer
+				// cells of each row have to be visited
+				const eBool fullRow = (dz == -r || dz == r || dy == -r || dy == r);
+				const eInt step = (fullRow || r == 0) ? 1 : 2 * r;
+				const eInt dxFirst = (fullRow ? eMax(-r, loX) : (-r >= loX ? -r : r));
+				const eInt dxLast = eMin(r, hiX);
+
+				for(eInt dx = dxFirst; dx <= dxLast; dx += step) {
+					const Cell cell = {center.x + dx, y, z};
+					visitCell(results, k, cell, position);
+					work++;
+				}
+
+				if(++work > m_positions.size()) {
+					results.clear();
+					for(eU32 i = 0; i < m_positions.size(); i++)
+						insertResult(results, k, i, (m_positions[i] - position).sqrLength());
+					return;
+				}
+			}
+		}
+
+		const eBool coversAll = (center.x - r <= m_min.x && center.x + r >= m_max.x &&
+								 center.y - r <= m_min.y && center.y + r >= m_max.y &&
+								 center.z - r <= m_min.z && center.z + r >= m_max.z);
+		if(coversAll)
+			break;
+		if(results.size() == k && results[k - 1].distanceSqr <= eSqr((eF32)r * m_cellSize))
+			break;
+	}
+}
+
+eSpatialGrid::Cell eSpatialGrid::getCell(const eVector3& position) const {
+	const Cell cell = {
+		clampCell(position.x * m_cellSizeInv),
+		clampCell(position.y * m_cellSizeInv),
+		clampCell(position.z * m_cellSizeInv)
+	};
+	return cell;
+}
+
+eU32 eSpatialGrid::getBucket(const Cell& cell) const {
+	const eU32 h = ((eU32)cell.x * 73856093) ^ ((eU32)cell.y * 19349663) ^ ((eU32)cell.z * 83492791);
+	return h & m_bucketMask;
+}
+
+void eSpatialGrid::growBounds(const Cell& cell) {
+	m_min.x = eMin(m_min.x, cell.x);
+	m_min.y = eMin(m_min.y, cell.y);
+	m_min.z = eMin(m_min.z, cell.z);
+	m_max.x = eMax(m_max.x, cell.x);
+	m_max.y = eMax(m_max.y, cell.y);
+	m_max.z = eMax(m_max.z, cell.z);
+}
+
+void eSpatialGrid::link(eU32 index) {
+	const Cell& cell = m_cells[index];
+	growBounds(cell);
+
+	eU32& head = m_buckets[getBucket(cell)];
+	m_prev[index] = NO_POINT;
+	m_next[index] = head;
+	if(head != NO_POINT)
+		m_prev[head] = index;
+	head = index;
+}
+
+void eSpatialGrid::unlink(eU32 index) {
+	const eU32 prev = m_prev[index];
+	const eU32 next = m_next[index];
+
+	if(prev != NO_POINT)
+		m_next[prev] = next;
+	else
+		m_buckets[getBucket(m_cells[index])] = next;
+	if(next != NO_POINT)
+		m_prev[next] = prev;
+}
+
+void eSpatialGrid::rehash(eU32 bucketCount) {
+	m_buckets.resize(bucketCount);
+	m_bucketMask = bucketCount - 1;
+	for(eU32 i = 0; i < bucketCount; i++)
+		m_buckets[i] = NO_POINT;
+	for(eU32 i = 0; i < m_positions.size(); i++)
+		link(i);
+}
+
+void eSpatialGrid::visitCell(eArray<Result>& results, eU32 k, const Cell& cell, const eVector3& position) const {
+	for(eU32 i = m_buckets[getBucket(cell)]; i != NO_POINT; i = m_next[i]) {
+		// buckets are shared by several cells
+		const Cell& c = m_cells[i];
+		if(c.x != cell.x || c.y != cell.y || c.z != cell.z)
+			continue;
+
+		insertResult(results, k, i, (m_positions[i] - position).sqrLength());
+	}
+}
+
+// inserts sorted, dropping the farthest result
+void eSpatialGrid::insertResult(eArray<Result>& results, eU32 k, eU32 index, eF32 distanceSqr) const {
+	if(results.size() == k && !(distanceSqr < results[k - 1].distanceSqr ||
+		(distanceSqr == results[k - 1].distanceSqr && index < results[k - 1].index)))
+		return;
+
+	if(results.size() < k)
+		results.append();
+
+	eU32 rpos = results.size() - 1;
+	while(rpos > 0 && (results[rpos - 1].distanceSqr > distanceSqr ||
+		(results[rpos - 1].distanceSqr == distanceSqr && results[rpos - 1].index > index))) {
+		results[rpos] = results[rpos - 1];
+		rpos--;
+	}
+
+	Result& r = results[rpos];
+	r.distanceSqr = distanceSqr;
+	r.index = index;
+}
\ No newline at end of file
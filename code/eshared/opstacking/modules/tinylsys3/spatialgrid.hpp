@@ -0,0 +1,73 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *   This file is part of
+ *       ______        _                             __ __
+ *      / ____/____   (_)____ _ ____ ___   ____ _   / // /
+ *     / __/  / __ \ / // __ `// __ `__ \ / __ `/  / // /_
+ *    / /___ / / / // // /_/ // / / / / // /_/ /  /__  __/
+ *   /_____//_/ /_//_/ \__, //_/ /_/ /_/ \__,_/     /_/.   
+ *                    /____/                              
+ *
+ *   Copyright  2003-2012 Brain Control, all rights reserved.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef SPATIAL_GRID_HPP
+#define SPATIAL_GRID_HPP
+
+#include "../../../eshared.hpp"
+
+// uniform grid of cubic cells for radius and
+// k-nearest queries on points. cells are hashed
+// into buckets, each holding a doubly linked list
+// of its points, so points can be added and
+// moved in O(1) without rebuilding the grid.
+class eSpatialGrid {
+public:
+	struct Result {
+		eF32			distanceSqr;
+		eU32			index;
+	};
+
+	eSpatialGrid();
+	void clear(eF32 cellSize, eU32 expectedCount);
+	eU32 add(const eVector3& position);
+	void update(eU32 index, const eVector3& position);
+	void updateBounds();
+	eU32 getCount() const;
+	eF32 getCellSize() const;
+
+	eBool isOccupied(const eVector3& position, eF32 radius) const;
+	void getInRadius(eArray<Result>& results, const eVector3& position, eF32 radius) const;
+	void getKNearest(eArray<Result>& results, eU32 k, const eVector3& position) const;
+
+private:
+	struct Cell {
+		eInt			x;
+		eInt			y;
+		eInt			z;
+	};
+
+	Cell getCell(const eVector3& position) const;
+	eU32 getBucket(const Cell& cell) const;
+	void growBounds(const Cell& cell);
+	void link(eU32 index);
+	void unlink(eU32 index);
+	void rehash(eU32 bucketCount);
+	void visitCell(eArray<Result>& results, eU32 k, const Cell& cell, const eVector3& position) const;
+	void insertResult(eArray<Result>& results, eU32 k, eU32 index, eF32 distanceSqr) const;
+
+	eF32				m_cellSize;
+	eF32				m_cellSizeInv;
+	eU32				m_bucketMask;
+	eArray<eU32>		m_buckets;		// first point of bucket
+	eArray<eU32>		m_next;
+	eArray<eU32>		m_prev;
+	eArray<eVector3>	m_positions;
+	eArray<Cell>		m_cells;
+	Cell				m_min;			// range of occupied cells
+	Cell				m_max;
+	eBool				m_boundsDirty;	// a point left a border cell
+};
+
+#endif // SPATIAL_GRID_HPP
\ No newline at end of file
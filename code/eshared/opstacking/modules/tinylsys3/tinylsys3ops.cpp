@@ -17,6 +17,7 @@
 #include "rewritesystem.hpp"
 #include "turtleinterpreter.hpp"
 #include "attractor.hpp"
+#include "spatialgrid.hpp"
 
 eDEF_OPERATOR_SOURCECODE(LSYS);
 
@@ -346,6 +347,7 @@ eOP_DEF_MODEL(eModelSwarmOp, "Swarm", 'p', 1, 1, eOP_INPUTS(eOC_MESH))
 		m_lastSeed = 0;
 		m_lastTime = 0;
 		m_lastPopDistance = 0;
+		m_gridValid = eFALSE;
     }
 
 public:
@@ -357,6 +359,23 @@ public:
         eF32        size;
     };
 
+	struct tStepParams {
+		eF32		dt;
+		eF32		acceleration;
+		eF32		attraction;
+		eF32		hleveling;
+		eF32		collisionAvoidance;
+		eF32		cohesion;
+		eF32		alignment;
+		eF32		minDistSqr;
+		eF32		desiredAttrDist;
+		eF32		sightAngleCos;
+		eU32		flockSize;
+		eBool		attract;
+		eBool		consumeAttractors;
+		eBool		flock;
+	};
+
 //#define eSWARM_CALCULATION_FPS 60
 //#define eSWARM_TIMESTEP_S (1.0f / (eF32)eSWARM_CALCULATION_FPS) 
 
@@ -395,7 +414,6 @@ public:
 
 		eU32 numAttractorSamples = (attractorSamples == 0) ? countMax : attractorSamples;
 		eF32 minDistSqr = minDist * minDist;
-		eF32 popDistSqr = popDistance * popDistance;
 		eU32 ranSeed = seed;
 		m_models.clear();
 		m_models.append(&modelOp->getResult().sceneData);
@@ -420,6 +438,8 @@ public:
 			// reset entries
 			m_entries.clear();
 			m_entries.reserve(countMax);
+			if(popDistance > 0.0f)
+				m_grid.clear(popDistance, countMax);
 			for(eU32 i = 0; i < countMax; i++) {
 				tEntry& e = m_entries.append();
 				eVector3 normal;
@@ -437,12 +457,14 @@ public:
 				e.size = 1.0f - sizeVariation * eRandomF(ranSeed);
 
 				// test population distance
-				bool isnear = false;
-				for(eU32 k = 0; k < (m_entries.size() - 1); k++) 
-					isnear |= (e.position - m_entries[k].position).sqrLength() < popDistSqr;
-				if(isnear)
-					m_entries.resize(m_entries.size() - 1);
+				if(popDistance > 0.0f) {
+					if(m_grid.isOccupied(e.position, popDistance))
+						m_entries.resize(m_entries.size() - 1);
+					else
+						m_grid.add(e.position);
+				}
 			}
+			m_gridValid = eFALSE;
 		}
 
 		m_accumulatedTime += time - m_lastTime;
@@ -465,143 +487,34 @@ public:
 				}
 				if((attractorSamples == 0) || (attractorMeshOp->getChanged())) {
 					// build attractor tree
-					m_attractorKdTree.clear();
-					for(eU32 i = 0; i < numAttractorSamples; i++) 
-						m_attractorKdTree.add(m_attractorPositions[i], &m_attractorPositions[i]);
-					m_attractorKdTree.finishLoading();
+					m_attractorKdTree.build(m_attractorPositions);
 				}
 			}
 
 
-			if(collisionAvoidance != 0.0f) {
-				// build entity kd-tree
-				m_kdTree.clear();
-				for(eU32 k = 0; k < m_entries.size(); k++) {
-					tEntry& e = m_entries[k];
-					m_kdTree.add(e.position, &m_entries[k]);
-				}
-				m_kdTree.finishLoading();
-			}
+			if(collisionAvoidance != 0.0f)
+				_updateGrid(flockSize);
 
 			m_accumulatedTime -= timeStep;
 //			eF32 dt = eClamp(0.0f, time - m_lastTime, 0.1f);
 			eF32 dt = eClamp(0.0f, timeStep, 1.0f);
 //			const eF32 dt = eSWARM_TIMESTEP_S;
-			for(eU32 k = 0; k < m_entries.size(); k++) {
-				tEntry& entry = m_entries[k];
-
-				eF32 requestedAccel = 0.0f;
-				eVector3 direction = entry.rotation.getVector(2);
-				direction.normalize();
-
-				if(attractorMeshOp) {
-					// steer towards best attractor
-					m_attractorKdTree.getKNearest(m_kdLookupResults,1, entry.position);
-
-					eEmVtxPos& vtx = *(eEmVtxPos*)m_kdLookupResults[0].t;
-					eVector3 bestDirection = (vtx.pos - entry.position);
-					eF32 bestDirLen = bestDirection.length();
-					if(bestDirLen > eALMOST_ZERO) {
-						bestDirection /= bestDirLen;
-						direction = entry.rotation.lerpAlongShortestArc(direction, bestDirection, attraction * dt);
-
-						if(bestDirLen <= desiredAttrDist + eALMOST_ZERO)
-							requestedAccel -= attraction * eSqr((desiredAttrDist - bestDirLen) / desiredAttrDist);
-						else
-							requestedAccel += attraction * eSqr(1.0f - 1.0f / (1.0f + (bestDirLen - desiredAttrDist)));
-					}
-
-					// remove best attractor
-					if(attractorSamples == 0)
-						m_attractorKdTree.remove(m_kdLookupResults[0].t, *m_kdLookupResults[0].node);
-				}
-
-				if((collisionAvoidance != 0.0f) && (flockSize > 1)) {
-					// lookup flockmates
-					m_kdTree.getKNearest(m_kdLookupResults,flockSize, entry.position);
-					// calculate center
-					eVector3 avgDirection = direction;
-					eVector3 center = entry.position;
-					eF32 avgVelocity = entry.velocity;
-					eU32 nbrs = 1;
-					for(eU32 f = 1; f < m_kdLookupResults.size(); f++) {
-						tEntry& other = *((tEntry*)m_kdLookupResults[f].t);
-						eVector3 deltaOtherNorm = (entry.position - other.position).normalized();
-						if(eIsFloatZero(deltaOtherNorm.sqrLength())) 
-							deltaOtherNorm = eVector3(0,1,0);
-					
-						// test sight angle
-						eF32 dotProduct = direction * deltaOtherNorm;
-						if(dotProduct > sightAngleCos) 
-						{
-							nbrs++;
-							center += other.position;
-							// avoid collision
-							if((dotProduct != 0.0f) && (m_kdLookupResults[f].distanceSqr < minDistSqr)) {
-								eF32 amount = (1.0f - m_kdLookupResults[f].distanceSqr / minDistSqr);
-								direction = entry.rotation.lerpAlongShortestArc(direction, deltaOtherNorm, collisionAvoidance * amount * dt);
-							}
-							// match velocity
-							avgVelocity += other.velocity;
-							avgDirection += other.rotation.getVector(2);
-						}
-					}
-					if(nbrs > 1) {
-						avgVelocity /= (eF32)nbrs;
-						center /= (eF32)nbrs;
-						// steer towards center of other entities
-						eVector3 centerDir = (center - entry.position);
-						eF32 centerDirLen = centerDir.length();
-						if(!eIsFloatZero(centerDirLen)) {
-							centerDir /= centerDirLen; // normalize
-							direction = entry.rotation.lerpAlongShortestArc(direction, centerDir, cohesion * dt);
-							requestedAccel += alignment * (avgVelocity - entry.velocity);
-							entry.rotation.normalize();
-						}
-						eF32 avgDirectionLen = avgDirection.length();
-						if(!eIsFloatZero(avgDirectionLen)) {
-							avgDirection /= avgDirectionLen;
-							direction = entry.rotation.lerpAlongShortestArc(direction, avgDirection, alignment * dt);
-							entry.rotation.normalize();
-						}
-					}
-				}
-
-				if(hleveling != 0.0f) {
-					// try to become horizontally
-					eVector3 side = entry.rotation.getVector(0);
-					eVector3 bestSide = direction^eVector3(0,-1,0);
-					eF32 bestSideLen = bestSide.length();
-					if(!eIsFloatZero(bestSideLen)) {
-						bestSide /= bestSideLen;
-						eF32 cosine = side * bestSide;
-	//					if(cosine > -0.9f) 
-	//					if(!eAreFloatsEqual(cosine, 1.0f)) 
-						if((!eAreFloatsEqual(cosine, 1.0f)) && (!eAreFloatsEqual(cosine, -1.0f))) 
-						{
-							eF32 angle = eACos(cosine);
-	//						eVector3 rotAxis = (bestSide^side);
-							eVector3 rotAxis = (side^bestSide);
-							eF32 rotAxisLength = rotAxis.length();
-							if(rotAxisLength > eALMOST_ZERO) {
-								rotAxis /= rotAxisLength;
-	//							eF32 amount = angle / ePI;
-								eF32 amount = 1.0f;
-								entry.rotation = (eQuat(rotAxis, angle * eClamp(0.0f, amount * hleveling * dt, 1.0f)) * entry.rotation).normalized();
-		//						entry.rotation = (eQuat(rotAxis, angle * eClamp(0.0f, angle * hleveling * dt, 1.0f)) * entry.rotation).normalized();
-		//						entry.rotation = (eQuat(rotAxis, angle * hleveling * dt) * entry.rotation).normalized();
-								direction = entry.rotation.getVector(2);
-							}
-						}
-					}
-				}
-
-	/**/
-				requestedAccel = acceleration * eClamp(-1.0f, requestedAccel, 1.0f);
-				requestedAccel -= 0.2f * entry.velocity;
-				entry.position += direction * (entry.velocity * dt + 0.5f * requestedAccel * dt * dt);
-				entry.velocity += requestedAccel * dt;
-			}
+			tStepParams params;
+			params.dt = dt;
+			params.acceleration = acceleration;
+			params.attraction = attraction;
+			params.hleveling = hleveling;
+			params.collisionAvoidance = collisionAvoidance;
+			params.cohesion = cohesion;
+			params.alignment = alignment;
+			params.minDistSqr = minDistSqr;
+			params.desiredAttrDist = desiredAttrDist;
+			params.sightAngleCos = sightAngleCos;
+			params.flockSize = flockSize;
+			params.attract = (attractorMeshOp != nullptr);
+			params.consumeAttractors = (attractorSamples == 0);
+			params.flock = ((collisionAvoidance != 0.0f) && (flockSize > 1));
+			_step(params);
 		} while((m_accumulatedTime > 0.0f) && (--loops != 0));
 
 		// draw
@@ -621,6 +534,321 @@ public:
     }
 	eOP_EXEC2_END
 
+	// advances all entries by one time step. each
+	// entry only reads its flockmates' state from
+	// the previous step (m_flockmates), so chunks
+	// of entries are updated in parallel and the
+	// result doesn't depend on the thread count.
+	void _step(const tStepParams& params) {
+		const eU32 count = m_entries.size();
+		const eU32 numChunks = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+		// consumed attractors have to be assigned
+		// serially in entry order, all others are
+		// looked up in one batch
+		if(params.attract) {
+			if(params.consumeAttractors) {
+				m_attractorHits.resize(count);
+				for(eU32 k = 0; k < count; k++) {
+					eGenericKDTree::Result& hit = m_attractorHits[k];
+					if(m_attractorKdTree.getKNearest(&hit, 1, m_entries[k].position))
+						m_attractorKdTree.remove(hit.index);
+					else
+						hit.index = KDTREE2_NO_INDEX;
+				}
+			} else {
+				m_attractorQueries.resize(count);
+				for(eU32 k = 0; k < count; k++)
+					m_attractorQueries[k] = m_entries[k].position;
+				m_attractorKdTree.queryKNearest(m_attractorQueries, 1, m_attractorHits);
+			}
+		}
+
+		tStepJob job;
+		job.op = this;
+		job.params = &params;
+		if(params.flock) {
+			m_flockmates.resize(count);
+			eJobPool::getDefault().run(_storeFlockmates, &job, numChunks);
+		}
+		eJobPool::getDefault().run(_stepChunk, &job, numChunks);
+	}
+
+	static void _storeFlockmates(ePtr arg, eU32 index) {
+		eModelSwarmOp* op = ((tStepJob*)arg)->op;
+		const eU32 end = eMin((index + 1) * CHUNK_SIZE, op->m_entries.size());
+		for(eU32 k = index * CHUNK_SIZE; k < end; k++) {
+			const tEntry& entry = op->m_entries[k];
+			tFlockmate& mate = op->m_flockmates[k];
+			mate.position = entry.position;
+			mate.direction = entry.rotation.getVector(2);
+			mate.velocity = entry.velocity;
+			mate.pad = 0.0f;
+		}
+	}
+
+	static void _stepChunk(ePtr arg, eU32 index) {
+		const tStepJob& job = *(tStepJob*)arg;
+		eArray<eSpatialGrid::Result> gridResults;
+		const eU32 end = eMin((index + 1) * CHUNK_SIZE, job.op->m_entries.size());
+		for(eU32 k = index * CHUNK_SIZE; k < end; k++)
+			job.op->_stepEntry(k, *job.params, gridResults);
+	}
+
+	void _stepEntry(eU32 k, const tStepParams& params, eArray<eSpatialGrid::Result>& gridResults) {
+		tEntry& entry = m_entries[k];
+		const eF32 dt = params.dt;
+
+		eF32 requestedAccel = 0.0f;
+		eVector3 direction = entry.rotation.getVector(2);
+		direction.normalize();
+
+		if(params.attract) {
+			// steer towards best attractor
+			const eU32 hit = m_attractorHits[k].index;
+			const eVector3* target = (hit != KDTREE2_NO_INDEX ? &m_attractorPositions[hit] : nullptr);
+
+			if(target) {
+				eVector3 bestDirection = (*target - entry.position);
+				eF32 bestDirLen = bestDirection.length();
+				if(bestDirLen > eALMOST_ZERO) {
+					bestDirection /= bestDirLen;
+					direction = entry.rotation.lerpAlongShortestArc(direction, bestDirection, params.attraction * dt);
+
+					if(bestDirLen <= params.desiredAttrDist + eALMOST_ZERO)
+						requestedAccel -= params.attraction * eSqr((params.desiredAttrDist - bestDirLen) / params.desiredAttrDist);
+					else
+						requestedAccel += params.attraction * eSqr(1.0f - 1.0f / (1.0f + (bestDirLen - params.desiredAttrDist)));
+				}
+			}
+		}
+
+		if(params.flock) {
+			// lookup flockmates
+			m_grid.getKNearest(gridResults, params.flockSize, entry.position);
+			_flock(k, params, gridResults, direction, requestedAccel);
+		}
+
+		if(params.hleveling != 0.0f) {
+			// try to become horizontally
+			eVector3 side = entry.rotation.getVector(0);
+			eVector3 bestSide = direction^eVector3(0,-1,0);
+			eF32 bestSideLen = bestSide.length();
+			if(!eIsFloatZero(bestSideLen)) {
+				bestSide /= bestSideLen;
+				eF32 cosine = side * bestSide;
+				if((!eAreFloatsEqual(cosine, 1.0f)) && (!eAreFloatsEqual(cosine, -1.0f))) 
+				{
+					eF32 angle = eACos(cosine);
+					eVector3 rotAxis = (side^bestSide);
+					eF32 rotAxisLength = rotAxis.length();
+					if(rotAxisLength > eALMOST_ZERO) {
+						rotAxis /= rotAxisLength;
+						eF32 amount = 1.0f;
+						entry.rotation = (eQuat(rotAxis, angle * eClamp(0.0f, amount * params.hleveling * dt, 1.0f)) * entry.rotation).normalized();
+						direction = entry.rotation.getVector(2);
+					}
+				}
+			}
+		}
+
+		requestedAccel = params.acceleration * eClamp(-1.0f, requestedAccel, 1.0f);
+		requestedAccel -= 0.2f * entry.velocity;
+		entry.position += direction * (entry.velocity * dt + 0.5f * requestedAccel * dt * dt);
+		entry.velocity += requestedAccel * dt;
+	}
+
+	// sums up the flockmates in sight, 4 at a time.
+	// the sight test uses the direction from before
+	// collision avoidance, which is then applied in
+	// flockmate order for the colliding ones.
+	void _flock(eU32 k, const tStepParams& params, const eArray<eSpatialGrid::Result>& gridResults, eVector3& direction, eF32& requestedAccel) {
+		tEntry& entry = m_entries[k];
+		const eF32 dt = params.dt;
+		const eVector3 ownDirection = direction;
+
+		// room for a full flock plus one, in case the
+		// entry itself isn't among the results, padded
+		// to a multiple of four
+		eU32 mates[MAX_FLOCK_SIZE + 4];
+		eALIGN16 eF32 distSqr[MAX_FLOCK_SIZE + 4];
+		eU32 numMates = 0;
+		for(eU32 f = 0; f < gridResults.size(); f++) {
+			if(gridResults[f].index != k) {
+				eASSERT(numMates <= MAX_FLOCK_SIZE);
+				mates[numMates] = gridResults[f].index;
+				distSqr[numMates] = gridResults[f].distanceSqr;
+				numMates++;
+			}
+		}
+		for(eU32 f = numMates; f < ((numMates + 3) & ~3); f++) {
+			mates[f] = k;
+			distSqr[f] = eF32_MAX;
+		}
+
+		const eF32x4 zero = eSimdZero();
+		const eF32x4 one = eSimdSetAll(1.0f);
+		const eF32x4 almostZero = eSimdSetAll(eALMOST_ZERO);
+		const eF32x4 sightAngleCos = eSimdSetAll(params.sightAngleCos);
+		const eF32x4 minDistSqr = eSimdSetAll(params.minDistSqr);
+		const eF32x4 lanes = eSimdSet(3.0f, 2.0f, 1.0f, 0.0f);
+		const eF32x4 posX = eSimdSetAll(entry.position.x);
+		const eF32x4 posY = eSimdSetAll(entry.position.y);
+		const eF32x4 posZ = eSimdSetAll(entry.position.z);
+		const eF32x4 dirX = eSimdSetAll(direction.x);
+		const eF32x4 dirY = eSimdSetAll(direction.y);
+		const eF32x4 dirZ = eSimdSetAll(direction.z);
+
+		eF32x4 sumCount = zero;
+		eF32x4 sumPosX = zero, sumPosY = zero, sumPosZ = zero;
+		eF32x4 sumDirX = zero, sumDirY = zero, sumDirZ = zero;
+		eF32x4 sumVelocity = zero;
+
+		for(eU32 f = 0; f < numMates; f += 4) {
+			const eF32* m0 = (const eF32*)&m_flockmates[mates[f + 0]];
+			const eF32* m1 = (const eF32*)&m_flockmates[mates[f + 1]];
+			const eF32* m2 = (const eF32*)&m_flockmates[mates[f + 2]];
+			const eF32* m3 = (const eF32*)&m_flockmates[mates[f + 3]];
+			eF32x4 matePosX = eSimdLoad(m0);
+			eF32x4 matePosY = eSimdLoad(m1);
+			eF32x4 matePosZ = eSimdLoad(m2);
+			eF32x4 mateDirX = eSimdLoad(m3);
+			eSimdTranspose(matePosX, matePosY, matePosZ, mateDirX);
+			eF32x4 mateDirY = eSimdLoad(m0 + 4);
+			eF32x4 mateDirZ = eSimdLoad(m1 + 4);
+			eF32x4 mateVelocity = eSimdLoad(m2 + 4);
+			eF32x4 matePad = eSimdLoad(m3 + 4);
+			eSimdTranspose(mateDirY, mateDirZ, mateVelocity, matePad);
+
+			// normalized delta, (0,1,0) for coincident entries
+			const eF32x4 deltaX = eSimdSub(posX, matePosX);
+			const eF32x4 deltaY = eSimdSub(posY, matePosY);
+			const eF32x4 deltaZ = eSimdSub(posZ, matePosZ);
+			const eF32x4 lenSqr = eSimdFma(eSimdFma(eSimdMul(deltaX, deltaX), deltaY, deltaY), deltaZ, deltaZ);
+			const eF32x4 apart = _mm_cmpge_ps(lenSqr, almostZero);
+			const eF32x4 invLen = eSimdDiv(one, eSimdSqrt(eSimdMax(lenSqr, almostZero)));
+			const eF32x4 normX = _mm_and_ps(apart, eSimdMul(deltaX, invLen));
+			const eF32x4 normY = _mm_or_ps(_mm_and_ps(apart, eSimdMul(deltaY, invLen)), _mm_andnot_ps(apart, one));
+			const eF32x4 normZ = _mm_and_ps(apart, eSimdMul(deltaZ, invLen));
+
+			// test sight angle
+			const eF32x4 dot = eSimdFma(eSimdFma(eSimdMul(dirX, normX), dirY, normY), dirZ, normZ);
+			const eF32x4 valid = _mm_cmplt_ps(eSimdAddScalar(lanes, (eF32)f), eSimdSetAll((eF32)numMates));
+			const eF32x4 inSight = _mm_and_ps(valid, _mm_cmpgt_ps(dot, sightAngleCos));
+
+			sumCount = eSimdAdd(sumCount, _mm_and_ps(inSight, one));
+			sumPosX = eSimdAdd(sumPosX, _mm_and_ps(inSight, matePosX));
+			sumPosY = eSimdAdd(sumPosY, _mm_and_ps(inSight, matePosY));
+			sumPosZ = eSimdAdd(sumPosZ, _mm_and_ps(inSight, matePosZ));
+			sumDirX = eSimdAdd(sumDirX, _mm_and_ps(inSight, mateDirX));
+			sumDirY = eSimdAdd(sumDirY, _mm_and_ps(inSight, mateDirY));
+			sumDirZ = eSimdAdd(sumDirZ, _mm_and_ps(inSight, mateDirZ));
+			sumVelocity = eSimdAdd(sumVelocity, _mm_and_ps(inSight, mateVelocity));
+
+			// avoid collision
+			const eF32x4 dists = eSimdLoadAligned(&distSqr[f]);
+			const eF32x4 collide = _mm_and_ps(_mm_and_ps(inSight, _mm_cmpneq_ps(dot, zero)), _mm_cmplt_ps(dists, minDistSqr));
+			const eU32 collideMask = _mm_movemask_ps(collide);
+			if(collideMask) {
+				eALIGN16 eF32 nx[4];
+				eALIGN16 eF32 ny[4];
+				eALIGN16 eF32 nz[4];
+				eSimdStoreAligned(normX, nx);
+				eSimdStoreAligned(normY, ny);
+				eSimdStoreAligned(normZ, nz);
+				for(eU32 i = 0; i < 4; i++) {
+					if(collideMask & (1 << i)) {
+						eF32 amount = (1.0f - distSqr[f + i] / params.minDistSqr);
+						direction = entry.rotation.lerpAlongShortestArc(direction, eVector3(nx[i], ny[i], nz[i]), params.collisionAvoidance * amount * dt);
+					}
+				}
+			}
+		}
+
+		const eU32 nbrs = 1 + (eU32)_horizontalSum(sumCount);
+		if(nbrs > 1) {
+			// calculate center
+			eVector3 center = entry.position + eVector3(_horizontalSum(sumPosX), _horizontalSum(sumPosY), _horizontalSum(sumPosZ));
+			eVector3 avgDirection = ownDirection + eVector3(_horizontalSum(sumDirX), _horizontalSum(sumDirY), _horizontalSum(sumDirZ));
+			eF32 avgVelocity = entry.velocity + _horizontalSum(sumVelocity);
+			avgVelocity /= (eF32)nbrs;
+			center /= (eF32)nbrs;
+			// steer towards center of other entities
+			eVector3 centerDir = (center - entry.position);
+			eF32 centerDirLen = centerDir.length();
+			if(!eIsFloatZero(centerDirLen)) {
+				centerDir /= centerDirLen; // normalize
+				direction = entry.rotation.lerpAlongShortestArc(direction, centerDir, params.cohesion * dt);
+				requestedAccel += params.alignment * (avgVelocity - entry.velocity);
+				entry.rotation.normalize();
+			}
+			eF32 avgDirectionLen = avgDirection.length();
+			if(!eIsFloatZero(avgDirectionLen)) {
+				avgDirection /= avgDirectionLen;
+				direction = entry.rotation.lerpAlongShortestArc(direction, avgDirection, params.alignment * dt);
+				entry.rotation.normalize();
+			}
+		}
+	}
+
+	static eF32 _horizontalSum(const eF32x4& v) {
+		eALIGN16 eF32 vals[4];
+		eSimdStoreAligned(v, vals);
+		return (vals[0] + vals[1]) + (vals[2] + vals[3]);
+	}
+
+	// moves the entries' grid points to their
+	// current positions. the grid is rebuilt when
+	// its cell size drifted too far from the one
+	// giving about flockSize entries per cell.
+	void _updateGrid(eU32 flockSize) {
+		eVector3 vmin(eF32_MAX);
+		eVector3 vmax(-eF32_MAX);
+		for(eU32 k = 0; k < m_entries.size(); k++) {
+			vmin.minComponents(m_entries[k].position);
+			vmax.maxComponents(m_entries[k].position);
+		}
+
+		eF32 cellSize = 1.0f;
+		const eVector3 extent = vmax - vmin;
+		const eF32 maxExtent = eMax(extent.x, eMax(extent.y, extent.z));
+		if(!m_entries.isEmpty() && maxExtent > eALMOST_ZERO) {
+			// flat swarms still get a sensible volume
+			const eF32 minExtent = maxExtent * 0.01f;
+			const eF32 volume = eMax(extent.x, minExtent) * eMax(extent.y, minExtent) * eMax(extent.z, minExtent);
+			cellSize = ePow(volume * (eF32)flockSize / (eF32)m_entries.size(), 1.0f / 3.0f);
+		}
+
+		const eF32 ratio = cellSize / m_grid.getCellSize();
+		if(!m_gridValid || m_grid.getCount() != m_entries.size() || ratio < 0.5f || ratio > 2.0f) {
+			m_grid.clear(cellSize, m_entries.size());
+			for(eU32 k = 0; k < m_entries.size(); k++)
+				m_grid.add(m_entries[k].position);
+			m_gridValid = eTRUE;
+		} else {
+			for(eU32 k = 0; k < m_entries.size(); k++)
+				m_grid.update(k, m_entries[k].position);
+			m_grid.updateBounds();
+		}
+	}
+
+	// previous state of an entry as read by its
+	// flockmates, padded for 4-wide transposes
+	struct tFlockmate {
+		eVector3	position;
+		eVector3	direction;
+		eF32		velocity;
+		eF32		pad;
+	};
+
+	struct tStepJob {
+		eModelSwarmOp*		op;
+		const tStepParams*	params;
+	};
+
+	static const eU32	CHUNK_SIZE = 1024;
+	static const eU32	MAX_FLOCK_SIZE = 32;
+
 	eArray<eVector3>	m_attractorPositions;
 	eArray<eF32>	m_faceSums;
 
@@ -630,9 +858,12 @@ public:
 	eF32			m_lastPopDistance;
 	eF32			m_accumulatedTime;
     eArray<tEntry>  m_entries;
-	eGenericKDTree	m_kdTree;
+	eSpatialGrid	m_grid;
+	eBool			m_gridValid;
+	eArray<tFlockmate>	m_flockmates;
 	eGenericKDTree	m_attractorKdTree;
-	eArray<eGenericKDTree::Result>	m_kdLookupResults;
+	eArray<eVector3>	m_attractorQueries;
+	eArray<eGenericKDTree::Result>	m_attractorHits;
 	eArray<eSceneData*> m_models;
 eOP_END(eModelSwarmOp);
 #endif
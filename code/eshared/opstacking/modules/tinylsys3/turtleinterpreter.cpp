@@ -23,6 +23,11 @@ eLsys3TurtleInterpreter::eLsys3TurtleInterpreter() {
 	scaleFak = 2.0f;
 }
 
+eLsys3TurtleInterpreter::~eLsys3TurtleInterpreter() {
+	for(eU32 i = 0; i < segmentNodes.size(); i++)
+		eDelete(segmentNodes[i]);
+}
+
 void eLsys3TurtleInterpreter::initializeState(TurtleState& state) {
 	state.m_localPos = eVector3();
 	state.m_localRot = eQuat();
@@ -79,37 +84,180 @@ eBool eLsys3TurtleInterpreter::interpretSymbol(eU32 symbol, eF32* params, Turtle
 
 
 void eLsys3TurtleInterpreter::interpret(eArray<eLSys3InterpreterNode>& result, const TurtleState& initialState, eArray<eRewriteSystem::SymInstance>& s) {
+	// match brackets
+	eArray<eU32> open;
+	brackets.resize(s.size());
+	for(eU32 i = 0; i < s.size(); i++) {
+		if(s[i].symbol == '[') {
+			brackets[i] = LSYS3_NO_SEGMENT;
+			open.push(i);
+		} else if((s[i].symbol == ']') && !open.isEmpty())
+			brackets[open.pop()] = i;
+	}
+
+	// find segments in pre-order
+	segments.clear();
+	eLSys3Segment& root = segments.append();
+	root.start = 0;
+	root.end = s.size();
+	root.level = 0;
+	root.outer = LSYS3_NO_SEGMENT;
+	root.firstChild = LSYS3_NO_SEGMENT;
+	root.lastChild = LSYS3_NO_SEGMENT;
+	root.nextSibling = LSYS3_NO_SEGMENT;
+	root.total = 0;
+	root.base = 1;
+	root.parent = 0;
+	root.startNode.parent = LSYS3_OUTER_PARENT;
+	root.startNode.state = initialState;
+	initializeState(root.startNode.state);
+
+	eU32 numLevels = 1;
+	open.clear();
+	open.push(0);
+	for(eU32 i = 0; i < s.size(); i++) {
+		while(i >= segments[open.last()].end)
+			open.pop();
+		if((s[i].symbol == '[') && (brackets[i] != LSYS3_NO_SEGMENT) && (brackets[i] - i > LSYS3_SEGMENT_SIZE)) {
+			const eU32 outer = open.last();
+			const eU32 id = segments.size();
+			eLSys3Segment& seg = segments.append();
+			seg.start = i + 1;
+			seg.end = brackets[i];
+			seg.level = segments[outer].level + 1;
+			seg.outer = outer;
+			seg.firstChild = LSYS3_NO_SEGMENT;
+			seg.lastChild = LSYS3_NO_SEGMENT;
+			seg.nextSibling = LSYS3_NO_SEGMENT;
+			seg.total = 0;
+			if(segments[outer].lastChild == LSYS3_NO_SEGMENT)
+				segments[outer].firstChild = id;
+			else
+				segments[segments[outer].lastChild].nextSibling = id;
+			segments[outer].lastChild = id;
+			numLevels = eMax(numLevels, seg.level + 1);
+			open.push(id);
+		}
+	}
+
+	while(segmentNodes.size() < segments.size())
+		segmentNodes.append(new eArray<eLSys3InterpreterNode>);
+
+	// interpret level by level, a segment's start
+	// node is known after its outer one is done
+	InterpretJob job;
+	job.interpreter = this;
+	job.symbols = &s;
+	job.result = &result;
+	levelOrder.clear();
+	for(eU32 l = 0; l < numLevels; l++) {
+		job.first = levelOrder.size();
+		for(eU32 i = 0; i < segments.size(); i++)
+			if(segments[i].level == l)
+				levelOrder.append(i);
+		eJobPool::getDefault().run(interpretSegment, &job, levelOrder.size() - job.first);
+	}
+
+	// sizes bottom-up, then positions top-down
+	for(eInt i = segments.size() - 1; i >= 0; i--) {
+		eLSys3Segment& seg = segments[i];
+		seg.total += segmentNodes[i]->size();
+		if(seg.outer != LSYS3_NO_SEGMENT)
+			segments[seg.outer].total += seg.total;
+	}
+	for(eU32 i = 1; i < segments.size(); i++) {
+		eLSys3Segment& seg = segments[i];
+		const eLSys3Segment& outer = segments[seg.outer];
+		seg.base = outer.base + seg.splice;
+		for(eU32 c = outer.firstChild; c != i; c = segments[c].nextSibling)
+			seg.base += segments[c].total;
+		if(seg.startNode.parent == LSYS3_OUTER_PARENT)
+			seg.parent = outer.parent;
+		else
+			seg.parent = resultIndex(outer, seg.startNode.parent);
+	}
+
 	result.clear();
-	result.reserve(s.size());
-	stateStack.clear();
-	stateStack.reserve(s.size());
+	result.resize(segments[0].total + 1);
+	result[0].parent = -1;
+	result[0].state = initialState;
+	eJobPool::getDefault().run(writeSegment, &job, segments.size());
+}
 
-	eLSys3InterpreterNode curNode;
-	curNode.parent = -1;
-	curNode.state = initialState;
-	result.append(curNode);
-	initializeState(curNode.state);
+// result index of a node emitted by a segment,
+// nested segments are placed before the node
+// following them
+eU32 eLsys3TurtleInterpreter::resultIndex(const eLSys3Segment& seg, eU32 node) const {
+	eU32 index = seg.base + node;
+	for(eU32 c = seg.firstChild; (c != LSYS3_NO_SEGMENT) && (segments[c].splice <= node); c = segments[c].nextSibling)
+		index += segments[c].total;
+	return index;
+}
+
+void eLsys3TurtleInterpreter::interpretSegment(ePtr arg, eU32 index) {
+	const InterpretJob& job = *(InterpretJob*)arg;
+	eLsys3TurtleInterpreter& ip = *job.interpreter;
+	eArray<eRewriteSystem::SymInstance>& s = *job.symbols;
+	const eU32 id = ip.levelOrder[job.first + index];
+	const eLSys3Segment& seg = ip.segments[id];
+	eArray<eLSys3InterpreterNode>& nodes = *ip.segmentNodes[id];
+	eArray<eLSys3InterpreterNode> stateStack;
 
-	curNode.parent = 0;
+	nodes.clear();
+	eLSys3InterpreterNode curNode = seg.startNode;
+	curNode.parent = LSYS3_OUTER_PARENT; // parent is in the outer segment
+	eU32 child = seg.firstChild;
 
 	// interpret symbols
-	for(eU32 i = 0; i < s.size(); i++) {
+	for(eU32 i = seg.start; i < seg.end; i++) {
 		switch(s[i].symbol) {
 		case '[':
-			stateStack.push(curNode);
+			if((child != LSYS3_NO_SEGMENT) && (ip.segments[child].start == i + 1)) {
+				// nested segment continues from here
+				eLSys3Segment& nested = ip.segments[child];
+				nested.startNode = curNode;
+				nested.splice = nodes.size();
+				i = nested.end;
+				child = nested.nextSibling;
+			} else
+				stateStack.push(curNode);
 			break;
 		case ']':
-			curNode = stateStack.pop();
+			if(!stateStack.isEmpty())
+				curNode = stateStack.pop();
 			break;
 		default:
-			if(interpretSymbol(s[i].symbol, s[i].params, curNode.state)) {
-				result.append(curNode);
-				curNode.parent = result.size() - 1;
-				initializeState(curNode.state);
+			if(ip.interpretSymbol(s[i].symbol, s[i].params, curNode.state)) {
+				nodes.append(curNode);
+				curNode.parent = nodes.size() - 1;
+				ip.initializeState(curNode.state);
 			}
 		}
 	}
+}
+
+void eLsys3TurtleInterpreter::writeSegment(ePtr arg, eU32 index) {
+	const InterpretJob& job = *(InterpretJob*)arg;
+	const eLsys3TurtleInterpreter& ip = *job.interpreter;
+	const eLSys3Segment& seg = ip.segments[index];
+	const eArray<eLSys3InterpreterNode>& nodes = *ip.segmentNodes[index];
+	eArray<eLSys3InterpreterNode>& result = *job.result;
+
+	// map node and parent indices to the result
+	eArray<eU32> indices(nodes.size());
+	eU32 offset = seg.base;
+	eU32 child = seg.firstChild;
+	for(eU32 i = 0; i < nodes.size(); i++) {
+		while((child != LSYS3_NO_SEGMENT) && (ip.segments[child].splice <= i)) {
+			offset += ip.segments[child].total;
+			child = ip.segments[child].nextSibling;
+		}
+		indices[i] = offset + i;
 
+		eLSys3InterpreterNode& node = result[indices[i]];
+		node = nodes[i];
+		node.parent = (nodes[i].parent == LSYS3_OUTER_PARENT) ? seg.parent : indices[nodes[i].parent];
+	}
 }
 
 void eLsys3TurtleInterpreter::postProcess(eArray<eLSys3InterpreterNode>& results, eArray<eLsys3Attractor*>& attractors) {
@@ -150,4 +298,3 @@ void eLsys3TurtleInterpreter::postProcess(eArray<eLSys3InterpreterNode>& results
 	}
 
 }
-
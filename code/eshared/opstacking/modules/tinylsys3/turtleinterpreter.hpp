@@ -19,6 +19,10 @@
 #include "rewritesystem.hpp"
 #include "attractor.hpp"
 
+#define LSYS3_SEGMENT_SIZE 2048
+#define LSYS3_NO_SEGMENT 0xffffffff
+#define LSYS3_OUTER_PARENT 0xfffffffe
+
 struct TurtleState {
 	eVector3					m_localPos;
 	eQuat						m_localRot;
@@ -52,6 +56,25 @@ struct eLSys3InterpreterNode {
 	eLsys3PostProcRec	postProc;
 };
 
+// a branch long enough to be interpreted on
+// its own. the outer segment records where the
+// branch starts, all segments of the same level
+// are interpreted in parallel.
+struct eLSys3Segment {
+	eU32					start;
+	eU32					end;		// closing bracket
+	eU32					level;
+	eU32					outer;
+	eU32					firstChild;
+	eU32					lastChild;
+	eU32					nextSibling;
+	eU32					splice;		// nodes of outer segment before this one
+	eU32					total;		// nodes including nested segments
+	eU32					base;		// result index of first node
+	eU32					parent;		// result index of start node's parent
+	eLSys3InterpreterNode	startNode;
+};
+
 
 class eLsys3TurtleInterpreter {
 public:
@@ -59,15 +82,31 @@ public:
 	eVector3		rotationUnit;
 	eF32			decay;
 	eF32			scaleFak;
-	eArray<eLSys3InterpreterNode>	stateStack;
+	eArray<eU32>	brackets;		// closing bracket for each opening one
+	eArray<eLSys3Segment>	segments;
+	eArray<eU32>	levelOrder;
+	eArray<eArray<eLSys3InterpreterNode>*>	segmentNodes;
 
 	eLsys3TurtleInterpreter();
+	~eLsys3TurtleInterpreter();
 	void initializeState(TurtleState& state);
 	void interpret(eArray<eLSys3InterpreterNode>& result, eArray<eRewriteSystem::SymInstance>& s, const eVector3& rotUnit, eF32 decay);
 	// returns eTRUE if this state should be saved
 	eBool interpretSymbol(eU32 symbol, eF32* params, TurtleState& state);
 	void interpret(eArray<eLSys3InterpreterNode>& result, const TurtleState& initialState, eArray<eRewriteSystem::SymInstance>& s);
 	void postProcess(eArray<eLSys3InterpreterNode>& results, eArray<eLsys3Attractor*>& attractors);
+
+private:
+	typedef struct InterpretJob {
+		eLsys3TurtleInterpreter*				interpreter;
+		eArray<eRewriteSystem::SymInstance>*	symbols;
+		eArray<eLSys3InterpreterNode>*			result;
+		eU32									first;
+	};
+
+	eU32 resultIndex(const eLSys3Segment& seg, eU32 node) const;
+	static void interpretSegment(ePtr arg, eU32 index);
+	static void writeSegment(ePtr arg, eU32 index);
 };
 
 #endif // LSYS_INTERPRETER_HPP
\ No newline at end of file
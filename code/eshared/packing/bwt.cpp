@@ -15,101 +15,257 @@
 #include "../system/system.hpp"
 #include "packing.hpp"
 
-static eInt sortPred(const eByteArray &src, eU32 idx0, eU32 idx1)
+// suffix array construction by induced sorting
+// (SA-IS, Nong/Zhang/Chan 2009). runs in O(n)
+// time and needs besides the suffix array only
+// one byte per symbol for the type array and
+// one bucket table per recursion level.
+
+static void getBuckets(const eInt *s, eInt *bkt, eInt n, eInt k, eBool end)
 {
-    for (eU32 i=0; i<src.size(); i++)
+    eMemSet(bkt, 0, (k+1)*sizeof(eInt));
+
+    for (eInt i=0; i<n; i++)
+        bkt[s[i]]++;
+
+    for (eInt i=0, sum=0; i<=k; i++)
     {
-        // wrap around compare
-        const eInt diff = (eInt)src[(i+idx1)%src.size()]-(eInt)src[(i+idx0)%src.size()];
-        if (diff != 0)
-            return diff;
+        sum += bkt[i];
+        bkt[i] = (end ? sum : sum-bkt[i]);
     }
-
-    return 0;
 }
 
-eBool eBurrowsWheeler::pack(const eByteArray &src, eByteArray &dst)
+static void induceSaL(const eU8 *t, eInt *sa, const eInt *s, eInt *bkt, eInt n, eInt k)
 {
-    // initialize
-    eArray<eU32> mtx(src.size());
-    for (eU32 i=0; i<src.size(); i++)
-        mtx[i] = i;
-
-    /*
-    // terribly slow O(n^2) bubble sort
-    for (eU32 i=0; i<mtx.size(); i++)
+    getBuckets(s, bkt, n, k, eFALSE);
+
+    for (eInt i=0; i<n; i++)
     {
-        for (eU32 j=i; j<mtx.size()-1; j++)
-            if (sortPred(src, mtx[j], mtx[j+1]) < 0)
-                eSwap(mtx[j], mtx[j+1]);
+        const eInt j = sa[i]-1;
+        if (j >= 0 && !t[j])
+            sa[bkt[s[j]]++] = j;
+    }
+}
 
-        if (i%100==0)
-            eWriteToLog(eIntToStr(i));
+static void induceSaS(const eU8 *t, eInt *sa, const eInt *s, eInt *bkt, eInt n, eInt k)
+{
+    getBuckets(s, bkt, n, k, eTRUE);
+
+    for (eInt i=n-1; i>=0; i--)
+    {
+        const eInt j = sa[i]-1;
+        if (j >= 0 && t[j])
+            sa[--bkt[s[j]]] = j;
     }
-    */
+}
+
+// s has to be terminated by a unique, smallest
+// symbol 0. all other symbols are in [1,k].
+static void suffixArray(const eInt *s, eInt *sa, eInt n, eInt k)
+{
+    // classify suffixes into S-type (1) and L-type (0)
+    eArray<eU8> types(n);
+    eU8 *t = &types[0];
+    t[n-1] = 1;
+
+    if (n > 1)
+        t[n-2] = 0;
+
+    for (eInt i=n-3; i>=0; i--)
+        t[i] = (s[i] < s[i+1] || (s[i] == s[i+1] && t[i+1]));
+
+    #define IS_LMS(i) ((i) > 0 && t[i] && !t[(i)-1])
 
-    for (eU32 j=1; j<mtx.size(); j++)
+    // stage 1: sort LMS substrings
+    eArray<eInt> buckets(k+1);
+    eInt *bkt = &buckets[0];
+    getBuckets(s, bkt, n, k, eTRUE);
+
+    for (eInt i=0; i<n; i++)
+        sa[i] = -1;
+    for (eInt i=1; i<n; i++)
+        if (IS_LMS(i))
+            sa[--bkt[s[i]]] = i;
+
+    induceSaL(t, sa, s, bkt, n, k);
+    induceSaS(t, sa, s, bkt, n, k);
+
+    // compact sorted LMS substrings into
+    // first n1 entries and name them
+    eInt n1 = 0;
+    for (eInt i=0; i<n; i++)
+        if (IS_LMS(sa[i]))
+            sa[n1++] = sa[i];
+
+    for (eInt i=n1; i<n; i++)
+        sa[i] = -1;
+
+    eInt name = 0;
+    eInt prev = -1;
+
+    for (eInt i=0; i<n1; i++)
     {
-        const eU32 temp = mtx[j];
-        eInt i = (eInt)j-1;
+        const eInt pos = sa[i];
+        eBool diff = eFALSE;
 
-        while (i >= 0 && sortPred(src, mtx[i], temp) < 0)
+        for (eInt d=0; d<n; d++)
         {
-            mtx[i+1] = mtx[i];
-            i--;
+            if (prev == -1 || s[pos+d] != s[prev+d] || t[pos+d] != t[prev+d])
+            {
+                diff = eTRUE;
+                break;
+            }
+            else if (d > 0 && (IS_LMS(pos+d) || IS_LMS(prev+d)))
+                break;
         }
 
-        mtx[i+1] = temp;
+        if (diff)
+        {
+            name++;
+            prev = pos;
+        }
 
-        if (j%100==0)
-            eWriteToLog(eIntToStr(i));
+        sa[n1+pos/2] = name-1;
     }
 
-    // output
-    dst.resize(src.size()+sizeof(eU32)); // space for original index
-    eU32 origIdx = 0;
+    for (eInt i=n-1, j=n-1; i>=n1; i--)
+        if (sa[i] >= 0)
+            sa[j--] = sa[i];
 
-    for (eU32 i=0; i<src.size(); i++)
+    // stage 2: solve reduced problem, recurse
+    // if names aren't unique yet
+    eInt *sa1 = sa;
+    eInt *s1 = sa+n-n1;
+
+    if (name < n1)
+        suffixArray(s1, sa1, n1, name-1);
+    else
     {
-        eInt idx = (mtx[i]-1);
-        idx = (idx+(eInt)src.size())%(eInt)src.size();
-        dst[i] = src[idx];
-        origIdx = (!mtx[i] ? i : origIdx);
+        for (eInt i=0; i<n1; i++)
+            sa1[s1[i]] = i;
     }
 
-    // append original index
-    (*(eU32 *)&dst[src.size()]) = origIdx;
-    return eTRUE;
-}
+    // stage 3: induce final suffix array
+    // from sorted LMS suffixes
+    getBuckets(s, bkt, n, k, eTRUE);
 
-eBool eBurrowsWheeler::unpack(const eByteArray &src, eByteArray &dst)
-{
-    const eU32 srcLen = src.size()-sizeof(eU32); // original index appended
-    eArray<eU32> pred(srcLen);
-    eU32 count[256];
+    for (eInt i=1, j=0; i<n; i++)
+        if (IS_LMS(i))
+            s1[j++] = i;
 
-    eMemSet(count, 0, sizeof(count));
-    dst.resize(srcLen);
+    for (eInt i=0; i<n1; i++)
+        sa1[i] = s1[sa1[i]];
+    for (eInt i=n1; i<n; i++)
+        sa[i] = -1;
 
-    for (eU32 i=0; i<srcLen; i++)
+    for (eInt i=n1-1; i>=0; i--)
     {
-        const eU8 c = src[i];
-        pred[i] = count[c];
-        count[c]++;
+        const eInt j = sa[i];
+        sa[i] = -1;
+        sa[--bkt[s[j]]] = j;
     }
 
-    for (eU32 i=0, sum=0; i<256; i++)
+    induceSaL(t, sa, s, bkt, n, k);
+    induceSaS(t, sa, s, bkt, n, k);
+
+    #undef IS_LMS
+}
+
+eBurrowsWheeler::eBurrowsWheeler(eU32 blockSize) :
+    m_blockSize(blockSize)
+{
+    eASSERT(blockSize > 0);
+}
+
+// output consists of one chunk per block:
+// [block size][original index][transformed data]
+eBool eBurrowsWheeler::pack(const eByteArray &src, eByteArray &dst)
+{
+    dst.clear();
+
+    const eU32 blockSize = eMin(m_blockSize, src.size());
+    eArray<eInt> str(2*blockSize+1);
+    eArray<eInt> sa(2*blockSize+1);
+
+    for (eU32 blockStart=0; blockStart<src.size(); blockStart+=blockSize)
     {
-        const eU32 temp = count[i];
-        count[i] = sum;
-        sum += temp;
+        const eU32 len = eMin(blockSize, src.size()-blockStart);
+        const eU8 *block = &src[blockStart];
+
+        // sorting the suffixes of the block's text
+        // concatenated with itself yields the order
+        // of all cyclic rotations of the block
+        for (eU32 i=0; i<len; i++)
+            str[i] = str[i+len] = (eInt)block[i]+1;
+
+        str[2*len] = 0;
+        suffixArray(&str[0], &sa[0], 2*len+1, 256);
+
+        // output
+        const eU32 chunkStart = dst.size();
+        dst.resize(chunkStart+2*sizeof(eU32)+len);
+        eU8 *out = &dst[chunkStart+2*sizeof(eU32)];
+        eU32 origIdx = 0;
+
+        for (eU32 i=0, j=0; i<2*len+1; i++)
+        {
+            const eU32 rot = (eU32)sa[i];
+
+            if (rot < len)
+            {
+                out[j] = block[(rot+len-1)%len];
+                origIdx = (!rot ? j : origIdx);
+                j++;
+            }
+        }
+
+        (*(eU32 *)&dst[chunkStart]) = len;
+        (*(eU32 *)&dst[chunkStart+sizeof(eU32)]) = origIdx;
     }
 
-    const eU32 origIdx = *(eU32 *)&src[srcLen]; // read original index
-    for (eInt i=srcLen-1, j=origIdx; i>=0; i--)
+    return eTRUE;
+}
+
+eBool eBurrowsWheeler::unpack(const eByteArray &src, eByteArray &dst)
+{
+    dst.clear();
+    eArray<eU32> pred;
+
+    for (eU32 chunkStart=0; chunkStart<src.size(); )
     {
-        dst[i] = src[j];
-        j = pred[j]+count[src[j]];
+        const eU32 len = *(eU32 *)&src[chunkStart];
+        const eU32 origIdx = *(eU32 *)&src[chunkStart+sizeof(eU32)];
+        const eU8 *block = &src[chunkStart+2*sizeof(eU32)];
+        eASSERT(chunkStart+2*sizeof(eU32)+len <= src.size());
+
+        const eU32 dstStart = dst.size();
+        dst.resize(dstStart+len);
+        pred.resize(len);
+
+        eU32 count[256];
+        eMemSet(count, 0, sizeof(count));
+
+        for (eU32 i=0; i<len; i++)
+        {
+            const eU8 c = block[i];
+            pred[i] = count[c];
+            count[c]++;
+        }
+
+        for (eU32 i=0, sum=0; i<256; i++)
+        {
+            const eU32 temp = count[i];
+            count[i] = sum;
+            sum += temp;
+        }
+
+        for (eInt i=len-1, j=origIdx; i>=0; i--)
+        {
+            dst[dstStart+i] = block[j];
+            j = pred[j]+count[block[j]];
+        }
+
+        chunkStart += 2*sizeof(eU32)+len;
     }
 
     return eTRUE;
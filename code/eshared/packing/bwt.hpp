@@ -12,9 +12,19 @@
  *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
+// block-wise burrows-wheeler transform. the
+// rotations of each block are sorted via the
+// suffix array of the doubled block in O(n),
+// so the memory needed is bounded by the block
+// size and not by the size of the input.
 class eBurrowsWheeler : public eIPacker
 {
 public:
-    virtual eBool pack(const eByteArray &src, eByteArray &dst);
-    virtual eBool unpack(const eByteArray &src, eByteArray &dst);
+    eBurrowsWheeler(eU32 blockSize=1024*1024);
+
+    virtual eBool   pack(const eByteArray &src, eByteArray &dst);
+    virtual eBool   unpack(const eByteArray &src, eByteArray &dst);
+
+private:
+    const eU32      m_blockSize;
 };
\ No newline at end of file
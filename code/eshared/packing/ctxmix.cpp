@@ -0,0 +1,301 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *   This file is part of
+ *       ______        _                             __ __
+ *      / ____/____   (_)____ _ ____ ___   ____ _   / // /
+ *     / __/  / __ \ / // __ `// __ `__ \ / __ `/  / // /_
+ *    / /___ / / / // // /_/ // / / / / // /_/ /  /__  __/
+ *   /_____//_/ /_//_/ \__, //_/ /_/ /_/ \__,_/     /_/.   
+ *                    /____/                              
+ *
+ *   Copyright  2003-2012 Brain Control, all rights reserved.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "../system/system.hpp"
+#include "packing.hpp"
+
+enum : eU32
+{
+    PROB_BITS   = 12,
+    PROB_ONE    = 1<<PROB_BITS,
+    RC_TOP      = 1<<24,
+    O2_BITS     = 22,
+    NUM_INPUTS  = 3,
+    ADAPT_SHIFT = 4,
+    MIX_RATE    = 7,
+};
+
+// probability of a one bit (12 bit fixed point)
+// from the logistic domain (8 bit fixed point,
+// clamped to [-2047,2047]) by interpolation
+static eInt squash(eInt d)
+{
+    static const eInt tab[33] =
+    {
+        1, 2, 3, 6, 10, 16, 27, 45, 73, 120, 194, 310, 488, 747, 1101, 1546,
+        2047, 2549, 2994, 3348, 3607, 3785, 3901, 3975, 4022, 4050, 4068,
+        4079, 4085, 4089, 4092, 4093, 4094
+    };
+
+    if (d > 2047)
+        return PROB_ONE-1;
+    else if (d < -2047)
+        return 1;
+
+    const eInt w = d&127;
+    d = (d>>7)+16;
+    return (tab[d]*(128-w)+tab[d+1]*w+64)>>7;
+}
+
+// shared between packing and unpacking, so
+// that both sides predict exactly the same
+class eContextModel
+{
+public:
+    eContextModel() :
+        m_o1(256*256),
+        m_o2(1<<O2_BITS),
+        m_weights(256*NUM_INPUTS)
+    {
+        // inverse of squash()
+        for (eInt x=-2047, pi=0; x<=2047; x++)
+        {
+            const eInt v = squash(x);
+            for (eInt j=pi; j<=v; j++)
+                m_stretch[j] = x;
+
+            pi = v+1;
+            if (x == 2047)
+                for (eInt j=pi; j<PROB_ONE; j++)
+                    m_stretch[j] = 2047;
+        }
+
+        reset();
+    }
+
+    void reset()
+    {
+        for (eU32 i=0; i<256; i++)
+            m_o0[i] = PROB_ONE/2;
+        for (eU32 i=0; i<m_o1.size(); i++)
+            m_o1[i] = PROB_ONE/2;
+        for (eU32 i=0; i<m_o2.size(); i++)
+            m_o2[i] = PROB_ONE/2;
+        for (eU32 i=0; i<m_weights.size(); i++)
+            m_weights[i] = (1<<16)/NUM_INPUTS;
+
+        m_c0 = 1;
+        m_c4 = 0;
+        _hashOrder2();
+        _selectContexts();
+    }
+
+    eFORCEINLINE eU32 predict()
+    {
+        m_st[0] = m_stretch[*m_probs[0]];
+        m_st[1] = m_stretch[*m_probs[1]];
+        m_st[2] = m_stretch[*m_probs[2]];
+
+        m_w = &m_weights[m_c0*NUM_INPUTS];
+        const eInt dot = (m_st[0]*m_w[0]+m_st[1]*m_w[1]+m_st[2]*m_w[2])>>16;
+        m_pr = eClamp(1, squash(dot), (eInt)PROB_ONE-1);
+        return m_pr;
+    }
+
+    eFORCEINLINE void update(eU32 bit)
+    {
+        // train mixer on prediction error
+        const eInt err = (((eInt)bit<<PROB_BITS)-m_pr)*MIX_RATE;
+        m_w[0] += (m_st[0]*err+0x8000)>>16;
+        m_w[1] += (m_st[1]*err+0x8000)>>16;
+        m_w[2] += (m_st[2]*err+0x8000)>>16;
+
+        // adapt models' probabilities
+        const eInt target = (bit ? PROB_ONE-1 : 0);
+        for (eU32 i=0; i<NUM_INPUTS; i++)
+            *m_probs[i] += (target-(eInt)*m_probs[i])>>ADAPT_SHIFT;
+
+        m_c0 = (m_c0<<1)|bit;
+        m_nibble = (m_nibble<<1)|bit;
+
+        if (m_c0 >= 256)
+        {
+            m_c4 = (m_c4<<8)|(m_c0&0xff);
+            m_c0 = 1;
+            _hashOrder2();
+        }
+        else if (m_c0 >= 16 && m_c0 < 32) // first nibble done
+            _hashOrder2();
+
+        _selectContexts();
+    }
+
+private:
+    // the order-2 table is addressed in slots of
+    // 16 probabilities, one slot per nibble, so
+    // that coding a nibble touches one cache line
+    eFORCEINLINE void _hashOrder2()
+    {
+        const eU32 ctx = ((m_c4&0xffff)<<8)|m_c0;
+        m_o2Slot = &m_o2[((ctx*0x2f0b4ab3)>>(32-O2_BITS+4))<<4];
+        m_nibble = 1;
+    }
+
+    eFORCEINLINE void _selectContexts()
+    {
+        m_probs[0] = &m_o0[m_c0];
+        m_probs[1] = &m_o1[((m_c4&0xff)<<8)|m_c0];
+        m_probs[2] = &m_o2Slot[m_nibble];
+    }
+
+private:
+    eU16            m_o0[256];
+    eArray<eU16>    m_o1;
+    eArray<eU16>    m_o2;
+    eArray<eInt>    m_weights;
+    eInt            m_stretch[PROB_ONE];
+    eU16 *          m_o2Slot;
+    eU16 *          m_probs[NUM_INPUTS];
+    eInt            m_st[NUM_INPUTS];
+    eInt *          m_w;
+    eInt            m_pr;
+    eU32            m_c0;
+    eU32            m_c4;
+    eU32            m_nibble;
+};
+
+// binary range coder with carry propagation
+// (low is kept one byte wider than range)
+static void shiftLow(eU64 &low, eU8 &cache, eU32 &cacheSize, eByteArray &dst)
+{
+    if ((eU32)low < 0xff000000 || (low>>32) != 0)
+    {
+        const eU8 carry = (eU8)(low>>32);
+        for (eU8 temp=cache; cacheSize; cacheSize--, temp=0xff)
+            dst.append(temp+carry);
+
+        cache = (eU8)(low>>24);
+    }
+
+    cacheSize++;
+    low = (low&0x00ffffff)<<8;
+}
+
+eContextMixPacker::eContextMixPacker() :
+    m_model(nullptr)
+{
+}
+
+eContextMixPacker::~eContextMixPacker()
+{
+    eDelete(m_model);
+}
+
+eContextModel * eContextMixPacker::_resetModel()
+{
+    if (m_model)
+        m_model->reset();
+    else
+        m_model = new eContextModel;
+
+    return m_model;
+}
+
+eBool eContextMixPacker::pack(const eByteArray &src, eByteArray &dst)
+{
+    eContextModel *model = _resetModel();
+
+    dst.clear();
+    dst.reserve(src.size()/2+16);
+    dst.resize(sizeof(eU32));
+    (*(eU32 *)&dst[0]) = src.size();
+
+    eU64 low = 0;
+    eU32 range = eU32_MAX;
+    eU8 cache = 0;
+    eU32 cacheSize = 1;
+
+    for (eU32 i=0; i<src.size(); i++)
+    {
+        for (eInt j=7; j>=0; j--)
+        {
+            const eU32 bit = (src[i]>>j)&1;
+            const eU32 bound = (range>>PROB_BITS)*model->predict();
+
+            if (bit)
+                range = bound;
+            else
+            {
+                low += bound;
+                range -= bound;
+            }
+
+            model->update(bit);
+
+            while (range < RC_TOP)
+            {
+                range <<= 8;
+                shiftLow(low, cache, cacheSize, dst);
+            }
+        }
+    }
+
+    for (eU32 i=0; i<5; i++)
+        shiftLow(low, cache, cacheSize, dst);
+
+    return eTRUE;
+}
+
+eBool eContextMixPacker::unpack(const eByteArray &src, eByteArray &dst)
+{
+    eASSERT(src.size() >= sizeof(eU32));
+    eContextModel *model = _resetModel();
+
+    const eU32 dstSize = *(eU32 *)&src[0];
+    const eU8 *in = &src[0]+sizeof(eU32);
+    const eU8 *inEnd = &src[0]+src.size();
+    dst.resize(dstSize);
+
+    eU32 range = eU32_MAX;
+    eU32 code = 0;
+
+    for (eU32 i=0; i<5; i++)
+        code = (code<<8)|(in < inEnd ? *in++ : 0);
+
+    for (eU32 i=0; i<dstSize; i++)
+    {
+        eU32 c = 0;
+
+        for (eU32 j=0; j<8; j++)
+        {
+            const eU32 bound = (range>>PROB_BITS)*model->predict();
+            eU32 bit;
+
+            if (code < bound)
+            {
+                range = bound;
+                bit = 1;
+            }
+            else
+            {
+                code -= bound;
+                range -= bound;
+                bit = 0;
+            }
+
+            model->update(bit);
+            c = (c<<1)|bit;
+
+            while (range < RC_TOP)
+            {
+                range <<= 8;
+                code = (code<<8)|(in < inEnd ? *in++ : 0);
+            }
+        }
+
+        dst.m_data[i] = (eU8)c;
+    }
+
+    return eTRUE;
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *   This file is part of
+ *       ______        _                             __ __
+ *      / ____/____   (_)____ _ ____ ___   ____ _   / // /
+ *     / __/  / __ \ / // __ `// __ `__ \ / __ `/  / // /_
+ *    / /___ / / / // // /_/ // / / / / // /_/ /  /__  __/
+ *   /_____//_/ /_//_/ \__, //_/ /_/ /_/ \__,_/     /_/.   
+ *                    /____/                              
+ *
+ *   Copyright  2003-2012 Brain Control, all rights reserved.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// adaptive context mixing packer. each byte is
+// coded bit by bit, the bit probabilities of an
+// order-0, order-1 and a hashed order-2 model
+// are mixed in the logistic domain by a small
+// online-trained mixer and fed into a binary
+// range coder which reads and writes whole
+// bytes (no eDataStream bit i/o involved).
+// the model (about 8 mb) is allocated on first
+// use and reset for each call, so a packer can
+// be reused for many blocks.
+// todo: decoding runs at a few mb/s per thread.
+// the aim of hundreds of mb/s isn't reached, as
+// each bit needs three model lookups, a mixer
+// update and a range coder step.
+class eContextModel;
+
+class eContextMixPacker : public eIPacker
+{
+public:
+    eContextMixPacker();
+    ~eContextMixPacker();
+
+    virtual eBool   pack(const eByteArray &src, eByteArray &dst);
+    virtual eBool   unpack(const eByteArray &src, eByteArray &dst);
+
+private:
+    eContextModel * _resetModel();
+
+private:
+    eContextModel * m_model;
+};
\ No newline at end of file
@@ -15,5 +15,7 @@
 #include "ipacker.hpp"
 #include "arith.hpp"
 #include "bwt.hpp"
+#include "ctxmix.hpp"
 #include "mtf.hpp"
+#include "pipeline.hpp"
 #include "rle.hpp"
\ No newline at end of file
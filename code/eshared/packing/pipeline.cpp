@@ -0,0 +1,183 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *   This file is part of
+ *       ______        _                             __ __
+ *      / ____/____   (_)____ _ ____ ___   ____ _   / // /
+ *     / __/  / __ \ / // __ `// __ `__ \ / __ `/  / // /_
+ *    / /___ / / / // // /_/ // / / / / // /_/ /  /__  __/
+ *   /_____//_/ /_//_/ \__, //_/ /_/ /_/ \__,_/     /_/.   
+ *                    /____/                              
+ *
+ *   Copyright  2003-2012 Brain Control, all rights reserved.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "../system/system.hpp"
+#include "packing.hpp"
+
+// shared by all jobs of one pack() or unpack()
+// call. blocks are indexed by job index.
+struct PipelineJob
+{
+    const eU8 *             src;
+    eU8 *                   dst;
+    eArray<eU32>            srcOffsets;
+    eArray<eU32>            srcSizes;
+    eArray<eU32>            dstOffsets;
+    eArray<eByteArray *>    packed;
+    eArray<eContextMixPacker *> cmPackers; // not borrowed by a block
+    eMutex                  cmMutex;
+};
+
+// at most one block per thread is processed at
+// a time, so there's always a packer left
+static eContextMixPacker * borrowCmPacker(PipelineJob &job)
+{
+    eScopedLock lock(job.cmMutex);
+    eASSERT(!job.cmPackers.isEmpty());
+    return job.cmPackers.pop();
+}
+
+static void returnCmPacker(PipelineJob &job, eContextMixPacker *cm)
+{
+    eScopedLock lock(job.cmMutex);
+    job.cmPackers.push(cm);
+}
+
+static void packBlock(ePtr arg, eU32 index)
+{
+    PipelineJob &job = *(PipelineJob *)arg;
+    eByteArray block(job.src+job.srcOffsets[index], job.srcSizes[index]);
+    eByteArray temp;
+
+    eBurrowsWheeler bwt(block.size());
+    eMoveToFront mtf;
+    eTextRle rle;
+    eContextMixPacker *cm = borrowCmPacker(job);
+
+    bwt.pack(block, temp);
+    mtf.pack(temp, block);
+    rle.pack(block, temp);
+    cm->pack(temp, *job.packed[index]);
+    returnCmPacker(job, cm);
+}
+
+static void unpackBlock(ePtr arg, eU32 index)
+{
+    PipelineJob &job = *(PipelineJob *)arg;
+    eByteArray block(job.src+job.srcOffsets[index], job.srcSizes[index]);
+    eByteArray temp;
+
+    eBurrowsWheeler bwt;
+    eMoveToFront mtf;
+    eTextRle rle;
+    eContextMixPacker *cm = borrowCmPacker(job);
+
+    cm->unpack(block, temp);
+    returnCmPacker(job, cm);
+    rle.unpack(temp, block);
+    mtf.unpack(block, temp);
+    bwt.unpack(temp, block);
+
+    if (block.size())
+        eMemCopy(job.dst+job.dstOffsets[index], &block[0], block.size());
+}
+
+ePipelinePacker::ePipelinePacker(eU32 blockSize, eJobPool *jobPool) :
+    m_blockSize(blockSize),
+    m_jobPool(jobPool ? *jobPool : eJobPool::getDefault())
+{
+    eASSERT(blockSize > 0);
+
+    // models are only allocated when used
+    for (eU32 i=0; i<m_jobPool.getThreadCount(); i++)
+        m_cmPackers.append(new eContextMixPacker);
+}
+
+ePipelinePacker::~ePipelinePacker()
+{
+    for (eU32 i=0; i<m_cmPackers.size(); i++)
+        eDelete(m_cmPackers[i]);
+}
+
+// layout: [block count][raw size, packed size]
+// per block followed by the packed blocks
+eBool ePipelinePacker::pack(const eByteArray &src, eByteArray &dst)
+{
+    const eU32 numBlocks = (src.size()+m_blockSize-1)/m_blockSize;
+
+    PipelineJob job;
+    job.src = (src.size() ? &src[0] : nullptr);
+    job.dst = nullptr;
+    job.cmPackers = m_cmPackers;
+    job.srcOffsets.resize(numBlocks);
+    job.srcSizes.resize(numBlocks);
+    job.packed.resize(numBlocks);
+
+    for (eU32 i=0; i<numBlocks; i++)
+    {
+        job.srcOffsets[i] = i*m_blockSize;
+        job.srcSizes[i] = eMin(m_blockSize, src.size()-i*m_blockSize);
+        job.packed[i] = new eByteArray;
+    }
+
+    m_jobPool.run(packBlock, &job, numBlocks);
+
+    // write block index and blocks
+    const eU32 indexSize = (1+2*numBlocks)*sizeof(eU32);
+    eU32 dstSize = indexSize;
+    for (eU32 i=0; i<numBlocks; i++)
+        dstSize += job.packed[i]->size();
+
+    dst.resize(dstSize);
+    eU32 *index = (eU32 *)&dst[0];
+    *index++ = numBlocks;
+
+    for (eU32 i=0, offset=indexSize; i<numBlocks; i++)
+    {
+        const eByteArray &packed = *job.packed[i];
+        *index++ = job.srcSizes[i];
+        *index++ = packed.size();
+
+        if (packed.size())
+            eMemCopy(&dst[offset], &packed[0], packed.size());
+
+        offset += packed.size();
+        eDelete(job.packed[i]);
+    }
+
+    return eTRUE;
+}
+
+eBool ePipelinePacker::unpack(const eByteArray &src, eByteArray &dst)
+{
+    eASSERT(src.size() >= sizeof(eU32));
+    const eU32 *index = (const eU32 *)&src[0];
+    const eU32 numBlocks = *index++;
+
+    PipelineJob job;
+    job.src = &src[0];
+    job.cmPackers = m_cmPackers;
+    job.srcOffsets.resize(numBlocks);
+    job.srcSizes.resize(numBlocks);
+    job.dstOffsets.resize(numBlocks);
+
+    eU32 srcOffset = (1+2*numBlocks)*sizeof(eU32);
+    eU32 dstOffset = 0;
+
+    for (eU32 i=0; i<numBlocks; i++)
+    {
+        job.dstOffsets[i] = dstOffset;
+        job.srcOffsets[i] = srcOffset;
+        job.srcSizes[i] = index[1];
+        dstOffset += index[0];
+        srcOffset += index[1];
+        index += 2;
+    }
+
+    eASSERT(srcOffset <= src.size());
+    dst.resize(dstOffset);
+    job.dst = (dstOffset ? &dst[0] : nullptr);
+    m_jobPool.run(unpackBlock, &job, numBlocks);
+    return eTRUE;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *   This file is part of
+ *       ______        _                             __ __
+ *      / ____/____   (_)____ _ ____ ___   ____ _   / // /
+ *     / __/  / __ \ / // __ `// __ `__ \ / __ `/  / // /_
+ *    / /___ / / / // // /_/ // / / / / // /_/ /  /__  __/
+ *   /_____//_/ /_//_/ \__, //_/ /_/ /_/ \__,_/     /_/.   
+ *                    /____/                              
+ *
+ *   Copyright  2003-2012 Brain Control, all rights reserved.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// splits the input into independent blocks and
+// runs BWT, MTF, RLE and context mixing on each
+// of them on a job pool. a block index in front
+// of the packed blocks allows unpacking them in
+// parallel as well. there's one context mixing
+// packer per thread of the job pool, which the
+// blocks borrow, so their models are allocated
+// only once.
+class ePipelinePacker : public eIPacker
+{
+public:
+    ePipelinePacker(eU32 blockSize=256*1024, eJobPool *jobPool=nullptr);
+    ~ePipelinePacker();
+
+    virtual eBool   pack(const eByteArray &src, eByteArray &dst);
+    virtual eBool   unpack(const eByteArray &src, eByteArray &dst);
+
+private:
+    const eU32      m_blockSize;
+    eJobPool &      m_jobPool;
+    eArray<eContextMixPacker *> m_cmPackers;
+};
\ No newline at end of file
@@ -27,28 +27,30 @@ eBool eTextRle::pack(const eByteArray &src, eByteArray &dst)
     for (eU32 i=0; i<src.size(); )
     {
         const eU8 c0 = src[i];
-        eASSERT(c0 != m_escapeCode);
         eU32 j = i+1;
         eU32 count = 0;
 
-        while (j < src.size() && count < 0xffff)
+        // run length (count+1) has to fit in a byte
+        while (j < src.size() && count < 0xfe)
         {
             const eU8 c1 = src[j++];
 
-            if (c0 == c1 && count < 0xff)
+            if (c0 == c1)
                 count++;
             else
                 break;
         }
 
-        if (count <= 4)
+        // escape codes in the input are always
+        // written as run, so that they can't be
+        // confused with the start of a run
+        if (count <= 4 && c0 != m_escapeCode)
         {
             for (eU32 k=0; k<count+1; k++)
                 dst.append(c0);
         }
         else
         {
-            eASSERT(count <= 0xff);
             dst.append(m_escapeCode);
             dst.append(count+1);
             dst.append(c0);
@@ -72,7 +74,6 @@ eBool eTextRle::unpack(const eByteArray &src, eByteArray &dst)
         {
             const eU32 count = src[i++];
             const eU8 c1 = src[i++];
-            eASSERT(c1 != m_escapeCode);
 
             for (eU32 j=0; j<count; j++)
                 dst.append(c1);
@@ -32,6 +32,9 @@ public:
         eSfx = &m_player;
         eTfDxInit(m_tfdx, 44100);
         eTfPlayerInit(m_player, 44100);
+#ifdef eEDITOR
+        m_player.jobPool = &m_jobPool;
+#endif
         eTfDxStart(m_tfdx, m_player);
     }
 
@@ -51,6 +54,9 @@ public:
 private:
     eTfDx       m_tfdx;
     eTfPlayer   m_player;
+#ifdef eEDITOR
+    eJobPool    m_jobPool;
+#endif
 };
 
 #endif // SYNTH_HPP
\ No newline at end of file
@@ -439,64 +439,150 @@ void eTfGeneratorNormalize(eF32 *buffer)
 	}
 }
 
-void eTfGeneratorFft(eTfSynth &synth, eTfFftType type, eF32 *fftBuffer)
+// bit-reversal permutation and twiddle factors for
+// all stages are computed once. the twiddle factors
+// of the stage combining blocks of h values are
+// stored at [2*h, 4*h), each value twice, so that
+// two butterflies can be processed per SSE register.
+static void eTfGeneratorFftInit(eTfSynth &synth)
 {
-    eS32 fftFrameSize = TF_IFFT_FRAMESIZE;
-    eInt sign = (eInt)type;
+    const eU32 n = TF_IFFT_FRAMESIZE;
+    const eU32 bits = eFtoL(eLog10((eF32)n)/eLog10(2.0f));
+
+    for (eU32 i=0; i<n; i++)
+    {
+        eU32 rev = 0;
+        for (eU32 b=0; b<bits; b++)
+            rev |= ((i>>b)&1)<<(bits-b-1);
 
-    eF32 wr, wi, arg, *p1, *p2, temp;
-    eF32 tr, ti, ur, ui, *p1r, *p1i, *p2r, *p2i;
-    eInt i, bitm, j, le, le2, k;
-    eF32 fsign = (eF32)sign;
-    eF32 sine, cosine;
-    eInt count = eFtoL(eLog10((eF32)fftFrameSize)/eLog10(2.0f));
+        synth.fftBitRev[i] = (eU16)rev;
+    }
 
-    for (i = 2; i < 2*fftFrameSize-2; i += 2) 
+    for (eU32 h=1; h<n; h<<=1)
     {
-        for (bitm = 2, j = 0; bitm < 2*fftFrameSize; bitm <<= 1) 
+        for (eU32 j=0; j<h; j++)
         {
-            if (i & bitm) j++;
-            j <<= 1;
+            eF32 sine, cosine;
+            eSinCos(ePI*(eF32)j/(eF32)h, sine, cosine);
+
+            synth.fftCos[2*(h+j)] = synth.fftCos[2*(h+j)+1] = cosine;
+            synth.fftSin[2*(h+j)] = synth.fftSin[2*(h+j)+1] = sine;
         }
+    }
+}
+
+// multiplies two interleaved complex values with
+// the twiddle factors (wr+i*wi), sign has to be
+// (-s, s, -s, s) with s being the FFT's direction
+static eFORCEINLINE eF32x4 eTfFftMul(eF32x4 v, eF32x4 wr, eF32x4 wi, eF32x4 sign)
+{
+    return eSimdAdd(eSimdMul(v, wr), eSimdMul(eSimdMul(eSimdSelect(v, 2, 3, 0, 1), wi), sign));
+}
+
+void eTfGeneratorFft(eTfSynth &synth, eTfFftType type, eF32 *fftBuffer)
+{
+    const eU32 n = TF_IFFT_FRAMESIZE;
+    const eF32 fsign = (eF32)type;
+    const eF32x4 sign = eSimdSet(fsign, -fsign, fsign, -fsign);
+
+    for (eU32 i=1; i<n-1; i++)
+    {
+        const eU32 j = synth.fftBitRev[i];
 
         if (i < j) 
         {
-            p1 = fftBuffer+i; p2 = fftBuffer+j;
-            temp = *p1; *(p1++) = *p2;
-            *(p2++) = temp; temp = *p1;
-            *p1 = *p2; *p2 = temp;
+            eF32 *p1 = fftBuffer+2*i;
+            eF32 *p2 = fftBuffer+2*j;
+            eF32 temp;
+
+            temp = p1[0]; p1[0] = p2[0]; p2[0] = temp;
+            temp = p1[1]; p1[1] = p2[1]; p2[1] = temp;
         }
     }
-    for (k = 0, le = 2; k < count; k++) 
+
+    // the first two stages are merged into one
+    // radix-4 pass, their twiddle factors are
+    // only 1 and +-i, so no multiplies needed
+    for (eU32 i=0; i<2*n; i+=8) 
     {
-        le <<= 1;
-        le2 = le>>1;
-        ur = 1.0;
-        ui = 0.0;
-        arg = ePI / (le2>>1);
+        eF32 *x = fftBuffer+i;
+
+        const eF32 b0r = x[0]+x[2], b0i = x[1]+x[3];
+        const eF32 b1r = x[0]-x[2], b1i = x[1]-x[3];
+        const eF32 b2r = x[4]+x[6], b2i = x[5]+x[7];
+        const eF32 b3r = x[4]-x[6], b3i = x[5]-x[7];
+        const eF32 tr = -fsign*b3i, ti = fsign*b3r;
+
+        x[0] = b0r+b2r; x[1] = b0i+b2i;
+        x[4] = b0r-b2r; x[5] = b0i-b2i;
+        x[2] = b1r+tr;  x[3] = b1i+ti;
+        x[6] = b1r-tr;  x[7] = b1i-ti;
+    }
 
-        eSinCos(arg, sine, cosine);
-        wr = cosine;
-        wi = fsign * sine;
+    // remaining stages are merged pairwise into
+    // radix-4 passes (halving the passes over the
+    // buffer), two butterflies per SSE register
+    eU32 h = 4;
 
-        for (j = 0; j < le2; j += 2) 
-        {
-            p1r = fftBuffer+j; p1i = p1r+1;
-            p2r = p1r+le2; p2i = p2r+1;
+    for (; 4*h<=n; h*=4)
+    {
+        const eF32 *c1 = &synth.fftCos[2*h];
+        const eF32 *s1 = &synth.fftSin[2*h];
+        const eF32 *c2 = &synth.fftCos[4*h];
+        const eF32 *s2 = &synth.fftSin[4*h];
 
-            for (i = j; i < 2*fftFrameSize; i += le) 
+        for (eU32 g=0; g<n; g+=4*h)
+        {
+            for (eU32 j=0; j<h; j+=2)
             {
-                tr = *p2r * ur - *p2i * ui;
-                ti = *p2r * ui + *p2i * ur;
-                *p2r = *p1r - tr; *p2i = *p1i - ti;
-                *p1r += tr; *p1i += ti;
-                p1r += le; p1i += le;
-                p2r += le; p2i += le;
+                eF32 *x0 = fftBuffer+2*(g+j);
+                eF32 *x1 = x0+2*h;
+                eF32 *x2 = x1+2*h;
+                eF32 *x3 = x2+2*h;
+
+                const eF32x4 a0 = eSimdLoad(x0);
+                const eF32x4 a2 = eSimdLoad(x2);
+                const eF32x4 w1r = eSimdLoad(c1+2*j);
+                const eF32x4 w1i = eSimdLoad(s1+2*j);
+
+                eF32x4 t = eTfFftMul(eSimdLoad(x1), w1r, w1i, sign);
+                const eF32x4 b0 = eSimdAdd(a0, t);
+                const eF32x4 b1 = eSimdSub(a0, t);
+
+                t = eTfFftMul(eSimdLoad(x3), w1r, w1i, sign);
+                const eF32x4 b2 = eSimdAdd(a2, t);
+                const eF32x4 b3 = eSimdSub(a2, t);
+
+                t = eTfFftMul(b2, eSimdLoad(c2+2*j), eSimdLoad(s2+2*j), sign);
+                eSimdStore(eSimdAdd(b0, t), x0);
+                eSimdStore(eSimdSub(b0, t), x2);
+
+                t = eTfFftMul(b3, eSimdLoad(c2+2*(j+h)), eSimdLoad(s2+2*(j+h)), sign);
+                eSimdStore(eSimdAdd(b1, t), x1);
+                eSimdStore(eSimdSub(b1, t), x3);
             }
+        }
+    }
+
+    // odd number of stages left: one radix-2 pass
+    if (h < n)
+    {
+        const eF32 *c1 = &synth.fftCos[2*h];
+        const eF32 *s1 = &synth.fftSin[2*h];
+
+        for (eU32 g=0; g<n; g+=2*h)
+        {
+            for (eU32 j=0; j<h; j+=2)
+            {
+                eF32 *x0 = fftBuffer+2*(g+j);
+                eF32 *x1 = x0+2*h;
 
-            tr = ur*wr - ui*wi;
-            ui = ur*wi + ui*wr;
-            ur = tr;
+                const eF32x4 a0 = eSimdLoad(x0);
+                const eF32x4 t = eTfFftMul(eSimdLoad(x1), eSimdLoad(c1+2*j), eSimdLoad(s1+2*j), sign);
+
+                eSimdStore(eSimdAdd(a0, t), x0);
+                eSimdStore(eSimdSub(a0, t), x1);
+            }
         }
     }
 }
@@ -615,6 +701,110 @@ eBool eTfGeneratorModulate(eTfSynth &synth, eTfInstrument &instr, eTfVoice &voic
     return eTRUE;
 }
 
+// oscillator bank rendering all unison phases, four
+// per SSE register with left and right phases being
+// interleaved. every unison pair shares the same
+// volume ramp, so the clipped oscillators are summed
+// up first and the ramp is applied once at the end.
+static void eTfGeneratorRenderUnisono(eTfGenerator &generator, eU32 unisono, eF32 spread, eF32 drive,
+                                      eF32 volLeft, eF32 volRight, eF32 lastVolLeft, eF32 lastVolRight,
+                                      eF32 **signal, eU32 frameSize)
+{
+    eALIGN16 eF32 mix[TF_MAXFRAMESIZE*4];
+    eALIGN16 eF32 freqs[2*TF_MAXUNISONO];
+    eALIGN16 eS32 offsets[4];
+
+    const eU32 lanes = unisono*2;
+    const eF32 *table = generator.resultTable;
+
+    for (eU32 j=0; j<TF_MAXUNISONO; j++)
+    {
+        freqs[j*2] = (j < unisono ? generator.freq1 : 0.0f);
+        freqs[j*2+1] = (j < unisono ? generator.freq2 : 0.0f);
+
+        if (j < unisono)
+        {
+            generator.freq1 += spread;
+            generator.freq2 -= spread;
+        }
+    }
+
+    const eF32x4 mdrive = eSimdSetAll(drive);
+    const eF32x4 mmin = eSimdSetAll(-1.0f);
+    const eF32x4 mmax = eSimdSetAll(1.0f);
+    const eF32x4 mone = eSimdSetAll(1.0f);
+    const eF32x4 mscale = eSimdSetAll((eF32)(TF_IFFT_FRAMESIZE-1));
+
+    for (eU32 g=0; g<lanes; g+=4)
+    {
+        // with an odd unison count the upper two
+        // lanes of the last register are unused
+        const eF32x4 mask = _mm_castsi128_ps(g+4 <= lanes ? _mm_set1_epi32(-1) : _mm_set_epi32(0, 0, -1, -1));
+        const eF32x4 freq = eSimdLoadAligned(&freqs[g]);
+        eF32x4 phase = eSimdLoad(&generator.phase[g]);
+        eF32 *out = mix;
+
+        for (eU32 i=0; i<frameSize; i++, out+=4)
+        {
+            // wrap phases outside of [0, 1] by their
+            // floor, this also catches the negative
+            // frequencies caused by a large spread
+            eF32x4 floor = _mm_cvtepi32_ps(_mm_cvttps_epi32(phase));
+            floor = eSimdSub(floor, _mm_and_ps(_mm_cmpgt_ps(floor, phase), mone));
+            const eF32x4 wrap = _mm_or_ps(_mm_cmpgt_ps(phase, mone), _mm_cmplt_ps(phase, eSimdZero()));
+            phase = eSimdSub(phase, _mm_and_ps(wrap, floor));
+
+            _mm_store_si128((__m128i *)offsets, _mm_slli_epi32(_mm_cvtps_epi32(eSimdMul(phase, mscale)), 1));
+            const eF32x4 val = eSimdSet(table[offsets[3]], table[offsets[2]], table[offsets[1]], table[offsets[0]]);
+
+            eF32x4 osc = _mm_and_ps(eSimdMax(eSimdMin(eSimdMul(val, mdrive), mmax), mmin), mask);
+            if (g > 0)
+                osc = eSimdAdd(osc, eSimdLoadAligned(out));
+
+            eSimdStoreAligned(osc, out);
+            phase = eSimdAdd(phase, freq);
+        }
+
+        eSimdStore(phase, &generator.phase[g]);
+    }
+
+    // sum up the left (lanes 0 and 2) and right
+    // (lanes 1 and 3) oscillators, four samples
+    // at once by transposing them
+    const eF32 stepLeft = (volLeft-lastVolLeft)/frameSize;
+    const eF32 stepRight = (volRight-lastVolRight)/frameSize;
+
+    eF32x4 mvolLeft = eSimdSet(lastVolLeft+3.0f*stepLeft, lastVolLeft+2.0f*stepLeft, lastVolLeft+stepLeft, lastVolLeft);
+    eF32x4 mvolRight = eSimdSet(lastVolRight+3.0f*stepRight, lastVolRight+2.0f*stepRight, lastVolRight+stepRight, lastVolRight);
+    const eF32x4 mstepLeft = eSimdSetAll(4.0f*stepLeft);
+    const eF32x4 mstepRight = eSimdSetAll(4.0f*stepRight);
+
+    eF32 *sig1 = signal[0];
+    eF32 *sig2 = signal[1];
+    eU32 i = 0;
+
+    for (; i+4<=frameSize; i+=4)
+    {
+        eF32x4 row0 = eSimdLoadAligned(&mix[i*4]);
+        eF32x4 row1 = eSimdLoadAligned(&mix[i*4+4]);
+        eF32x4 row2 = eSimdLoadAligned(&mix[i*4+8]);
+        eF32x4 row3 = eSimdLoadAligned(&mix[i*4+12]);
+        eSimdTranspose(row0, row1, row2, row3);
+
+        eSimdStore(eSimdFma(eSimdLoad(&sig1[i]), eSimdAdd(row0, row2), mvolLeft), &sig1[i]);
+        eSimdStore(eSimdFma(eSimdLoad(&sig2[i]), eSimdAdd(row1, row3), mvolRight), &sig2[i]);
+
+        mvolLeft = eSimdAdd(mvolLeft, mstepLeft);
+        mvolRight = eSimdAdd(mvolRight, mstepRight);
+    }
+
+    for (; i<frameSize; i++)
+    {
+        sig1[i] += (mix[i*4]+mix[i*4+2])*(lastVolLeft+i*stepLeft);
+        sig2[i] += (mix[i*4+1]+mix[i*4+3])*(lastVolRight+i*stepRight);
+    }
+}
+
 eBool eTfGeneratorProcess(eTfSynth &synth, eTfInstrument &instr, eTfVoice &voice, eTfGenerator &generator, eF32 velocity, eF32 **signal, eU32 frameSize)
 {
     eF32 vol = instr.params[TF_GEN_VOLUME] * 4.0f * velocity;
@@ -678,57 +868,8 @@ eBool eTfGeneratorProcess(eTfSynth &synth, eTfInstrument &instr, eTfVoice &voice
 
         // calculate signal
         // -------------------------------------------------
-        eF32x2 mdrive = eSimdSetAll(drive);        
-        eF32x2 mmin = eSimdSetAll(-1.0f);
-        eF32x2 mmax = eSimdSetAll(1.0f);
-
-        for (eU32 j=0; j<unisono; j++)
-        {
-            eF32 *sig1 = signal[0];
-            eF32 *sig2 = signal[1];
-            eF32 *phase1 = &generator.phase[j*2];
-            eF32 *phase2 = &generator.phase[j*2+1];
-
-			eF32x2 mvol = eSimdSet2(voice.lastVolL, voice.lastVolR);
-			eF32x2 mvol_step = eSimdSet2((vol_left - voice.lastVolL) / frameSize, 
-				                         (vol_right - voice.lastVolR) / frameSize);
-			
-            eU32 len = frameSize;
-            while(len--)
-            {
-                eU32 off1 = eFtoL(*phase1 * (TF_IFFT_FRAMESIZE-1)) * 2;
-                eU32 off2 = eFtoL(*phase2 * (TF_IFFT_FRAMESIZE-1)) * 2;
-
-                eF32 val1 = generator.resultTable[off1];
-                eF32 val2 = generator.resultTable[off2];
-
-                eF32x2 mval = eSimdMul(
-                    eSimdMax(
-                        eSimdMin(
-                            eSimdMul(
-                                eSimdSet2(val1, val2), 
-                                mdrive),
-                            mmax),
-                        mmin),
-                    mvol);
-
-                eF32 store_l, store_r;
-                eSimdStore2(mval, store_l, store_r);
-                *sig1++ += store_l;
-                *sig2++ += store_r;
-
-                *phase1 += generator.freq1;
-                while (*phase1 > 1.0f) { *phase1 -= 1.0f; }
-
-                *phase2 += generator.freq2;
-                while (*phase2 > 1.0f) { *phase2 -= 1.0f; }
-
-				mvol = eSimdAdd(mvol, mvol_step);
-            }
-
-            generator.freq1 += spread;
-            generator.freq2 -= spread;
-        }
+        eTfGeneratorRenderUnisono(generator, unisono, spread, drive, vol_left, vol_right,
+                                  voice.lastVolL, voice.lastVolR, signal, frameSize);
 
 		voice.lastVolL = vol_left;
 		voice.lastVolR = vol_right;
@@ -807,10 +948,33 @@ eBool eTfNoiseProcess(eTfSynth &synth, eTfInstrument &instr, eTfNoise &state, eF
 // FILTER
 // ------------------------------------------------------------------------------------
 
+// the coefficients of the last frame are kept to
+// fade over to new ones, avoiding zipper noise
+static void eTfFilterSettle(eTfFilter &state)
+{
+    state.lastK = state.k;
+    state.lastP = state.p;
+    state.lastR = state.r;
+    state.lastA1 = state.a1;
+    state.lastA2 = state.a2;
+    state.lastB0 = state.b0;
+    state.lastB1 = state.b1;
+    state.lastB2 = state.b2;
+}
+
 void eTfFilterUpdate(eTfSynth &synth, eTfFilter &state, eF32 f, eF32 q, eBool isHighPass)
 {
     f = eClamp<eF32>(0.0f, f, 1.0f);
     q = eClamp<eF32>(0.0f, q, 0.9f);
+
+    // unless cutoff or resonance are modulated they
+    // stay the same over many frames
+    if (state.valid && f == state.f && q == state.q && synth.sampleRate == state.sampleRate)
+        return;
+
+    state.f = f;
+    state.q = q;
+    state.sampleRate = synth.sampleRate;
         
     if (!isHighPass)
     {
@@ -845,98 +1009,222 @@ void eTfFilterUpdate(eTfSynth &synth, eTfFilter &state, eF32 f, eF32 q, eBool is
         state.a1 /= state.a0;
         state.a2 /= state.a0;
     }
+
+    if (!state.valid)
+    {
+        eTfFilterSettle(state);
+        state.valid = eTRUE;
+    }
 }
 
-void eTfFilterProcess(eTfFilter &state, eBool highpass, eF32 **signal, eU32 frameSize)
+// the SSE lanes hold left and right channel of the
+// first and left and right channel of the second
+// filter
+static eFORCEINLINE eF32x4 eTfFilterGather(const eF32 *v0, const eF32 *v1)
 {
-    eASSERT_ALIGNED16(&state);
-
-    eF32 *signal1 = signal[0];
-    eF32 *signal2 = signal[1];
-    eU32 len = frameSize;
+    return eSimdSet(v1[1], v1[0], v0[1], v0[0]);
+}
 
-    if (!highpass)
-    {
-        eF32x2 p = eSimdSetAll(state.p);
-        eF32x2 r = eSimdSetAll(state.r);
-        eF32x2 k = eSimdSetAll(state.k);
+static eFORCEINLINE eF32x4 eTfFilterGather(eF32 v0, eF32 v1)
+{
+    return eSimdSet(v1, v1, v0, v0);
+}
 
-        eF32x2 x;
-        eF32x2 const_6 = eSimdSetAll(1.0f / 6.0f);
+static eFORCEINLINE void eTfFilterScatter(eF32x4 v, eF32 *v0, eF32 *v1)
+{
+    eALIGN16 eF32 buf[4];
+    eSimdStoreAligned(v, buf);
+    v0[0] = buf[0];
+    v0[1] = buf[1];
+    v1[0] = buf[2];
+    v1[1] = buf[3];
+}
 
-        while (len--)
-        {
-            eF32x2 in = eSimdSet2((eF32)*signal1, (eF32)*signal2);
+static eFORCEINLINE eF32x4 eTfFilterLowpass(eF32x4 in, eF32x4 k, eF32x4 p, eF32x4 r,
+                                            eF32x4 &oldx, eF32x4 &y1, eF32x4 &y2, eF32x4 &y3, eF32x4 &y4)
+{
+    // x = in - r * y4
+    const eF32x4 x = eSimdNfma(in, r, y4);
+
+    // y1 = x*p + oldx*p - k*y1 and so on for y2 to y4
+    const eF32x4 ny1 = eSimdNfma(eSimdFma(eSimdMul(oldx, p), x, p), k, y1);
+    const eF32x4 ny2 = eSimdNfma(eSimdFma(eSimdMul(y1, p), ny1, p), k, y2);
+    const eF32x4 ny3 = eSimdNfma(eSimdFma(eSimdMul(y2, p), ny2, p), k, y3);
+    y4 = eSimdNfma(eSimdFma(eSimdMul(y3, p), ny3, p), k, y4);
+
+    oldx = x;
+    y1 = ny1;
+    y2 = ny2;
+    y3 = ny3;
+
+    // out = y4 - (y4*y4*y4)/6
+    return eSimdNfma(y4, eSimdMul(eSimdMul(y4, y4), y4), eSimdSetAll(1.0f/6.0f));
+}
 
-            // x = in - r * y4
-            x = eSimdNfma(in, r, state.y4);
+static eFORCEINLINE eF32x4 eTfFilterHighpass(eF32x4 in, eF32x4 b0, eF32x4 b1, eF32x4 b2, eF32x4 a1, eF32x4 a2,
+                                             eF32x4 &in1, eF32x4 &in2, eF32x4 &out1, eF32x4 &out2)
+{
+    const eF32x4 out = eSimdNfma(eSimdNfma(eSimdFma(eSimdFma(eSimdMul(b0, in), b1, in1), b2, in2), a1, out1), a2, out2);
 
-            // state->y1_l=x_l*state->p + state->oldx_l*state->p - state->k*state->y1_l;
-            state.y1 = eSimdNfma(eSimdFma(eSimdMul(state.oldx, p), x, p), k, state.y1);
+    in2 = in1;
+    in1 = in;
+    out2 = out1;
+    out1 = out;
+    return out;
+}
 
-            //state->y2_l=state->y1_l*state->p+state->oldy1_l*state->p - state->k*state->y2_l;
-            state.y2 = eSimdNfma(eSimdFma(eSimdMul(state.oldy1, p), state.y1, p), k, state.y2);
+void eTfFilterProcess(eTfFilter &state, eBool highpass, eF32 **signal, eU32 frameSize)
+{
+    // both register halves run the same filter
+    // and store the same result
+    eTfFilterProcess2(state, state, highpass, signal, signal, frameSize);
+}
 
-            //state->y3_l=state->y2_l*state->p+state->oldy2_l*state->p - state->k*state->y3_l;
-            state.y3 = eSimdNfma(eSimdFma(eSimdMul(state.oldy2, p), state.y2, p), k, state.y3);
+// processes two stereo filters at once. samples are
+// transposed in blocks of four, coefficients fade
+// from the last to the new ones block by block.
+void eTfFilterProcess2(eTfFilter &state0, eTfFilter &state1, eBool highpass, eF32 **signal0, eF32 **signal1, eU32 frameSize)
+{
+    eF32 *ch0 = signal0[0];
+    eF32 *ch1 = signal0[1];
+    eF32 *ch2 = signal1[0];
+    eF32 *ch3 = signal1[1];
 
-            //state->y4_l=state->y3_l*state->p+state->oldy3_l*state->p - state->k*state->y4_l;
-            state.y4 = eSimdNfma(eSimdFma(eSimdMul(state.oldy3, p), state.y3, p), k, state.y4);
+    const eF32 blockStep = 4.0f/(eF32)frameSize;
+    eALIGN16 eF32 buf[4];
+    eU32 i = 0;
 
-            //out_l = state->y4_l - (state->y4_l*state->y4_l*state->y4_l)/6;
-            eF32x2 out = eSimdNfma(state.y4, eSimdMul(eSimdMul(state.y4, state.y4), state.y4), const_6);
+    if (!highpass)
+    {
+        eF32x4 k = eTfFilterGather(state0.lastK, state1.lastK);
+        eF32x4 p = eTfFilterGather(state0.lastP, state1.lastP);
+        eF32x4 r = eTfFilterGather(state0.lastR, state1.lastR);
+        const eF32x4 dk = eSimdMulScalar(eSimdSub(eTfFilterGather(state0.k, state1.k), k), blockStep);
+        const eF32x4 dp = eSimdMulScalar(eSimdSub(eTfFilterGather(state0.p, state1.p), p), blockStep);
+        const eF32x4 dr = eSimdMulScalar(eSimdSub(eTfFilterGather(state0.r, state1.r), r), blockStep);
+
+        eF32x4 oldx = eTfFilterGather(state0.oldx, state1.oldx);
+        eF32x4 y1 = eTfFilterGather(state0.y1, state1.y1);
+        eF32x4 y2 = eTfFilterGather(state0.y2, state1.y2);
+        eF32x4 y3 = eTfFilterGather(state0.y3, state1.y3);
+        eF32x4 y4 = eTfFilterGather(state0.y4, state1.y4);
+
+        for (; i+4<=frameSize; i+=4)
+        {
+            k = eSimdAdd(k, dk);
+            p = eSimdAdd(p, dp);
+            r = eSimdAdd(r, dr);
+
+            eF32x4 s0 = eSimdLoad(&ch0[i]);
+            eF32x4 s1 = eSimdLoad(&ch1[i]);
+            eF32x4 s2 = eSimdLoad(&ch2[i]);
+            eF32x4 s3 = eSimdLoad(&ch3[i]);
+            eSimdTranspose(s0, s1, s2, s3);
+
+            s0 = eTfFilterLowpass(s0, k, p, r, oldx, y1, y2, y3, y4);
+            s1 = eTfFilterLowpass(s1, k, p, r, oldx, y1, y2, y3, y4);
+            s2 = eTfFilterLowpass(s2, k, p, r, oldx, y1, y2, y3, y4);
+            s3 = eTfFilterLowpass(s3, k, p, r, oldx, y1, y2, y3, y4);
+
+            eSimdTranspose(s0, s1, s2, s3);
+            eSimdStore(s0, &ch0[i]);
+            eSimdStore(s1, &ch1[i]);
+            eSimdStore(s2, &ch2[i]);
+            eSimdStore(s3, &ch3[i]);
+        }
 
-            state.oldx = x;
-            state.oldy1 = state.y1;
-            state.oldy2 = state.y2;
-            state.oldy3 = state.y3;
+        k = eTfFilterGather(state0.k, state1.k);
+        p = eTfFilterGather(state0.p, state1.p);
+        r = eTfFilterGather(state0.r, state1.r);
 
-            eSimdStore2(out, *signal1, *signal2);
-            signal1++;
-            signal2++;
+        for (; i<frameSize; i++)
+        {
+            eF32x4 s = eSimdSet(ch3[i], ch2[i], ch1[i], ch0[i]);
+            s = eTfFilterLowpass(s, k, p, r, oldx, y1, y2, y3, y4);
+
+            eSimdStoreAligned(s, buf);
+            ch0[i] = buf[0];
+            ch1[i] = buf[1];
+            ch2[i] = buf[2];
+            ch3[i] = buf[3];
         }
 
-        state.y1 = state.oldy1;
-        state.y2 = state.oldy2;
-        state.y3 = state.oldy3;
+        eTfFilterScatter(oldx, state0.oldx, state1.oldx);
+        eTfFilterScatter(y1, state0.y1, state1.y1);
+        eTfFilterScatter(y2, state0.y2, state1.y2);
+        eTfFilterScatter(y3, state0.y3, state1.y3);
+        eTfFilterScatter(y4, state0.y4, state1.y4);
     }
     else
     {
-        eF32x2 b0 = eSimdSetAll(state.b0);
-        eF32x2 b1 = eSimdSetAll(state.b1);
-        eF32x2 b2 = eSimdSetAll(state.b2);
-        eF32x2 a1 = eSimdSetAll(state.a1);
-        eF32x2 a2 = eSimdSetAll(state.a2);
+        eF32x4 b0 = eTfFilterGather(state0.lastB0, state1.lastB0);
+        eF32x4 b1 = eTfFilterGather(state0.lastB1, state1.lastB1);
+        eF32x4 b2 = eTfFilterGather(state0.lastB2, state1.lastB2);
+        eF32x4 a1 = eTfFilterGather(state0.lastA1, state1.lastA1);
+        eF32x4 a2 = eTfFilterGather(state0.lastA2, state1.lastA2);
+        const eF32x4 db0 = eSimdMulScalar(eSimdSub(eTfFilterGather(state0.b0, state1.b0), b0), blockStep);
+        const eF32x4 db1 = eSimdMulScalar(eSimdSub(eTfFilterGather(state0.b1, state1.b1), b1), blockStep);
+        const eF32x4 db2 = eSimdMulScalar(eSimdSub(eTfFilterGather(state0.b2, state1.b2), b2), blockStep);
+        const eF32x4 da1 = eSimdMulScalar(eSimdSub(eTfFilterGather(state0.a1, state1.a1), a1), blockStep);
+        const eF32x4 da2 = eSimdMulScalar(eSimdSub(eTfFilterGather(state0.a2, state1.a2), a2), blockStep);
+
+        eF32x4 in1 = eTfFilterGather(state0.in1, state1.in1);
+        eF32x4 in2 = eTfFilterGather(state0.in2, state1.in2);
+        eF32x4 out1 = eTfFilterGather(state0.out1, state1.out1);
+        eF32x4 out2 = eTfFilterGather(state0.out2, state1.out2);
+
+        for (; i+4<=frameSize; i+=4)
+        {
+            b0 = eSimdAdd(b0, db0);
+            b1 = eSimdAdd(b1, db1);
+            b2 = eSimdAdd(b2, db2);
+            a1 = eSimdAdd(a1, da1);
+            a2 = eSimdAdd(a2, da2);
+
+            eF32x4 s0 = eSimdLoad(&ch0[i]);
+            eF32x4 s1 = eSimdLoad(&ch1[i]);
+            eF32x4 s2 = eSimdLoad(&ch2[i]);
+            eF32x4 s3 = eSimdLoad(&ch3[i]);
+            eSimdTranspose(s0, s1, s2, s3);
+
+            s0 = eTfFilterHighpass(s0, b0, b1, b2, a1, a2, in1, in2, out1, out2);
+            s1 = eTfFilterHighpass(s1, b0, b1, b2, a1, a2, in1, in2, out1, out2);
+            s2 = eTfFilterHighpass(s2, b0, b1, b2, a1, a2, in1, in2, out1, out2);
+            s3 = eTfFilterHighpass(s3, b0, b1, b2, a1, a2, in1, in2, out1, out2);
+
+            eSimdTranspose(s0, s1, s2, s3);
+            eSimdStore(s0, &ch0[i]);
+            eSimdStore(s1, &ch1[i]);
+            eSimdStore(s2, &ch2[i]);
+            eSimdStore(s3, &ch3[i]);
+        }
 
-        while(len--)
+        b0 = eTfFilterGather(state0.b0, state1.b0);
+        b1 = eTfFilterGather(state0.b1, state1.b1);
+        b2 = eTfFilterGather(state0.b2, state1.b2);
+        a1 = eTfFilterGather(state0.a1, state1.a1);
+        a2 = eTfFilterGather(state0.a2, state1.a2);
+
+        for (; i<frameSize; i++)
         {
-            eF32x2 in = eSimdSet2(*signal1, *signal2);
-
-            eF32x2 out = eSimdNfma(   
-                            eSimdNfma(      
-                                eSimdFma(
-                                    eSimdFma( 
-                                        eSimdMul(b0, in),
-                                        b1, state.in1
-                                        ),
-                                    b2, state.in2
-                                    ),
-                                a1, state.out1
-                                ),
-                            a2, state.out2
-                         );
-
-            eSimdStore2(out, *signal1, *signal2);
-
-            signal1++;
-            signal2++;
-
-            state.in2 = state.in1;
-            state.in1 = in;
-            state.out2 = state.out1;
-            state.out1 = out;
+            eF32x4 s = eSimdSet(ch3[i], ch2[i], ch1[i], ch0[i]);
+            s = eTfFilterHighpass(s, b0, b1, b2, a1, a2, in1, in2, out1, out2);
+
+            eSimdStoreAligned(s, buf);
+            ch0[i] = buf[0];
+            ch1[i] = buf[1];
+            ch2[i] = buf[2];
+            ch3[i] = buf[3];
         }
+
+        eTfFilterScatter(in1, state0.in1, state1.in1);
+        eTfFilterScatter(in2, state0.in2, state1.in2);
+        eTfFilterScatter(out1, state0.out1, state1.out1);
+        eTfFilterScatter(out2, state0.out2, state1.out2);
     }
+
+    eTfFilterSettle(state0);
+    eTfFilterSettle(state1);
 }
 
 // ------------------------------------------------------------------------------------
@@ -1000,6 +1288,154 @@ void eTfInstrumentInit(eTfSynth &synth, eTfInstrument &instr)
         eTfVoiceReset(instr.voice[i]);
 }
 
+// makes sure the effect pool holds instances for
+// the current effect slots. has to be called from
+// outside the audio thread whenever they change.
+void eTfInstrumentPrepareEffects(eTfInstrument &instr)
+{
+    eU32 fxIndices[TF_MAXEFFECTS];
+
+    for(eU32 i=0; i<TF_MAXEFFECTS; i++)
+        fxIndices[i] = eFtoL(eRound(instr.params[TF_EFFECT_1 + i] * (FX_COUNT-1)));
+
+    eTfEffectPoolPrepare(instr.effectPool, fxIndices);
+}
+
+// renders oscillators and noise of a voice into the
+// given buffers and updates its filter coefficients.
+// filtering and mixing is done for two voices at once
+// by eTfInstrumentFilterVoices().
+static void eTfInstrumentRenderVoice(eTfSynth &synth, eTfInstrument &instr, eTfVoice &voice, eF32 **signal, eU32 frameSize)
+{
+    // the player splits frames at events, so all
+    // per call steps are scaled by the block size.
+    // voice time is counted in samples.
+    const eU32 time = voice.time;
+    voice.time += frameSize;
+
+    //  RUN MOD MATRIX
+    // -------------------------------------------------------------------------------
+    eBool has_mm_active = eTfModMatrixProcess(synth, instr, voice.modMatrix, frameSize);
+    instr.lfo1Phase = voice.modMatrix.lfoState[0].phase;
+    instr.lfo2Phase = voice.modMatrix.lfoState[1].phase;
+
+    //  CALCULATE VELOCITY
+    // -------------------------------------------------------------------------------
+    eF32 velocity = (eF32)voice.currentVelocity / 128.0f;
+    if (!has_mm_active && !voice.noteIsOn)
+        velocity = 0.0f;
+
+    //  RUN NOISE GEN
+    // -------------------------------------------------------------------------------
+    eTfNoiseUpdate(synth, instr, voice.noiseGen, voice.modMatrix, velocity);
+    eBool has_noise = eTfNoiseProcess(synth, instr, voice.noiseGen, signal, frameSize);
+
+    //  CALCULATE FREQUENCY
+    // -------------------------------------------------------------------------------
+    eF32 baseFreq = synth.freqTable[voice.currentNote & 0x7f];
+    eF32 slop = ePow(instr.params[TF_GEN_SLOP], 3);
+    baseFreq += voice.currentSlop * slop * 8.0f;
+
+    eF32 glide = instr.params[TF_GEN_GLIDE];
+    if (glide > 0.0f && voice.currentFreq > 0.0f)
+    {
+        // approaches the target frequency by a fixed
+        // ratio per TF_FRAMESIZE samples
+        eF32 keep = glide * 10.0f / (glide * 10.0f + 1.0f);
+        keep = ePow(keep, (eF32)frameSize / TF_FRAMESIZE);
+        voice.currentFreq = baseFreq - (baseFreq - voice.currentFreq) * keep;
+    }
+    else
+        voice.currentFreq = baseFreq;
+
+    //  RUN GENERATOR
+    // -------------------------------------------------------------------------------
+    // reduce cpu hit a bit. recalculate not more than every 4th frame,
+    // in the block which covers the next multiple of 4 frames
+    const eU32 updatePeriod = 4 * TF_FRAMESIZE;
+
+    if ((time + updatePeriod - 1) / updatePeriod * updatePeriod < time + frameSize)
+    {
+        eTfGeneratorUpdate(synth, instr, voice, voice.generator);
+
+        if (eTfGeneratorModulate(synth, instr, voice, voice.generator))
+            eMemCopy(voice.generator.resultTable, voice.generator.freqModTable, TF_IFFT_FRAMESIZE * sizeof(eF32) * 2);
+        else
+            eMemCopy(voice.generator.resultTable, voice.generator.freqTable, TF_IFFT_FRAMESIZE * sizeof(eF32) * 2);
+        
+        eTfGeneratorFft(synth, IFFT, voice.generator.resultTable);
+        eTfGeneratorNormalize(voice.generator.resultTable);
+    }
+    
+    eBool has_gen = eTfGeneratorProcess(synth, instr, voice, voice.generator, velocity, signal, frameSize);
+
+    // update voice state
+    voice.playing = has_noise || has_gen;
+
+    //  UPDATE LOWPASS FILTER
+    // -------------------------------------------------------------------------------
+    if (instr.params[TF_LP_FILTER_ON] > 0.5f)
+    {
+        eF32 lpCutoff = instr.params[TF_LP_FILTER_CUTOFF];
+        eF32 lpResonance = instr.params[TF_LP_FILTER_RESONANCE];
+
+        lpCutoff *= eTfModMatrixGet(voice.modMatrix, eTfModMatrix::OUTPUT_LP_FILTER_CUTOFF);
+        lpResonance *= eTfModMatrixGet(voice.modMatrix, eTfModMatrix::OUTPUT_LP_FILTER_RESONANCE);
+
+        eTfFilterUpdate(synth, *voice.filterLP, lpCutoff, lpResonance, eFALSE);
+    }
+
+    //  UPDATE HIGHPASS FILTER
+    // -------------------------------------------------------------------------------
+    if (instr.params[TF_HP_FILTER_ON] > 0.5f)
+    {
+        eF32 hpCutoff = instr.params[TF_HP_FILTER_CUTOFF];
+        eF32 hpResonance = instr.params[TF_HP_FILTER_RESONANCE];
+
+        hpCutoff *= eTfModMatrixGet(voice.modMatrix, eTfModMatrix::OUTPUT_HP_FILTER_CUTOFF);
+        hpResonance *= eTfModMatrixGet(voice.modMatrix, eTfModMatrix::OUTPUT_HP_FILTER_RESONANCE);
+
+        eTfFilterUpdate(synth, *voice.filterHP, hpCutoff, hpResonance, eTRUE);
+    }
+}
+
+// filters the signals of one or two voices, running
+// both voices' filters in one SSE register, and mixes
+// them into the outputs
+static void eTfInstrumentFilterVoices(eTfInstrument &instr, eTfVoice **voices, eU32 count, eF32 **outputs, eU32 frameSize)
+{
+    eF32 *signal0[2] = {instr.tempBuffers[0], instr.tempBuffers[1]};
+    eF32 *signal1[2] = {instr.tempBuffers[2], instr.tempBuffers[3]};
+
+    //  RUN LOWPASS FILTER
+    // -------------------------------------------------------------------------------
+    if (instr.params[TF_LP_FILTER_ON] > 0.5f)
+    {
+        if (count == 2)
+            eTfFilterProcess2(*voices[0]->filterLP, *voices[1]->filterLP, eFALSE, signal0, signal1, frameSize);
+        else
+            eTfFilterProcess(*voices[0]->filterLP, eFALSE, signal0, frameSize);
+    }
+
+    //  RUN HIGHPASS FILTER
+    // -------------------------------------------------------------------------------
+    if (instr.params[TF_HP_FILTER_ON] > 0.5f)
+    {
+        if (count == 2)
+            eTfFilterProcess2(*voices[0]->filterHP, *voices[1]->filterHP, eTRUE, signal0, signal1, frameSize);
+        else
+            eTfFilterProcess(*voices[0]->filterHP, eTRUE, signal0, frameSize);
+    }
+
+    // MIX SIGNAL
+    // ------------------------------------------------------------------------------
+    eF32 gain = instr.params[TF_GLOBAL_GAIN];
+    eTfSignalMix(outputs, signal0, frameSize, gain);
+
+    if (count == 2)
+        eTfSignalMix(outputs, signal1, frameSize, gain);
+}
+
 eF32 eTfInstrumentProcess(eTfSynth &synth, eTfInstrument &instr, eF32 **outputs, long frameSize)
 {
     ePROFILER_FUNC();
@@ -1007,9 +1443,10 @@ eF32 eTfInstrumentProcess(eTfSynth &synth, eTfInstrument &instr, eF32 **outputs,
     eSimdSetArithmeticFlags(eSAF_FTZ);
     eASSERT(frameSize <= TF_MAXFRAMESIZE);
 
-    eF32 *tempBuffers[2];
-    tempBuffers[0] = instr.tempBuffers[0];
-    tempBuffers[1] = instr.tempBuffers[1];
+    // voices are rendered in pairs, so that their
+    // filters can run together
+    eTfVoice *voices[2];
+    eU32 voiceCount = 0;
 
     for(eU32 k=0;k<TF_MAXVOICES;k++)
     {
@@ -1018,96 +1455,22 @@ eF32 eTfInstrumentProcess(eTfSynth &synth, eTfInstrument &instr, eF32 **outputs,
         if (voice.noteIsOn || voice.playing)
         {
             instr.effectsInactiveTime = 0.0f;
-            voice.time++;
-
-            //  RUN MOD MATRIX
-            // -------------------------------------------------------------------------------
-            eBool has_mm_active = eTfModMatrixProcess(synth, instr, voice.modMatrix, frameSize);
-            instr.lfo1Phase = voice.modMatrix.lfoState[0].phase;
-            instr.lfo2Phase = voice.modMatrix.lfoState[1].phase;
-
-            //  CALCULATE VELOCITY
-            // -------------------------------------------------------------------------------
-            eF32 velocity = (eF32)voice.currentVelocity / 128.0f;
-            if (!has_mm_active && !voice.noteIsOn)
-                velocity = 0.0f;
-
-            //  RUN NOISE GEN
-            // -------------------------------------------------------------------------------
-            eTfNoiseUpdate(synth, instr, voice.noiseGen, voice.modMatrix, velocity);
-            eBool has_noise = eTfNoiseProcess(synth, instr, voice.noiseGen, tempBuffers, frameSize);
-
-            //  CALCULATE FREQUENCY
-            // -------------------------------------------------------------------------------
-            eF32 baseFreq = synth.freqTable[voice.currentNote & 0x7f];
-            eF32 slop = ePow(instr.params[TF_GEN_SLOP], 3);
-            baseFreq += voice.currentSlop * slop * 8.0f;
-
-            eF32 glide = instr.params[TF_GEN_GLIDE];
-            if (glide > 0.0f && voice.currentFreq > 0.0f)
-            {
-                eF32 freqDiff = baseFreq - voice.currentFreq;
-                freqDiff /= glide * 10.0f + 1.0f;
-                voice.currentFreq += freqDiff;
-            }
-            else
-                voice.currentFreq = baseFreq;
 
-            //  RUN GENERATOR
-            // -------------------------------------------------------------------------------
-            if (voice.time % 4 == 1) // reduce cpu hit a bit. recalculate not more than every 4th frame
-            {
-                eTfGeneratorUpdate(synth, instr, voice, voice.generator);
-
-                if (eTfGeneratorModulate(synth, instr, voice, voice.generator))
-                    eMemCopy(voice.generator.resultTable, voice.generator.freqModTable, TF_IFFT_FRAMESIZE * sizeof(eF32) * 2);
-                else
-                    eMemCopy(voice.generator.resultTable, voice.generator.freqTable, TF_IFFT_FRAMESIZE * sizeof(eF32) * 2);
-                
-                eTfGeneratorFft(synth, IFFT, voice.generator.resultTable);
-                eTfGeneratorNormalize(voice.generator.resultTable);
-            }
-            
-            eBool has_gen = eTfGeneratorProcess(synth, instr, voice, voice.generator, velocity, tempBuffers, frameSize);
-
-            // update voice state
-            voice.playing = has_noise || has_gen;
+            eF32 *signal[2] = {instr.tempBuffers[voiceCount*2], instr.tempBuffers[voiceCount*2+1]};
+            eTfInstrumentRenderVoice(synth, instr, voice, signal, frameSize);
+            voices[voiceCount++] = &voice;
 
-            //  RUN LOWPASS FILTER
-            // -------------------------------------------------------------------------------
-            if (instr.params[TF_LP_FILTER_ON] > 0.5f)
+            if (voiceCount == 2)
             {
-                eF32 lpCutoff = instr.params[TF_LP_FILTER_CUTOFF];
-                eF32 lpResonance = instr.params[TF_LP_FILTER_RESONANCE];
-
-                lpCutoff *= eTfModMatrixGet(voice.modMatrix, eTfModMatrix::OUTPUT_LP_FILTER_CUTOFF);
-                lpResonance *= eTfModMatrixGet(voice.modMatrix, eTfModMatrix::OUTPUT_LP_FILTER_RESONANCE);
-
-                eTfFilterUpdate(synth, *voice.filterLP, lpCutoff, lpResonance, eFALSE);
-                eTfFilterProcess(*voice.filterLP, eFALSE, tempBuffers, frameSize);
+                eTfInstrumentFilterVoices(instr, voices, voiceCount, outputs, frameSize);
+                voiceCount = 0;
             }
-
-            //  RUN HIGHPASS FILTER
-            // -------------------------------------------------------------------------------
-            if (instr.params[TF_HP_FILTER_ON] > 0.5f)
-            {
-                eF32 hpCutoff = instr.params[TF_HP_FILTER_CUTOFF];
-                eF32 hpResonance = instr.params[TF_HP_FILTER_RESONANCE];
-
-                hpCutoff *= eTfModMatrixGet(voice.modMatrix, eTfModMatrix::OUTPUT_HP_FILTER_CUTOFF);
-                hpResonance *= eTfModMatrixGet(voice.modMatrix, eTfModMatrix::OUTPUT_HP_FILTER_RESONANCE);
-
-                eTfFilterUpdate(synth, *voice.filterHP, hpCutoff, hpResonance, eTRUE);
-                eTfFilterProcess(*voice.filterHP, eTRUE, tempBuffers, frameSize);
-            }
-
-            // MIX SIGNAL
-            // ------------------------------------------------------------------------------
-            eF32 gain = instr.params[TF_GLOBAL_GAIN];
-            eTfSignalMix(outputs, tempBuffers, frameSize, gain);
         }
     }
 
+    if (voiceCount > 0)
+        eTfInstrumentFilterVoices(instr, voices, voiceCount, outputs, frameSize);
+
     //    RUN EFFECTS
     // ------------------------------------------------------------------------------
     if (instr.effectsInactiveTime < TF_EFFECT_SWITCHOFF_TIME)
@@ -1119,19 +1482,26 @@ eF32 eTfInstrumentProcess(eTfSynth &synth, eTfInstrument &instr, eF32 **outputs,
             eU32 oldFxIndex = instr.effectIndex[i];
             eU32 fxIndex = eFtoL(eRound(instr.params[TF_EFFECT_1 + i] * (FX_COUNT-1)));
 
+            // instances come from the pool, no memory is
+            // allocated or freed here. if the pool hasn't
+            // been prepared yet the slot stays bypassed.
             if (fxIndex != oldFxIndex && oldFxIndex != 0)
             {
-                s_effectDelete[oldFxIndex](fx);
+                eTfEffectPoolRelease(instr.effectPool, oldFxIndex, fx);
                 instr.effects[i] = fx = nullptr;
                 instr.effectIndex[i] = 0;
             }
         
             if (fxIndex != 0 && fx == nullptr)
             {
-				if (s_effectCreate[fxIndex]) {
-					instr.effects[i] = fx = s_effectCreate[fxIndex]();
-					instr.effectIndex[i] = fxIndex;
-				}
+                fx = eTfEffectPoolAcquire(instr.effectPool, fxIndex);
+
+                if (fx)
+                {
+                    s_effectReset[fxIndex](fx);
+                    instr.effects[i] = fx;
+                    instr.effectIndex[i] = fxIndex;
+                }
             }
 
             if (fx != nullptr)
@@ -1141,11 +1511,11 @@ eF32 eTfInstrumentProcess(eTfSynth &synth, eTfInstrument &instr, eF32 **outputs,
 
     eF32 peak_left = 0.0f;
     eF32 peak_right = 0.0f;
-    eTfSignalToPeak(outputs, &peak_left, &peak_right, TF_FRAMESIZE);
+    eTfSignalToPeak(outputs, &peak_left, &peak_right, frameSize);
     eF32 peak = (peak_left + peak_right) / 2.0f;
 
     if (eIsFloatZero(peak))
-        instr.effectsInactiveTime += (eF32)TF_FRAMESIZE / synth.sampleRate;
+        instr.effectsInactiveTime += (eF32)frameSize / synth.sampleRate;
 
     return peak;
 }
@@ -1287,6 +1657,8 @@ void eTfSynthInit(eTfSynth &synth)
         synth.whiteNoiseTable[i] = (2.f * ((random * c2) + (random * c2) + (random * c2)) - 3.f * (c2 - 1.f)) * c3;
     }
 
+    eTfGeneratorFftInit(synth);
+
     for(eU32 j=0; j<TF_MAX_INSTR; j++)
         synth.instr[j] = nullptr;
 }
@@ -1302,6 +1674,11 @@ void eTfPlayerInit(eTfPlayer &player, eU32 sampleRate)
     player.song.instrCount = 0;
     player.playing = eFALSE;
     player.volume = 0.1f;
+    player.jobPool = nullptr;
+#ifndef ePLAYER
+    eMemSet(player.instrTicks, 0, sizeof(player.instrTicks));
+#endif
+    eMemSet(player.eventPos, 0, sizeof(player.eventPos));
 }
 
 void eTfPlayerLoadSong(eTfPlayer &player, const eU8 *data, eU32 len, eF32 delay)
@@ -1331,7 +1708,7 @@ void eTfPlayerLoadSong(eTfPlayer &player, const eU8 *data, eU32 len, eF32 delay)
         synth.instr[i] = new eTfInstrument;
         eTfInstrumentInit(synth, *synth.instr[i]);
         eventCounts[i] = stream.readU16();
-        song.events[i].resize(eventCounts[i] * sizeof(eTfEvent));
+        song.events[i].resize(eventCounts[i]);
     }
 
     //  read instruments
@@ -1347,6 +1724,8 @@ void eTfPlayerLoadSong(eTfPlayer &player, const eU8 *data, eU32 len, eF32 delay)
             eF32 p = (eF32)stream.readU8()/100.0f;
             synth.instr[j]->params[i] = p;
         }
+
+        eTfInstrumentPrepareEffects(*synth.instr[j]);
     }
 	/*
 	// grouped by paramindex
@@ -1401,53 +1780,119 @@ void eTfPlayerUnloadSong(eTfPlayer &player)
     {
         player.song.events[i].clear();
         player.song.instrCount = 0;
+        player.eventPos[i] = 0;
         eDelete(player.synth.instr[i]);
     }
 }
 
-void eTfPlayerProcess(eTfPlayer &player, const eU8 **output)
+// events of an instrument are sorted by time (rows
+// are delta coded), so the first event not before
+// the given time can be found by binary search
+static eU32 eTfPlayerFindEvent(const eArray<eTfEvent> &events, eF32 time)
 {
-    ePROFILER_FUNC();
+    eU32 lo = 0;
+    eU32 hi = events.size();
 
-    if (!player.playing)
-        return;
+    while (lo < hi)
+    {
+        const eU32 mid = (lo + hi) / 2;
 
-    eF32 timeStep = (eF32)TF_FRAMESIZE / player.synth.sampleRate;
-    eF32 nextTime = player.time + timeStep; 
+        if (events[mid].time < time)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
 
-    eTfSong &song = player.song;
+    return lo;
+}
+
+// triggers the events of the given instrument which
+// are due in the current frame and renders it into
+// its own signal buffer. instruments don't share any
+// state, so this is called in parallel for all of them.
+static void eTfPlayerProcessInstrument(ePtr arg, eU32 index)
+{
+    eTfPlayer &player = *(eTfPlayer *)arg;
     eTfSynth &synth = player.synth;
+    eTfInstrument *instr = synth.instr[index];
 
-    for (eU32 j=0; j<song.instrCount; j++)
+    if (!instr)
+        return;
+
+#ifndef ePLAYER
+    const eU64 startTicks = eTimer::getTickCount();
+#endif
+
+    eF32 *tempSignals[2];
+    tempSignals[0] = &player.instrSignal[index][0];
+    tempSignals[1] = &player.instrSignal[index][TF_FRAMESIZE];
+
+    eMemSet(player.instrSignal[index], 0, sizeof(player.instrSignal[index]));
+
+    // only the events due in this frame are visited.
+    // the instrument is rendered up to the sample
+    // offset of each event before triggering it, so
+    // note onsets aren't quantized to the frame size.
+    const eF32 nextTime = player.time + (eF32)TF_FRAMESIZE / synth.sampleRate;
+    eU32 pos = 0;
+
+    if (index < player.song.instrCount)
     {
-        eArray<eTfEvent> &events = song.events[j];
+        const eArray<eTfEvent> &events = player.song.events[index];
+        eU32 &cursor = player.eventPos[index];
 
-        for(eU32 i=0; i<events.size(); i++) 
+        while (cursor < events.size() && events[cursor].time < nextTime)
         {
-            eTfEvent &ev = events[i];
+            const eTfEvent &ev = events[cursor++];
+            const eF32 offset = (ev.time - player.time) * synth.sampleRate;
+            const eU32 evPos = (offset > 0.0f ? eMin((eU32)eFtoL(offset), (eU32)TF_FRAMESIZE-1) : 0);
 
-            if (ev.time >= player.time && ev.time < nextTime)
+            if (evPos > pos)
             {
-                if (ev.note && ev.instr >= 0)
-                {
-                    eTfInstrument *instr = synth.instr[j];       
-
-                    if (instr)
-                    {
-                        if (!ev.velocity)
-                            eTfInstrumentNoteOff(*instr, ev.note);
-                        else 
-                            eTfInstrumentNoteOn(*instr, ev.note, ev.velocity); 
-                    }
-                }
+                eF32 *outputs[2] = {tempSignals[0]+pos, tempSignals[1]+pos};
+                eTfInstrumentProcess(synth, *instr, outputs, evPos-pos);
+                pos = evPos;
+            }
+
+            if (ev.note)
+            {
+                if (!ev.velocity)
+                    eTfInstrumentNoteOff(*instr, ev.note);
+                else 
+                    eTfInstrumentNoteOn(*instr, ev.note, ev.velocity); 
             }
         }
     }
 
-    eF32 *tempSignals[2];
-    tempSignals[0] = &player.tempSignal[0];
-    tempSignals[1] = &player.tempSignal[TF_FRAMESIZE];
+    eF32 *outputs[2] = {tempSignals[0]+pos, tempSignals[1]+pos};
+    eTfInstrumentProcess(synth, *instr, outputs, TF_FRAMESIZE-pos);
+
+#ifndef ePLAYER
+    player.instrTicks[index] += eTimer::getTickCount()-startTicks;
+#endif
+}
+
+void eTfPlayerProcess(eTfPlayer &player, const eU8 **output)
+{
+    ePROFILER_FUNC();
 
+    if (!player.playing)
+        return;
+
+    eF32 timeStep = (eF32)TF_FRAMESIZE / player.synth.sampleRate;
+    eF32 nextTime = player.time + timeStep; 
+
+    if (player.jobPool)
+        player.jobPool->run(eTfPlayerProcessInstrument, &player, TF_MAX_INSTR);
+    else
+    {
+        for (eU32 i=0; i<TF_MAX_INSTR; i++)
+            eTfPlayerProcessInstrument(&player, i);
+    }
+
+    // mixing always happens serially in instrument
+    // order, so that the parallel output is bit-
+    // identical to the serial one
     eF32 *signals[2];
     signals[0] = &player.outputSignal[0];
     signals[1] = &player.outputSignal[TF_FRAMESIZE];
@@ -1461,8 +1906,10 @@ void eTfPlayerProcess(eTfPlayer &player, const eU8 **output)
 
         if (instr)
         {
-            eMemSet(player.tempSignal, 0, sizeof(eF32)*TF_FRAMESIZE*2);
-            eTfInstrumentProcess(player.synth, *instr, tempSignals, TF_FRAMESIZE);
+            eF32 *tempSignals[2];
+            tempSignals[0] = &player.instrSignal[i][0];
+            tempSignals[1] = &player.instrSignal[i][TF_FRAMESIZE];
+
             //polyPhony += eTfInstrumentGetPolyphony(*instr);
             eTfSignalMix(signals, tempSignals, TF_FRAMESIZE, 1.0f);
         }
@@ -1476,6 +1923,10 @@ void eTfPlayerProcess(eTfPlayer &player, const eU8 **output)
 
 void eTfPlayerStart(eTfPlayer &player, eF32 time)
 {
+    // seek event cursors to the start time
+    for (eU32 i=0; i<TF_MAX_INSTR; i++)
+        player.eventPos[i] = eTfPlayerFindEvent(player.song.events[i], time);
+
     player.time = time;
     player.playing = eTRUE;
 }
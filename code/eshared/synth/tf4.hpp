@@ -583,20 +583,28 @@ struct eTfModMatrix
 
 struct eTfFilter
 {
-    // lowpass memory
-    eF32x2            oldx;
-    eF32x2            oldy1, y1;
-    eF32x2            oldy2, y2;
-    eF32x2            oldy3, y3;
-    eF32x2            y4;
-    // highpass memory
-    eF32x2            in1, in2;
-    eF32x2            out1, out2;
+    // lowpass memory (left and right)
+    eF32            oldx[2];
+    eF32            y1[2], y2[2];
+    eF32            y3[2], y4[2];
+    // highpass memory (left and right)
+    eF32            in1[2], in2[2];
+    eF32            out1[2], out2[2];
     // lowpass coefficients
     eF32            k, p, r;
     // highpass coefficients
     eF32            a0, a1, a2;
     eF32            b0, b1, b2;
+    // coefficients reached at the end of the last
+    // frame, new ones are faded in over a frame
+    eF32            lastK, lastP, lastR;
+    eF32            lastA1, lastA2;
+    eF32            lastB0, lastB1, lastB2;
+    // cutoff, resonance and sample rate of the
+    // coefficients
+    eF32            f, q;
+    eU32            sampleRate;
+    eBool           valid;
 };
 
 struct eTfNoise
@@ -637,7 +645,7 @@ struct eTfVoice
 
     eBool           noteIsOn;
     eBool           playing;
-    eU32            time;
+    eU32            time; // samples since note on
 
     eF32            currentFreq;
     eS32            currentNote;
@@ -661,10 +669,11 @@ struct eTfInstrument
     eF32            lfo1Phase;
     eF32            lfo2Phase;
     eTfVoice        voice[TF_MAXVOICES];
-    eF32            tempBuffers[2][TF_MAXFRAMESIZE];
+    eF32            tempBuffers[4][TF_MAXFRAMESIZE];
     eTfEffect *     effects[TF_MAXEFFECTS];
     eU32            effectIndex[TF_MAXEFFECTS];
     eF32            effectsInactiveTime;
+    eTfEffectPool   effectPool;
 };
 
 struct eTfSynth
@@ -676,6 +685,9 @@ struct eTfSynth
     eF32            freqTable[TF_NUMFREQS];
     eF32            lfoNoiseTable[TF_LFONOISETABLESIZE];
     eF32            whiteNoiseTable[TF_NOISETABLESIZE];
+    eF32            fftCos[TF_IFFT_FRAMESIZE*2];
+    eF32            fftSin[TF_IFFT_FRAMESIZE*2];
+    eU16            fftBitRev[TF_IFFT_FRAMESIZE];
     eTfInstrument * instr[TF_MAX_INSTR];
 };
 
@@ -712,9 +724,14 @@ struct eTfPlayer
     eF32                volume;
     eF32                time;
     eBool               playing;
+    eU32                eventPos[TF_MAX_INSTR];
+    eJobPool *          jobPool; // renders instruments in parallel if set
+#ifndef ePLAYER
+    eU64                instrTicks[TF_MAX_INSTR]; // accumulated render time
+#endif
 
     eF32                outputSignal[sizeof(eF32)*TF_FRAMESIZE*2];
-    eF32                tempSignal[sizeof(eF32)*TF_FRAMESIZE*2];
+    eF32                instrSignal[TF_MAX_INSTR][TF_FRAMESIZE*2];
     eS16                outputFinal[sizeof(eF32)*TF_FRAMESIZE];
 };
 
@@ -752,6 +769,7 @@ eBool   eTfNoiseProcess(eTfSynth &synth, eTfInstrument &instr, eTfNoise &state,
 
 void    eTfFilterUpdate(eTfSynth &synth, eTfFilter &state, eF32 f, eF32 q, eBool isHighPass);
 void    eTfFilterProcess(eTfFilter &state, eBool highpass, eF32 **signal, eU32 frameSize);
+void    eTfFilterProcess2(eTfFilter &state0, eTfFilter &state1, eBool highpass, eF32 **signal0, eF32 **signal1, eU32 frameSize);
 
 void    eTfVoiceReset(eTfVoice &state);
 void    eTfVoiceNoteOn(eTfVoice &state, eS32 note, eS32 velocity, eF32 lfoPhase1, eF32 lfoPhase2);
@@ -759,6 +777,7 @@ void    eTfVoiceNoteOff(eTfVoice &state);
 void    eTfVoicePanic(eTfVoice &state);
 
 void    eTfInstrumentInit(eTfSynth &synth, eTfInstrument &instr);
+void    eTfInstrumentPrepareEffects(eTfInstrument &instr);
 eF32    eTfInstrumentProcess(eTfSynth &synth, eTfInstrument &instr, eF32 **outputs, long sampleFrames);
 //void    eTfInstrumentWrite(eTfInstrument &instr, const char *file);
 void    eTfInstrumentNoteOn(eTfInstrument &instr, eS32 note, eS32 velocity);
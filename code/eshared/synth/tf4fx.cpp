@@ -27,6 +27,14 @@ void eTfDelayInit(eTfDelay &delay, eBool singleDelay)
 {
     eMemSet(&delay, 0, sizeof(eTfDelay));
     delay.singleDelay = singleDelay;
+    delay.clearedLen = TF_DELAY_MAXLEN;
+}
+
+void eTfDelayReset(eTfDelay &delay)
+{
+    delay.readOffset = 0;
+    delay.writeOffset = 0;
+    delay.clearedLen = 0;
 }
 
 void eTfDelayUpdate(eTfDelay &delay, eU32 sampleRate, eF32 ms)
@@ -41,6 +49,21 @@ void eTfDelayUpdate(eTfDelay &delay, eU32 sampleRate, eF32 ms)
         delay.writeOffset = eClamp<eU32>(0, delay.writeOffset, delay.delayLen-1);
         delay.readOffset = eClamp<eU32>(0, delay.readOffset, delay.delayLen-1);
     }
+
+    // the buffer isn't zeroed on reset. only the part
+    // which is read before being written gets cleared:
+    // the tail up to the first wrap for single delays,
+    // the used length for feedback delays.
+    if (delay.singleDelay) {
+        eU32 tailLen = (delay.delayLen > delay.writeOffset ? delay.delayLen-delay.writeOffset : 0);
+        if (tailLen > delay.clearedLen) {
+            eMemSet(&delay.delayBuffer[TF_DELAY_MAXLEN-tailLen], 0, (tailLen-delay.clearedLen)*sizeof(eF32));
+            delay.clearedLen = tailLen;
+        }
+    } else if (delay.delayLen > delay.clearedLen) {
+        eMemSet(&delay.delayBuffer[delay.clearedLen], 0, (delay.delayLen-delay.clearedLen)*sizeof(eF32));
+        delay.clearedLen = delay.delayLen;
+    }
 }
 
 void eTfDelayProcess(eTfDelay &delay, eF32 *signal, eU32 len, eF32 decay)
@@ -69,6 +92,8 @@ void eTfDelayProcess(eTfDelay &delay, eF32 *signal, eU32 len, eF32 decay)
         if ((*write_pos) >= wrapPosition) {
             (*write_pos) = 0;
             buffer_dest = delay.delayBuffer;
+            if (delay.singleDelay)
+                delay.clearedLen = TF_DELAY_MAXLEN;
         }
 
         // increase read position and verify
@@ -94,34 +119,118 @@ void eTfCombInit(eTfComb &comb, eU32 size)
     comb.bufsize = size;    
 }
 
-void eTfCombProcess(eTfComb &comb1, eTfComb &comb2, eF32 damp1, eF32 damp2, eF32 feedback, eF32 gain, eF32 **signals_in, eF32 **signals_out, eU32 len)
+void eTfCombReset(eTfComb &comb)
 {
-    eF32 *inputL = signals_in[LEFT];
-    eF32 *inputR = signals_in[RIGHT];
-    eF32 *outputL = signals_out[LEFT];
-    eF32 *outputR = signals_out[RIGHT];
-    
-    eF32x2 damp2x2 = eSimdSetAll(damp2);
-    eF32x2 damp1x2 = eSimdSetAll(damp1);
-    eF32x2 feedbackx2 = eSimdSetAll(feedback);
-        
-    while(len--)
+    eMemSet(comb.buffer, 0, comb.bufsize*sizeof(eF32));
+    comb.bufidx = 0;
+    comb.filterstore = 0.0f;
+}
+
+void eTfCombBankInit(eTfCombBank &bank, const eInt *sizes)
+{
+    for (eU32 i=0; i<TF_COMB_BANKSIZE; i++)
+        eTfCombInit(bank.combs[i], sizes[i]);
+}
+
+void eTfCombBankReset(eTfCombBank &bank)
+{
+    for (eU32 i=0; i<TF_COMB_BANKSIZE; i++)
+        eTfCombReset(bank.combs[i]);
+}
+
+// runs all combs on the same input and sums up their
+// outputs. samples are processed in blocks ending at
+// the next wrap of any comb buffer, so no wrap checks
+// are needed per sample. output may equal input.
+void eTfCombBankProcess(eTfCombBank &bank, eF32 damp1, eF32 damp2, eF32 feedback, const eF32 *input, eF32 *output, eU32 len)
+{
+    eTfComb *combs = bank.combs;
+    eF32 *outputs = bank.outputs;
+    eALIGN16 eF32 buf[TF_COMB_BANKSIZE];
+
+    const eF32x4 damp1x4 = eSimdSetAll(damp1);
+    const eF32x4 damp2x4 = eSimdSetAll(damp2);
+    const eF32x4 feedbackx4 = eSimdSetAll(feedback);
+
+    eF32x4 filterstore0 = eSimdSet(combs[3].filterstore, combs[2].filterstore, combs[1].filterstore, combs[0].filterstore);
+    eF32x4 filterstore1 = eSimdSet(combs[7].filterstore, combs[6].filterstore, combs[5].filterstore, combs[4].filterstore);
+
+    for (eU32 done=0; done<len; )
     {
-        eF32 input = (*inputL++ + *inputR++) * gain;
-        eF32x2 minput = eSimdSetAll(input);
-        
-        eF32x2 output = eSimdSet2(comb1.buffer[comb1.bufidx], comb2.buffer[comb2.bufidx]);
-        eF32x2 filterstore = eSimdSet2(comb1.filterstore, comb2.filterstore);
-        filterstore = eSimdAdd(eSimdMul(output, damp2x2), eSimdMul(filterstore, damp1x2));
+        eU32 blockLen = len-done;
+        eF32 *p[TF_COMB_BANKSIZE];
+
+        for (eU32 j=0; j<TF_COMB_BANKSIZE; j++)
+        {
+            blockLen = eMin(blockLen, (eU32)(combs[j].bufsize-combs[j].bufidx));
+            p[j] = &combs[j].buffer[combs[j].bufidx];
+        }
 
-        eF32x2 buffer = eSimdAdd(minput, eSimdMul(filterstore, feedbackx2));
+        for (eU32 i=0; i<blockLen; i++, outputs+=TF_COMB_BANKSIZE)
+        {
+            const eF32x4 in = eSimdSetAll(input[done+i]);
+            const eF32x4 out0 = eSimdSet(p[3][i], p[2][i], p[1][i], p[0][i]);
+            const eF32x4 out1 = eSimdSet(p[7][i], p[6][i], p[5][i], p[4][i]);
 
-        eSimdStore2(buffer, comb1.buffer[comb1.bufidx], comb2.buffer[comb2.bufidx]);
-        eSimdStore2(filterstore, comb1.filterstore, comb2.filterstore);
-        eSimdStore2(output, *outputL++, *outputR++);
-        
-        if (++comb1.bufidx >= comb1.bufsize) comb1.bufidx = 0;
-        if (++comb2.bufidx >= comb2.bufsize) comb2.bufidx = 0;
+            filterstore0 = eSimdAdd(eSimdMul(out0, damp2x4), eSimdMul(filterstore0, damp1x4));
+            filterstore1 = eSimdAdd(eSimdMul(out1, damp2x4), eSimdMul(filterstore1, damp1x4));
+
+            eSimdStoreAligned(eSimdAdd(in, eSimdMul(filterstore0, feedbackx4)), &buf[0]);
+            eSimdStoreAligned(eSimdAdd(in, eSimdMul(filterstore1, feedbackx4)), &buf[4]);
+
+            for (eU32 j=0; j<TF_COMB_BANKSIZE; j++)
+                p[j][i] = buf[j];
+
+            eSimdStore(out0, &outputs[0]);
+            eSimdStore(out1, &outputs[4]);
+        }
+
+        for (eU32 j=0; j<TF_COMB_BANKSIZE; j++)
+        {
+            combs[j].bufidx += blockLen;
+            if (combs[j].bufidx >= combs[j].bufsize)
+                combs[j].bufidx = 0;
+        }
+
+        done += blockLen;
+    }
+
+    eSimdStoreAligned(filterstore0, &buf[0]);
+    eSimdStoreAligned(filterstore1, &buf[4]);
+
+    for (eU32 j=0; j<TF_COMB_BANKSIZE; j++)
+        combs[j].filterstore = buf[j];
+
+    // sum up the combs in their order, four samples
+    // at once by transposing the comb outputs
+    outputs = bank.outputs;
+    eU32 i = 0;
+
+    for (; i+4<=len; i+=4, outputs+=4*TF_COMB_BANKSIZE)
+    {
+        eF32x4 a0 = eSimdLoad(&outputs[0]);
+        eF32x4 a1 = eSimdLoad(&outputs[TF_COMB_BANKSIZE]);
+        eF32x4 a2 = eSimdLoad(&outputs[2*TF_COMB_BANKSIZE]);
+        eF32x4 a3 = eSimdLoad(&outputs[3*TF_COMB_BANKSIZE]);
+        eF32x4 b0 = eSimdLoad(&outputs[4]);
+        eF32x4 b1 = eSimdLoad(&outputs[TF_COMB_BANKSIZE+4]);
+        eF32x4 b2 = eSimdLoad(&outputs[2*TF_COMB_BANKSIZE+4]);
+        eF32x4 b3 = eSimdLoad(&outputs[3*TF_COMB_BANKSIZE+4]);
+        eSimdTranspose(a0, a1, a2, a3);
+        eSimdTranspose(b0, b1, b2, b3);
+
+        eF32x4 sum = eSimdAdd(eSimdAdd(eSimdAdd(a0, a1), a2), a3);
+        sum = eSimdAdd(eSimdAdd(eSimdAdd(eSimdAdd(sum, b0), b1), b2), b3);
+        eSimdStore(sum, &output[i]);
+    }
+
+    for (; i<len; i++, outputs+=TF_COMB_BANKSIZE)
+    {
+        eF32 sum = outputs[0];
+        for (eU32 j=1; j<TF_COMB_BANKSIZE; j++)
+            sum += outputs[j];
+
+        output[i] = sum;
     }
 }
 
@@ -136,26 +245,47 @@ void eTfAllpassInit(eTfAllpass &allpass, eU32 size)
     allpass.bufsize = size;   
 }
 
-void eTfAllpassProcess(eTfAllpass &allpass1, eTfAllpass &allpass2, eF32 feedback, eF32 **signals_in, eF32 **signals_out, eU32 len)
+void eTfAllpassReset(eTfAllpass &allpass)
 {
-    eF32 *inputL = signals_in[0];
-    eF32 *inputR = signals_in[1];
-    eF32 *outputL = signals_out[0];
-    eF32 *outputR = signals_out[1];
+    eMemSet(allpass.buffer, 0, allpass.bufsize*sizeof(eF32));
+    allpass.bufidx = 0;
+}
 
-    eF32x2 feedbackx2 = eSimdSetAll(feedback);
-    
-    while(len--)
+// the delay is at least as long as a block ending
+// at the buffer's wrap, so all samples of a block
+// are independent and processed four at a time
+void eTfAllpassProcess(eTfAllpass &allpass, eF32 feedback, eF32 *signal, eU32 len)
+{
+    const eF32x4 feedbackx4 = eSimdSetAll(feedback);
+
+    while (len > 0)
     {
-        eF32x2 output = eSimdSet2(*inputL++, *inputR++);
-        eF32x2 bufout = eSimdSet2(allpass1.buffer[allpass1.bufidx], allpass2.buffer[allpass2.bufidx]);
-        eF32x2 buffer = eSimdAdd(output, eSimdMul(bufout, feedbackx2));
-        output = eSimdSub(bufout, output);
-        eSimdStore2(buffer, allpass1.buffer[allpass1.bufidx], allpass2.buffer[allpass2.bufidx]);
-        eSimdStore2(output, *outputL++, *outputR++);
-        
-        if (++allpass1.bufidx >= allpass1.bufsize) allpass1.bufidx = 0;
-        if (++allpass2.bufidx >= allpass2.bufsize) allpass2.bufidx = 0;
+        eF32 *buffer = &allpass.buffer[allpass.bufidx];
+        const eU32 blockLen = eMin(len, (eU32)(allpass.bufsize-allpass.bufidx));
+        eU32 i = 0;
+
+        for (; i+4<=blockLen; i+=4)
+        {
+            const eF32x4 in = eSimdLoad(&signal[i]);
+            const eF32x4 bufout = eSimdLoad(&buffer[i]);
+            eSimdStore(eSimdAdd(in, eSimdMul(bufout, feedbackx4)), &buffer[i]);
+            eSimdStore(eSimdSub(bufout, in), &signal[i]);
+        }
+
+        for (; i<blockLen; i++)
+        {
+            const eF32 in = signal[i];
+            const eF32 bufout = buffer[i];
+            buffer[i] = in + bufout*feedback;
+            signal[i] = bufout - in;
+        }
+
+        allpass.bufidx += blockLen;
+        if (allpass.bufidx >= allpass.bufsize)
+            allpass.bufidx = 0;
+
+        signal += blockLen;
+        len -= blockLen;
     }
 }
 
@@ -176,6 +306,13 @@ void eTfEffectDelayDelete(eTfEffect *fx)
     eFreeAligned(fx);
 }
 
+void eTfEffectDelayReset(eTfEffect *fx)
+{
+    eTfEffectDelay *delay = (eTfEffectDelay *)fx;
+    eTfDelayReset(delay->delay[LEFT]);
+    eTfDelayReset(delay->delay[RIGHT]);
+}
+
 void eTfEffectDelayProcess(eTfEffect *fx, eTfSynth &synth, eTfInstrument &instr, eF32 **signal, eU32 len)
 {
     eASSERT_ALIGNED16(fx);
@@ -218,12 +355,7 @@ const eInt ALLPASSTUNINGS[] = { 556, 441, 341, 225 };
 eTfEffect * eTfEffectReverbCreate()
 {
     eTfEffectReverb *reverb = (eTfEffectReverb *)eAllocAlignedAndZero(sizeof(eTfEffectReverb), 16);
-    
-    for (int i=0; i<TF_FX_REVERB_NUMCOMBS; i++)
-    {
-        eTfCombInit(reverb->comb[LEFT][i], COMBTUNINGS[i]);
-        eTfCombInit(reverb->comb[RIGHT][i], COMBTUNINGS[i]);
-    }
+    eTfCombBankInit(reverb->combs, COMBTUNINGS);
 
     for (int i=0; i<TF_FX_REVERB_NUMALLPASSES; i++)
     {
@@ -239,6 +371,18 @@ void eTfEffectReverbDelete(eTfEffect *fx)
     eFreeAligned(fx);
 }
 
+void eTfEffectReverbReset(eTfEffect *fx)
+{
+    eTfEffectReverb *reverb = (eTfEffectReverb *)fx;
+    eTfCombBankReset(reverb->combs);
+
+    for (eU32 i=0; i<TF_FX_REVERB_NUMALLPASSES; i++)
+    {
+        eTfAllpassReset(reverb->allpass[LEFT][i]);
+        eTfAllpassReset(reverb->allpass[RIGHT][i]);
+    }
+}
+
 void eTfEffectReverbProcess(eTfEffect *fx, eTfSynth &synth, eTfInstrument &instr, eF32 **signal, eU32 len)
 {
     eASSERT_ALIGNED16(fx);
@@ -263,54 +407,48 @@ void eTfEffectReverbProcess(eTfEffect *fx, eTfSynth &synth, eTfInstrument &instr
 	if (len > TF_MAXFRAMESIZE)
 		return;
 
-    // erase mixbuffer
-    eF32 *signals_mix[2];
-    signals_mix[LEFT] = &reverb->mixBuffers[0];
-    signals_mix[RIGHT] = &reverb->mixBuffers[TF_MAXFRAMESIZE];
-    eMemSet(signals_mix[LEFT], 0, sizeof(eF32) * len);
-    eMemSet(signals_mix[RIGHT], 0, sizeof(eF32) * len);
+    eF32 *dryL = signal[LEFT];
+    eF32 *dryR = signal[RIGHT];
+    eF32 *wetL = &reverb->mixBuffers[0];
+    eF32 *wetR = &reverb->mixBuffers[TF_MAXFRAMESIZE];
+    eU32 i;
 
-    // run comb filters in parallel
-    for (eU32 i=0;i<TF_FX_REVERB_NUMCOMBS; i++)
-    {
-        eF32 *signals_out[2];
-        signals_out[LEFT] = &reverb->combBuffers[TF_MAXFRAMESIZE * 2 * i];
-        signals_out[RIGHT] = &reverb->combBuffers[TF_MAXFRAMESIZE * 2 * i + 1];
-        eTfCombProcess(reverb->comb[LEFT][i], reverb->comb[RIGHT][i], damp1, damp2, cmbFeedback, gain, signal, signals_out, len);
-        eTfSignalMix(signals_mix, signals_out, len, 0.5f);
-    }
+    // run comb filters in parallel on the summed up
+    // channels, the result is the same for both
+    const eF32x4 gainx4 = eSimdSetAll(gain);
+
+    for (i=0; i+4<=len; i+=4)
+        eSimdStore(eSimdMul(eSimdAdd(eSimdLoad(&dryL[i]), eSimdLoad(&dryR[i])), gainx4), &wetL[i]);
+    for (; i<len; i++)
+        wetL[i] = (dryL[i] + dryR[i]) * gain;
+
+    eTfCombBankProcess(reverb->combs, damp1, damp2, cmbFeedback, wetL, wetL, len);
+    eMemCopy(wetR, wetL, sizeof(eF32) * len);
     
     // run allpass filters in serial
-    for (eU32 i=0;i<TF_FX_REVERB_NUMALLPASSES; i++)
+    for (eU32 j=0;j<TF_FX_REVERB_NUMALLPASSES; j++)
     {
-        eTfAllpassProcess(reverb->allpass[LEFT][i], reverb->allpass[RIGHT][i], apsFeedback, signals_mix, signals_mix, len);
+        eTfAllpassProcess(reverb->allpass[LEFT][j], apsFeedback, wetL, len);
+        eTfAllpassProcess(reverb->allpass[RIGHT][j], apsFeedback, wetR, len);
     }
 
     // create final signal
-    eF32x2 wet1x2 = eSimdSetAll(wet1);
-    eF32x2 wet2x2 = eSimdSetAll(wet2);
-    eF32x2 dry0x2 = eSimdSetAll(dry0);
-
-	//eSwap<eF32*>(signal[LEFT], signal[RIGHT]);
-
-    eF32 *dryL = signal[LEFT];
-    eF32 *dryR = signal[RIGHT];
-    eF32 *wetL = signals_mix[LEFT];
-    eF32 *wetR = signals_mix[RIGHT];
+    const eF32x4 wet1x4 = eSimdSetAll(wet1);
+    const eF32x4 wet2x4 = eSimdSetAll(wet2);
+    const eF32x4 dry0x4 = eSimdSetAll(dry0);
 
-    while(len--)
+    for (i=0; i+4<=len; i+=4)
     {
-        eF32x2 in = eSimdSet2(*dryL, *dryR);
-        eF32x2 wet = eSimdSet2(*wetL++, *wetR++);
-        eF32x2 out = eSimdSetAll(0.0f);
-
-        out = eSimdAdd(
-                eSimdAdd(
-                    eSimdMul(wet, wet1x2),
-                    eSimdMul(wet, wet2x2)),
-                eSimdMul(in, dry0x2));
+        const eF32x4 l = eSimdLoad(&wetL[i]);
+        const eF32x4 r = eSimdLoad(&wetR[i]);
+        eSimdStore(eSimdAdd(eSimdAdd(eSimdMul(l, wet1x4), eSimdMul(l, wet2x4)), eSimdMul(eSimdLoad(&dryL[i]), dry0x4)), &dryL[i]);
+        eSimdStore(eSimdAdd(eSimdAdd(eSimdMul(r, wet1x4), eSimdMul(r, wet2x4)), eSimdMul(eSimdLoad(&dryR[i]), dry0x4)), &dryR[i]);
+    }
 
-        eSimdStore2(out, *dryL++, *dryR++);
+    for (; i<len; i++)
+    {
+        dryL[i] = (wetL[i]*wet1 + wetL[i]*wet2) + dryL[i]*dry0;
+        dryR[i] = (wetR[i]*wet1 + wetR[i]*wet2) + dryR[i]*dry0;
     }
 }
 
@@ -330,6 +468,11 @@ void eTfEffectDistortionDelete(eTfEffect *fx)
     eFreeAligned(fx);
 }
 
+void eTfEffectDistortionReset(eTfEffect *fx)
+{
+    // stateless, the table still fits its amount
+}
+
 void eTfEffectDistortionProcess(eTfEffect *fx, eTfSynth &synth, eTfInstrument &instr, eF32 **signal, eU32 len)
 {
     eASSERT_ALIGNED16(fx);
@@ -374,6 +517,11 @@ void eTfEffectFormantDelete(eTfEffect *fx)
     eFreeAligned(fx);
 }
 
+void eTfEffectFormantReset(eTfEffect *fx)
+{
+    eMemSet(fx, 0, sizeof(eTfEffectFormant));
+}
+
 void eTfEffectFormantProcess(eTfEffect *fx, eTfSynth &synth, eTfInstrument &instr, eF32 **signal, eU32 len)
 {
     eASSERT_ALIGNED16(fx);
@@ -447,6 +595,11 @@ void eTfEffectEqDelete(eTfEffect *fx)
     eFreeAligned(fx);
 }
 
+void eTfEffectEqReset(eTfEffect *fx)
+{
+    eMemSet(fx, 0, sizeof(eTfEffectEq));
+}
+
 void eTfEffectEqProcess(eTfEffect *fx, eTfSynth &synth, eTfInstrument &instr, eF32 **signal, eU32 len)
 {
     eASSERT_ALIGNED16(fx);
@@ -533,10 +686,14 @@ eTfEffect * eTfEffectChorusCreate()
 {
     eTfEffectChorus *chorus = (eTfEffectChorus *)eAllocAlignedAndZero(sizeof(eTfEffectChorus), 16);
 
+    // local seed, effects are created while
+    // instruments are rendered in parallel
+    eU32 seed = eRandomSeed();
+
     for(eU32 i=0; i<2*TF_FX_CHORUS_DELAYCOUNT; i++)
     {
         eTfDelayInit(chorus->delay[i], eTRUE);
-        chorus->lfoPhase[i] = eRandomF(0.0f, 1.0f);
+        chorus->lfoPhase[i] = eRandomF(0.0f, 1.0f, seed);
     }
 
     return chorus;
@@ -547,6 +704,18 @@ void eTfEffectChorusDelete(eTfEffect *fx)
     eFreeAligned(fx);
 }
 
+void eTfEffectChorusReset(eTfEffect *fx)
+{
+    eTfEffectChorus *chorus = (eTfEffectChorus *)fx;
+    eU32 seed = eRandomSeed();
+
+    for(eU32 i=0; i<2*TF_FX_CHORUS_DELAYCOUNT; i++)
+    {
+        eTfDelayReset(chorus->delay[i]);
+        chorus->lfoPhase[i] = eRandomF(0.0f, 1.0f, seed);
+    }
+}
+
 void eTfEffectChorusProcess(eTfEffect *fx, eTfSynth &synth, eTfInstrument &instr, eF32 **signal, eU32 len)
 {
     eTfEffectChorus *chorus = (eTfEffectChorus *)fx;
@@ -584,6 +753,11 @@ void eTfEffectFlangerDelete(eTfEffect *fx)
     eFreeAligned(fx);
 }
 
+void eTfEffectFlangerReset(eTfEffect *fx)
+{
+    eMemSet(fx, 0, sizeof(eTfEffectFlanger));
+}
+
 void eTfEffectFlangerProcess(eTfEffect *fx, eTfSynth &synth, eTfInstrument &instr, eF32 **signal, eU32 len)
 {
     eTfEffectFlanger *flanger = (eTfEffectFlanger *)fx;
@@ -681,3 +855,106 @@ void eTfEffectFlangerProcess(eTfEffect *fx, eTfSynth &synth, eTfInstrument &inst
             flanger->buffpos = 0;
     }
 }
+
+// ---------------------------------------------------------------------------------------------------------------------------
+//  EFFECT POOL
+// ---------------------------------------------------------------------------------------------------------------------------
+
+eTfEffectPool::eTfEffectPool()
+{
+    eMemSet((ePtr)cells, 0, sizeof(cells));
+    eMemSet(instances, 0, sizeof(instances));
+    eMemSet(counts, 0, sizeof(counts));
+    lock = 0;
+}
+
+eTfEffectPool::~eTfEffectPool()
+{
+    eTfEffectPoolFree(*this);
+}
+
+// allocates instances for the given effect slots
+// and frees unused ones. must not be called from
+// the audio thread.
+void eTfEffectPoolPrepare(eTfEffectPool &pool, const eU32 *fxIndices)
+{
+    while (eAtomicCas(pool.lock, 1, 0) != 0)
+        eThread::sleep(0);
+
+    eU32 needed[FX_COUNT];
+    eMemSet(needed, 0, sizeof(needed));
+
+    for (eU32 i=0; i<TF_MAXEFFECTS; i++)
+        if (fxIndices[i] < FX_COUNT)
+            needed[fxIndices[i]]++;
+
+    for (eU32 i=1; i<FX_COUNT; i++)
+    {
+        if (!s_effectCreate[i])
+            continue;
+
+        while (pool.counts[i] < needed[i])
+        {
+            eTfEffect *fx = s_effectCreate[i]();
+            pool.instances[i][pool.counts[i]++] = fx;
+            eTfEffectPoolRelease(pool, i, fx);
+        }
+
+        // instances in use by the audio thread
+        // are freed by a later call
+        while (pool.counts[i] > needed[i])
+        {
+            eTfEffect *fx = eTfEffectPoolAcquire(pool, i);
+            if (!fx)
+                break;
+
+            for (eU32 j=0; j<pool.counts[i]; j++)
+            {
+                if (pool.instances[i][j] == fx)
+                {
+                    pool.instances[i][j] = pool.instances[i][--pool.counts[i]];
+                    break;
+                }
+            }
+
+            s_effectDelete[i](fx);
+        }
+    }
+
+    eAtomicCas(pool.lock, 0, 1);
+}
+
+void eTfEffectPoolFree(eTfEffectPool &pool)
+{
+    for (eU32 i=1; i<FX_COUNT; i++)
+    {
+        for (eU32 j=0; j<pool.counts[i]; j++)
+            s_effectDelete[i](pool.instances[i][j]);
+
+        for (eU32 j=0; j<TF_MAXEFFECTS; j++)
+            pool.cells[i][j] = nullptr;
+
+        pool.counts[i] = 0;
+    }
+}
+
+eTfEffect * eTfEffectPoolAcquire(eTfEffectPool &pool, eU32 fxIndex)
+{
+    for (eU32 i=0; i<TF_MAXEFFECTS; i++)
+    {
+        ePtr fx = pool.cells[fxIndex][i];
+        if (fx && eAtomicCasPtr(pool.cells[fxIndex][i], nullptr, fx) == fx)
+            return (eTfEffect *)fx;
+    }
+
+    return nullptr;
+}
+
+void eTfEffectPoolRelease(eTfEffectPool &pool, eU32 fxIndex, eTfEffect *fx)
+{
+    for (eU32 i=0; i<TF_MAXEFFECTS; i++)
+        if (!pool.cells[fxIndex][i] && eAtomicCasPtr(pool.cells[fxIndex][i], fx, nullptr) == nullptr)
+            return;
+
+    eASSERT(eFALSE);
+}
@@ -34,6 +34,7 @@ struct eTfDelay
     eU32     delayLen;
     eU32     readOffset;
     eU32     writeOffset;
+    eU32     clearedLen;    // part of the buffer zeroed since reset
 };
 
 struct eTfComb
@@ -51,15 +52,31 @@ struct eTfAllpass
     eInt    bufidx;
 };
 
+// combs sharing input and output, four of them
+// are processed per SSE register
+const eU32 TF_COMB_BANKSIZE = 8;
+
+struct eTfCombBank
+{
+    eTfComb combs[TF_COMB_BANKSIZE];
+    eF32    outputs[TF_COMB_BANKSIZE*TF_MAXFRAMESIZE];
+};
+
 void eTfDelayInit(eTfDelay &delay, eBool singleDelay);
+void eTfDelayReset(eTfDelay &delay);
 void eTfDelayUpdate(eTfDelay &delay, eU32 sampleRate, eF32 ms);
 void eTfDelayProcess(eTfDelay &delay, eF32 *signal, eU32 len, eF32 decay);
 
 void eTfCombInit(eTfComb &comb, eU32 size);
-void eTfCombProcess(eTfComb &comb1, eTfComb &comb2, eF32 damp1, eF32 damp2, eF32 feedback, eF32 gain, eF32 **signals_in, eF32 **signals_out, eU32 len);
+void eTfCombReset(eTfComb &comb);
+
+void eTfCombBankInit(eTfCombBank &bank, const eInt *sizes);
+void eTfCombBankReset(eTfCombBank &bank);
+void eTfCombBankProcess(eTfCombBank &bank, eF32 damp1, eF32 damp2, eF32 feedback, const eF32 *input, eF32 *output, eU32 len);
 
 void eTfAllpassInit(eTfAllpass &allpass, eU32 size);
-void eTfAllpassProcess(eTfAllpass &allpass1, eTfAllpass &allpass2, eF32 feedback, eF32 **signals_in, eF32 **signals_out, eU32 len);
+void eTfAllpassReset(eTfAllpass &allpass);
+void eTfAllpassProcess(eTfAllpass &allpass, eF32 feedback, eF32 *signal, eU32 len);
 
 // ---------------------------------------------------------------------------------------------------------------------------
 //  EFFECT INTERFACE
@@ -85,6 +102,7 @@ enum eTfFxMode
 typedef void        eTfEffect; 
 typedef eTfEffect * (*eTfEffectCreateProc)();
 typedef void        (*eTfEffectDeleteProc)(eTfEffect *fx);
+typedef void        (*eTfEffectResetProc)(eTfEffect *fx);
 typedef void        (*eTfEffectProcessProc)(eTfEffect *fx, eTfSynth &synth, eTfInstrument &instr, eF32 **signal, eU32 len);
 
 // ---------------------------------------------------------------------------------------------------------------------------
@@ -100,25 +118,28 @@ struct eTfEffectDelay
 
 eTfEffect *     eTfEffectDelayCreate();
 void            eTfEffectDelayDelete(eTfEffect *fx);
+void            eTfEffectDelayReset(eTfEffect *fx);
 void            eTfEffectDelayProcess(eTfEffect *fx, eTfSynth &synth, eTfInstrument &instr, eF32 **signal, eU32 len);
 
 // ---------------------------------------------------------------------------------------------------------------------------
 //  EFFECT REVERB
 // ---------------------------------------------------------------------------------------------------------------------------
 
-const eU32      TF_FX_REVERB_NUMCOMBS     = 8;
+const eU32      TF_FX_REVERB_NUMCOMBS     = TF_COMB_BANKSIZE;
 const eU32      TF_FX_REVERB_NUMALLPASSES = 4;
 
+// left and right channel share the combs, as
+// they have the same tunings and the same input
 struct eTfEffectReverb
 {
-    eTfComb     comb[2][TF_FX_REVERB_NUMCOMBS];
+    eTfCombBank combs;
     eTfAllpass  allpass[2][TF_FX_REVERB_NUMALLPASSES];
-    eF32        combBuffers[TF_FX_REVERB_NUMCOMBS*2*TF_MAXFRAMESIZE];
     eF32        mixBuffers[TF_MAXFRAMESIZE*2];
 };
 
 eTfEffect *     eTfEffectReverbCreate();
 void            eTfEffectReverbDelete(eTfEffect *fx);
+void            eTfEffectReverbReset(eTfEffect *fx);
 void            eTfEffectReverbProcess(eTfEffect *fx, eTfSynth &synth, eTfInstrument &instr, eF32 **signal, eU32 len);
 
 // ---------------------------------------------------------------------------------------------------------------------------
@@ -135,6 +156,7 @@ struct eTfEffectDistortion
 
 eTfEffect *     eTfEffectDistortionCreate();
 void            eTfEffectDistortionDelete(eTfEffect *fx);
+void            eTfEffectDistortionReset(eTfEffect *fx);
 void            eTfEffectDistortionProcess(eTfEffect *fx, eTfSynth &synth, eTfInstrument &instr, eF32 **signal, eU32 len);
 
 // ---------------------------------------------------------------------------------------------------------------------------
@@ -151,6 +173,7 @@ struct eTfEffectFormant
 
 eTfEffect *     eTfEffectFormantCreate();
 void            eTfEffectFormantDelete(eTfEffect *fx);
+void            eTfEffectFormantReset(eTfEffect *fx);
 void            eTfEffectFormantProcess(eTfEffect *fx, eTfSynth &synth, eTfInstrument &instr, eF32 **signal, eU32 len);
 
 // ---------------------------------------------------------------------------------------------------------------------------
@@ -179,6 +202,7 @@ struct eTfEffectEq
 
 eTfEffect *     eTfEffectEqCreate();
 void            eTfEffectEqDelete(eTfEffect *fx);
+void            eTfEffectEqReset(eTfEffect *fx);
 void            eTfEffectEqProcess(eTfEffect *fx, eTfSynth &synth, eTfInstrument &instr, eF32 **signal, eU32 len);
 
 // ---------------------------------------------------------------------------------------------------------------------------
@@ -197,6 +221,7 @@ struct eTfEffectChorus
 
 eTfEffect *     eTfEffectChorusCreate();
 void            eTfEffectChorusDelete(eTfEffect *fx);
+void            eTfEffectChorusReset(eTfEffect *fx);
 void            eTfEffectChorusProcess(eTfEffect *fx, eTfSynth &synth, eTfInstrument &instr, eF32 **signal, eU32 len);
 
 // ---------------------------------------------------------------------------------------------------------------------------
@@ -224,6 +249,7 @@ struct eTfEffectFlanger
 
 eTfEffect *     eTfEffectFlangerCreate();
 void            eTfEffectFlangerDelete(eTfEffect *fx);
+void            eTfEffectFlangerReset(eTfEffect *fx);
 void            eTfEffectFlangerProcess(eTfEffect *fx, eTfSynth &synth, eTfInstrument &instr, eF32 **signal, eU32 len);
 
 // ---------------------------------------------------------------------------------------------------------------------------
@@ -310,6 +336,46 @@ static eTfEffectDeleteProc s_effectDelete[] =
 #endif
 };
 
+static eTfEffectResetProc s_effectReset[] =
+{
+    nullptr,
+#ifndef eCFG_NO_TF_FX_DISTORTION
+    eTfEffectDistortionReset,
+#else
+    nullptr,
+#endif
+#ifndef eCFG_NO_TF_FX_DELAY
+    eTfEffectDelayReset,
+#else
+    nullptr,
+#endif
+#ifndef eCFG_NO_TF_FX_CHORUS
+    eTfEffectChorusReset,
+#else
+    nullptr,
+#endif
+#ifndef eCFG_NO_TF_FX_FLANGER
+    eTfEffectFlangerReset,
+#else
+    nullptr,
+#endif
+#ifndef eCFG_NO_TF_FX_REVERB
+    eTfEffectReverbReset,
+#else
+    nullptr,
+#endif
+#ifndef eCFG_NO_TF_FX_FORMANT
+    eTfEffectFormantReset,
+#else
+    nullptr,
+#endif
+#ifndef eCFG_NO_TF_FX_EQ
+    eTfEffectEqReset
+#else
+    nullptr
+#endif
+};
+
 static eTfEffectProcessProc s_effectProcess[] =
 {
     nullptr,
@@ -350,4 +416,31 @@ static eTfEffectProcessProc s_effectProcess[] =
 #endif
 };
 
+// ---------------------------------------------------------------------------------------------------------------------------
+//  EFFECT POOL
+// ---------------------------------------------------------------------------------------------------------------------------
+
+// effect instances are allocated outside of the
+// audio thread by eTfEffectPoolPrepare() and are
+// handed over through the cells. the audio thread
+// only takes instances out of the cells and puts
+// them back, it never allocates or frees memory.
+// there are never more than TF_MAXEFFECTS instances
+// of an effect, so returned ones always find a cell.
+struct eTfEffectPool
+{
+    eTfEffectPool();
+    ~eTfEffectPool();
+
+    ePtr volatile   cells[FX_COUNT][TF_MAXEFFECTS];     // instances ready for use
+    eTfEffect *     instances[FX_COUNT][TF_MAXEFFECTS]; // all allocated instances
+    eU32            counts[FX_COUNT];
+    volatile eInt   lock;
+};
+
+void            eTfEffectPoolPrepare(eTfEffectPool &pool, const eU32 *fxIndices);
+void            eTfEffectPoolFree(eTfEffectPool &pool);
+eTfEffect *     eTfEffectPoolAcquire(eTfEffectPool &pool, eU32 fxIndex);
+void            eTfEffectPoolRelease(eTfEffectPool &pool, eU32 fxIndex, eTfEffect *fx);
+
 #endif // TF4FX_HPP
\ No newline at end of file
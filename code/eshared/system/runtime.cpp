@@ -46,8 +46,10 @@ void eCDECL operator delete [] (ePtr ptr)
 #undef new
 #undef delete
 
-static eU64 g_allocedMem = 0;
-static eU64 g_allocCount = 0;
+// updated atomically, as operators allocate
+// from the job pool's worker threads
+static volatile LONGLONG g_allocedMem = 0;
+static volatile LONGLONG g_allocCount = 0;
 
 ePtr operator new(eU32 size, const eChar *file, eU32 line)
 {
@@ -58,8 +60,8 @@ ePtr operator new(eU32 size, const eChar *file, eU32 line)
 #endif
 
 #ifdef eEDITOR
-    g_allocedMem += _msize(ptr);
-    g_allocCount++;
+    InterlockedExchangeAdd64(&g_allocedMem, _msize(ptr));
+    InterlockedIncrement64(&g_allocCount);
 #endif
 
     return ptr;
@@ -81,8 +83,8 @@ void eCDECL operator delete(ePtr ptr)
         return;
 
 #ifdef eEDITOR
-    g_allocedMem -= _msize(ptr);
-    g_allocCount--;
+    InterlockedExchangeAdd64(&g_allocedMem, -(LONGLONG)_msize(ptr));
+    InterlockedDecrement64(&g_allocCount);
 #endif
 
 #ifdef eDEBUG
@@ -160,7 +162,8 @@ void eWriteToLog(const eChar *msg)
 #ifndef ePLAYER
 eU64 eGetAllocatedMemory()
 {
-    return g_allocedMem;
+    // a plain 64 bit read can tear on x86
+    return (eU64)InterlockedCompareExchange64(&g_allocedMem, 0, 0);
 }
 
 eU64  eGetTotalVirtualMemory()
@@ -545,8 +548,10 @@ eBool eIsDigit(eChar c)
     return (c >= '0' && c <= '9');
 }
 
-// seed value of the random number generator
-static eU32 g_seed = 1;
+// seed value of the random number generator. it's
+// thread local, so that operators seeding and using
+// the global generator can run in parallel
+static eTHREADLOCAL eU32 g_seed = 1;
 static eU32 g_threadId = 0;
 
 void eRandomize(eU32 seed)
@@ -1168,4 +1173,3 @@ eBool eClosedIntervalsOverlap(eInt start0, eInt end0, eInt start1, eInt end1)
 {
     return (start1 <= end0 && start0 <= end1);
 }
-
@@ -49,6 +49,10 @@ void eThread::sleep(eU32 ms)
 
 void eThread::join()
 {
+    // already joined by a derived destructor
+    if (!m_handle)
+        return;
+
     WaitForSingleObject((HANDLE)m_handle, INFINITE);
     CloseHandle((HANDLE)m_handle);
     m_handle = nullptr;
@@ -88,8 +92,9 @@ void eThread::setPriority(eThreadPriority prio)
         {HIGH_PRIORITY_CLASS,         THREAD_PRIORITY_TIME_CRITICAL}, // high
     };
 
-    SetPriorityClass(m_handle, cp[prio].cls);
-    SetThreadPriority(m_handle, cp[prio].prio);
+    const eU32 index = (prio == eTHP_LOW ? 0 : (prio == eTHP_NORMAL ? 1 : 2));
+    SetPriorityClass(m_handle, cp[index].cls);
+    SetThreadPriority(m_handle, cp[index].prio);
     m_prio = prio;
 }
 
@@ -177,4 +182,182 @@ void eMutex::leave()
 eBool eMutex::isLocked() const
 {
     return m_locked;
+}
+
+eInt eAtomicInc(volatile eInt &x)
+{
+    return InterlockedIncrement((volatile LONG *)&x);
+}
+
+eInt eAtomicDec(volatile eInt &x)
+{
+    return InterlockedDecrement((volatile LONG *)&x);
+}
+
+eInt eAtomicAdd(volatile eInt &x, eInt val)
+{
+    return InterlockedExchangeAdd((volatile LONG *)&x, val)+val;
+}
+
+eInt eAtomicCas(volatile eInt &x, eInt exchange, eInt comparand)
+{
+    return InterlockedCompareExchange((volatile LONG *)&x, exchange, comparand);
+}
+
+ePtr eAtomicCasPtr(ePtr volatile &x, ePtr exchange, ePtr comparand)
+{
+    return InterlockedCompareExchangePointer(&x, exchange, comparand);
+}
+
+eU32 eGetCpuCount()
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors;
+}
+
+// set while a thread executes jobs, used to
+// run nested parallel loops serially
+static eTHREADLOCAL eBool g_inJob = eFALSE;
+
+class eJobWorker : public eThread
+{
+public:
+    eJobWorker(eJobPool &pool) : eThread(eTHP_NORMAL|eTHCF_SUSPENDED),
+        m_pool(pool)
+    {
+    }
+
+    virtual eU32 operator () ()
+    {
+        ePROFILER_ADD_THIS_THREAD("Job worker");
+        g_inJob = eTRUE;
+        m_pool._workerLoop();
+        return 0;
+    }
+
+private:
+    eJobPool & m_pool;
+};
+
+eJobPool::eJobPool(eU32 numWorkers) :
+    m_func(nullptr),
+    m_arg(nullptr),
+    m_count(0),
+    m_next(0),
+    m_busy(0),
+    m_quit(eFALSE)
+{
+    if (numWorkers == eU32_MAX)
+        numWorkers = eGetCpuCount()-1;
+
+    m_wakeSem = CreateSemaphore(NULL, 0, eMax(numWorkers, 1U), NULL);
+    m_doneEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+    eASSERT(m_wakeSem && m_doneEvent);
+
+    // threads are created suspended, because the
+    // worker's vtable isn't set up until eThread's
+    // constructor returned
+    for (eU32 i=0; i<numWorkers; i++)
+    {
+        eThread *worker = new eJobWorker(*this);
+        m_workers.append(worker);
+        worker->resume();
+    }
+}
+
+eJobPool::~eJobPool()
+{
+    m_quit = eTRUE;
+    ReleaseSemaphore(m_wakeSem, m_workers.size(), NULL);
+
+    for (eU32 i=0; i<m_workers.size(); i++)
+        eDelete(m_workers[i]); // joins thread
+
+    CloseHandle(m_wakeSem);
+    CloseHandle(m_doneEvent);
+}
+
+void eJobPool::run(eJobFunc func, ePtr arg, eU32 count)
+{
+    eASSERT(func);
+
+    if (g_inJob || m_workers.isEmpty() || count <= 1)
+    {
+        for (eU32 i=0; i<count; i++)
+            func(arg, i);
+
+        return;
+    }
+
+    eScopedLock lock(m_runMutex);
+
+    // only wake as many workers as there are
+    // indices left for them. run() doesn't return
+    // before all woken workers left _work(), so no
+    // worker can pick up indices of a later loop.
+    const eU32 numWake = eMin(m_workers.size(), count-1);
+    m_func = func;
+    m_arg = arg;
+    m_count = count;
+    m_next = 0;
+    m_busy = numWake+1;
+    ReleaseSemaphore(m_wakeSem, numWake, NULL);
+
+    g_inJob = eTRUE;
+    _work();
+    g_inJob = eFALSE;
+
+    if (eAtomicDec(m_busy) != 0)
+        WaitForSingleObject(m_doneEvent, INFINITE);
+}
+
+eU32 eJobPool::getThreadCount() const
+{
+    return m_workers.size()+1;
+}
+
+// the default pool is created on first use. it's
+// never destroyed by a static destructor, as joining
+// threads there deadlocks inside a dll (loader lock).
+// call shutdownDefault() before exiting instead.
+static eJobPool * volatile g_defaultPool = nullptr;
+
+eJobPool & eJobPool::getDefault()
+{
+    if (!g_defaultPool)
+    {
+        eJobPool *pool = new eJobPool;
+
+        if (eAtomicCasPtr((ePtr volatile &)g_defaultPool, pool, nullptr) != nullptr)
+            eDelete(pool);
+    }
+
+    return *g_defaultPool;
+}
+
+void eJobPool::shutdownDefault()
+{
+    eDelete(g_defaultPool);
+}
+
+void eJobPool::_workerLoop()
+{
+    while (eTRUE)
+    {
+        WaitForSingleObject(m_wakeSem, INFINITE);
+        if (m_quit)
+            break;
+
+        _work();
+
+        if (eAtomicDec(m_busy) == 0)
+            SetEvent(m_doneEvent);
+    }
+}
+
+void eJobPool::_work()
+{
+    for (eInt i=eAtomicInc(m_next)-1; i<(eInt)m_count; i=eAtomicInc(m_next)-1)
+        m_func(m_arg, i);
 }
\ No newline at end of file
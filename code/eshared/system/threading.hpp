@@ -119,4 +119,55 @@ private:
     eMutex & m_mutex;
 };
 
+// atomic operations on 32 bit integers, all
+// of them imply a full memory barrier. they
+// return the new value, except eAtomicCas()
+// which returns the value before the exchange.
+eInt    eAtomicInc(volatile eInt &x);
+eInt    eAtomicDec(volatile eInt &x);
+eInt    eAtomicAdd(volatile eInt &x, eInt val);
+eInt    eAtomicCas(volatile eInt &x, eInt exchange, eInt comparand);
+ePtr    eAtomicCasPtr(ePtr volatile &x, ePtr exchange, ePtr comparand);
+eU32    eGetCpuCount();
+
+// called once for each index of a parallel loop
+typedef void (* eJobFunc)(ePtr arg, eU32 index);
+
+// fixed pool of worker threads which executes
+// parallel loops. the calling thread takes part
+// in the work and run() returns as soon as all
+// indices have been processed. calling run()
+// from inside a job executes the loop serially
+// on the calling thread.
+class eJobPool
+{
+    friend class eJobWorker;
+
+public:
+    eJobPool(eU32 numWorkers=eU32_MAX); // default: one per additional core
+    ~eJobPool();
+
+    void                run(eJobFunc func, ePtr arg, eU32 count);
+    eU32                getThreadCount() const;
+
+    static eJobPool &   getDefault();
+    static void         shutdownDefault();
+
+private:
+    void                _workerLoop();
+    void                _work();
+
+private:
+    eArray<eThread *>   m_workers;
+    eMutex              m_runMutex;
+    ePtr                m_wakeSem;
+    ePtr                m_doneEvent;
+    eJobFunc            m_func;
+    ePtr                m_arg;
+    eU32                m_count;
+    volatile eInt       m_next;
+    volatile eInt       m_busy;
+    volatile eBool      m_quit;
+};
+
 #endif // THREADING_HPP
\ No newline at end of file
@@ -46,6 +46,51 @@ static void initApplication(eBool disableStyles)
         qApp->setStyleSheet(QString(cssFile.readAll()));
 }
 
+#ifdef eDEBUG
+static void linkOp(eIOperator *op, eOpClass opClass, const eIOperator *linkedOp)
+{
+    for (eU32 i=0; i<op->getParameterCount(); i++)
+    {
+        eParameter &param = op->getParameter(i);
+
+        if (param.getType() == ePT_LINK && (param.getAllowedLinks()&opClass))
+        {
+            param.getBaseValue().linkedOpId = linkedOp->getId();
+            return;
+        }
+    }
+}
+
+// two particle systems emitting from the same mesh
+// and sharing a texture become ready together and
+// have to be updated in parallel
+static void testParallelScheduling()
+{
+    eOperatorPage *page = eDemoData::addPage();
+    eIOperator *meshOp = page->addOperator(eOP_TYPE("Mesh", "Cube"), ePoint(0, 0));
+    eIOperator *bmpOp = page->addOperator(eOP_TYPE("Bitmap", "Fill"), ePoint(0, 2));
+    eIOperator *psysOp0 = page->addOperator(eOP_TYPE("Model", "Particles"), ePoint(0, 4));
+    eIOperator *psysOp1 = page->addOperator(eOP_TYPE("Model", "Particles"), ePoint(4, 4));
+    eIOperator *mergeOp = page->addOperator(eOP_TYPE("Model", "Merge"), ePoint(0, 5), 8);
+
+    linkOp(psysOp0, eOC_MESH, meshOp);
+    linkOp(psysOp0, eOC_BMP, bmpOp);
+    linkOp(psysOp1, eOC_MESH, meshOp);
+    linkOp(psysOp1, eOC_BMP, bmpOp);
+    eDemoData::connectPages();
+
+    eASSERT(psysOp0->getExecuteParallel());
+    eASSERT(psysOp1->getExecuteParallel());
+    eASSERT(!bmpOp->getExecuteParallel());
+
+    const eOpProcessResult res = mergeOp->process(0.0f);
+    eASSERT(res == eOPR_CHANGES);
+
+    eDemoData::removePage(page->getId());
+    eDemoData::connectPages();
+}
+#endif
+
 eInt main(eInt argc, eChar **argv)
 {
     eSimdSetArithmeticFlags(eSAF_RTN|eSAF_FTZ);
@@ -75,6 +120,9 @@ eInt main(eInt argc, eChar **argv)
 
     initApplication(disableStyles);
     eMainWnd mainWnd(projectFile);
+#ifdef eDEBUG
+    testParallelScheduling();
+#endif
     app.setActiveWindow(&mainWnd);
     mainWnd.show();
     return app.exec();
@@ -90,6 +90,7 @@ eRenderView::~eRenderView()
     m_synth.shutdown();
 
     eOpStacking::shutdown();
+    eJobPool::shutdownDefault();
     eProfiler::shutdown();
 }
 
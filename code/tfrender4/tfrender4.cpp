@@ -0,0 +1,310 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *   This file is part of
+ *       ______        _                             __ __
+ *      / ____/____   (_)____ _ ____ ___   ____ _   / // /
+ *     / __/  / __ \ / // __ `// __ `__ \ / __ `/  / // /_
+ *    / /___ / / / // // /_/ // / / / / // /_/ /  /__  __/
+ *   /_____//_/ /_//_/ \__, //_/ /_/ /_/ \__,_/     /_/.   
+ *                    /____/                              
+ *
+ *   Copyright  2003-2012 Brain Control, all rights reserved.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include <iostream>
+#include <iomanip>
+
+#include "../eshared/system/system.hpp"
+#include "../eshared/synth/tf4.hpp"
+
+using namespace std;
+
+const eChar VERSION[] = "1.0";
+const eU32  SAMPLE_RATE = 44100;
+
+enum eOutputFormat
+{
+    eOF_WAV_S16,
+    eOF_WAV_F32,
+    eOF_RAW_F32
+};
+
+struct eRenderJob
+{
+    const eChar *   inFile;
+    eString         outFile;
+    eOutputFormat   format;
+    eF32            volume;
+    eF32            tail;
+    eBool           parallel;
+
+    eBool           success;
+    eF32            songSecs;
+    eF32            renderSecs;
+    eU32            instrCount;
+    eU64            instrTicks[TF_MAX_INSTR];
+};
+
+// renders one song per thread, the songs' players
+// don't share any state
+class eRenderThread : public eThread
+{
+public:
+    eRenderThread(eRenderJob &job) : eThread(eTHP_NORMAL|eTHCF_SUSPENDED),
+        m_job(job)
+    {
+    }
+
+    virtual eU32 operator () ();
+
+private:
+    eRenderJob &    m_job;
+};
+
+static eByteArray makeWavHeader(eOutputFormat format, eU32 dataSize)
+{
+    const eU16 bytesPerSample = (format == eOF_WAV_S16 ? 2 : 4);
+    eDataStream ds;
+
+    ds.writeU32('FFIR');
+    ds.writeU32(36+dataSize);
+    ds.writeU32('EVAW');
+    ds.writeU32(' tmf');
+    ds.writeU32(16);
+    ds.writeU16(format == eOF_WAV_S16 ? 1 : 3); // PCM or IEEE float
+    ds.writeU16(2);
+    ds.writeU32(SAMPLE_RATE);
+    ds.writeU32(SAMPLE_RATE*2*bytesPerSample);
+    ds.writeU16(2*bytesPerSample);
+    ds.writeU16(bytesPerSample*8);
+    ds.writeU32('atad');
+    ds.writeU32(dataSize);
+
+    return ds.getData();
+}
+
+static eBool renderSong(eRenderJob &job)
+{
+    eBool loaded;
+    const eByteArray song = eFile::readAll(job.inFile, &loaded);
+
+    if (!loaded || song.isEmpty())
+        return eFALSE;
+
+    eTfPlayer *player = new eTfPlayer;
+    eTfPlayerInit(*player, SAMPLE_RATE);
+    eTfPlayerLoadSong(*player, &song[0], song.size(), 0.0f);
+    player->volume = job.volume;
+    player->jobPool = (job.parallel ? &eJobPool::getDefault() : nullptr);
+
+    // the song ends with its last event, the tail
+    // gives releases and effects time to fade out
+    eF32 endTime = 0.0f;
+
+    for (eU32 i=0; i<player->song.instrCount; i++)
+        if (!player->song.events[i].isEmpty())
+            endTime = eMax(endTime, player->song.events[i].last().time);
+
+    const eU32 numFrames = eFtoL((endTime+job.tail)*SAMPLE_RATE/TF_FRAMESIZE)+1;
+    const eU32 bytesPerSample = (job.format == eOF_WAV_S16 ? 2 : 4);
+    const eU32 frameBytes = TF_FRAMESIZE*2*bytesPerSample;
+    const eU32 dataSize = numFrames*frameBytes;
+    const eU32 headerSize = (job.format == eOF_RAW_F32 ? 0 : 44);
+
+    eByteArray out(headerSize+dataSize);
+
+    if (headerSize)
+        eMemCopy(&out[0], &makeWavHeader(job.format, dataSize)[0], headerSize);
+
+    // the float formats take the unclipped signal
+    // and scale it like eTfSignalToS16() does
+    const eF32 floatGain = 10000.0f*TF_MASTER_VOLUME*player->volume/32768.0f;
+    eTimer timer;
+
+    eTfPlayerStart(*player, 0.0f);
+
+    for (eU32 i=0; i<numFrames; i++)
+    {
+        const eU8 *frame = nullptr;
+        eTfPlayerProcess(*player, &frame);
+        eU8 *dst = &out[headerSize+i*frameBytes];
+
+        if (job.format == eOF_WAV_S16)
+            eMemCopy(dst, frame, frameBytes);
+        else
+        {
+            const eF32 *left = &player->outputSignal[0];
+            const eF32 *right = &player->outputSignal[TF_FRAMESIZE];
+            eF32 *samples = (eF32 *)dst;
+
+            for (eU32 j=0; j<TF_FRAMESIZE; j++)
+            {
+                *samples++ = left[j]*floatGain;
+                *samples++ = right[j]*floatGain;
+            }
+        }
+    }
+
+    job.renderSecs = timer.getElapsedMs()/1000.0f;
+    job.songSecs = (eF32)(numFrames*TF_FRAMESIZE)/(eF32)SAMPLE_RATE;
+    job.instrCount = player->song.instrCount;
+    eMemCopy(job.instrTicks, player->instrTicks, sizeof(job.instrTicks));
+
+    eTfPlayerStop(*player);
+    eTfPlayerUnloadSong(*player);
+    eDelete(player);
+
+    eFile f(job.outFile);
+    if (!f.open(eFOM_WRITE))
+        return eFALSE;
+
+    f.clear();
+    f.write(out);
+    return f.close();
+}
+
+eU32 eRenderThread::operator () ()
+{
+    m_job.success = renderSong(m_job);
+    return 0;
+}
+
+static eString makeOutFileName(const eChar *inFile, eOutputFormat format)
+{
+    const eString name = inFile;
+    eU32 extPos = name.length();
+
+    for (eInt i=(eInt)name.length()-1; i>=0 && name[i] != '\\' && name[i] != '/'; i--)
+    {
+        if (name[i] == '.')
+        {
+            extPos = i;
+            break;
+        }
+    }
+
+    eString outFile = (extPos ? name.subStr(0, extPos) : name);
+    outFile += (format == eOF_RAW_F32 ? ".raw" : ".wav");
+    return outFile;
+}
+
+static void printReport(const eRenderJob &job)
+{
+    cout << job.inFile << " -> " << (const eChar *)job.outFile << endl;
+
+    if (!job.success)
+    {
+        cout << "    failed, could not read song or write output!" << endl;
+        return;
+    }
+
+    const eF64 freq = (eF64)eTimer::getFrequency();
+    cout << fixed << setprecision(2);
+    cout << "    song length: " << job.songSecs << " s, render time: " << job.renderSecs << " s, ";
+    cout << "realtime factor: " << job.songSecs/eMax(job.renderSecs, 0.001f) << "x" << endl;
+
+    for (eU32 i=0; i<job.instrCount; i++)
+    {
+        const eF64 secs = (eF64)job.instrTicks[i]/freq;
+        cout << "    instrument " << setw(2) << i << ": " << setw(8) << secs*1000.0 << " ms";
+        cout << " (" << setw(5) << secs/job.songSecs*100.0 << " % of realtime)" << endl;
+    }
+}
+
+static void printUsage()
+{
+    cout << "Usage: tfrender4.exe [options] <song file> [<song file> ...]" << endl;
+    cout << "    -f <wav|wavf|raw>  output 16 bit wav (default), float wav or raw float" << endl;
+    cout << "    -v <volume>        master volume (default 0.4)" << endl;
+    cout << "    -t <seconds>       time rendered after the last event (default 2)" << endl;
+    cout << "    -p                 render instruments in parallel" << endl;
+    cout << "Multiple songs are rendered at once, each on its own thread." << endl;
+}
+
+eInt main(eInt argc, eChar *argv[])
+{
+    cout << "-----------------------------------------------------------" << endl;
+    cout << "Tunefish Render " << VERSION << " - Offline Song Renderer" << endl;
+    cout << "Copyright (c) 2012 by Brain Control, all rights reserved." << endl;
+    cout << "-----------------------------------------------------------" << endl;
+
+    eOutputFormat format = eOF_WAV_S16;
+    eF32 volume = 0.4f;
+    eF32 tail = 2.0f;
+    eBool parallel = eFALSE;
+    eArray<const eChar *> inFiles;
+
+    for (eInt i=1; i<argc; i++)
+    {
+        const eString arg = argv[i];
+
+        if (arg == "-f" && i+1 < argc)
+        {
+            const eString fmt = argv[++i];
+
+            if (fmt == "wav")
+                format = eOF_WAV_S16;
+            else if (fmt == "wavf")
+                format = eOF_WAV_F32;
+            else if (fmt == "raw")
+                format = eOF_RAW_F32;
+            else
+            {
+                cout << "Unknown output format: " << (const eChar *)fmt << endl;
+                printUsage();
+                return 1;
+            }
+        }
+        else if (arg == "-v" && i+1 < argc)
+            volume = eStrToFloat(argv[++i]);
+        else if (arg == "-t" && i+1 < argc)
+            tail = eStrToFloat(argv[++i]);
+        else if (arg == "-p")
+            parallel = eTRUE;
+        else
+            inFiles.append(argv[i]);
+    }
+
+    if (inFiles.isEmpty())
+    {
+        printUsage();
+        return 0;
+    }
+
+    eArray<eRenderJob *> jobs(inFiles.size());
+    eArray<eRenderThread *> threads(inFiles.size());
+    eTimer timer;
+
+    for (eU32 i=0; i<inFiles.size(); i++)
+    {
+        eRenderJob *job = new eRenderJob;
+        job->inFile = inFiles[i];
+        job->outFile = makeOutFileName(inFiles[i], format);
+        job->format = format;
+        job->volume = volume;
+        job->tail = tail;
+        job->parallel = parallel;
+        job->success = eFALSE;
+        job->instrCount = 0;
+        jobs[i] = job;
+
+        threads[i] = new eRenderThread(*job);
+        threads[i]->resume();
+    }
+
+    eInt res = 0;
+
+    for (eU32 i=0; i<jobs.size(); i++)
+    {
+        eDelete(threads[i]); // joins thread
+        printReport(*jobs[i]);
+        res = (jobs[i]->success ? res : -1);
+        eDelete(jobs[i]);
+    }
+
+    eJobPool::shutdownDefault();
+    cout << "Total time: " << timer.getElapsedMs()/1000.0f << " s" << endl;
+    return res;
+}
\ No newline at end of file
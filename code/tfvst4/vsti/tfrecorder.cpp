@@ -18,6 +18,79 @@
 
 eTfRecorder eTfRecorder::m_recorder;
 
+// moves the recorded events from the synth queues
+// into the event list while recording
+class eTfRecorderThread : public eThread
+{
+public:
+	eTfRecorderThread(eTfRecorder &recorder) : eThread(eTHP_LOW|eTHCF_SUSPENDED),
+		m_recorder(recorder),
+		m_joinRequest(eFALSE)
+	{
+	}
+
+	virtual eU32 operator () ()
+	{
+		while (!m_joinRequest)
+		{
+			m_recorder.drain();
+			sleep(10);
+		}
+
+		return 0;
+	}
+
+	void requestJoin()
+	{
+		m_joinRequest = eTRUE;
+	}
+
+private:
+	eTfRecorder &	m_recorder;
+	volatile eBool	m_joinRequest;
+};
+
+// appends binary values to a byte array, the song
+// is built in memory and written to file at once
+class eTfSongWriter
+{
+public:
+	eTfSongWriter(eU32 capacity)
+	{
+		m_data.reserve(capacity);
+	}
+
+	void writeU8(eU8 val)
+	{
+		m_data.append(val);
+	}
+
+	void writeU16(eU16 val)
+	{
+		writeRaw(&val, sizeof(val));
+	}
+
+	void writeTag(const eChar *tag)
+	{
+		writeRaw(tag, 4);
+	}
+
+	void writeRaw(eConstPtr data, eU32 size)
+	{
+		const eU32 pos = m_data.size();
+		m_data.resize(pos+size);
+		eMemCopy(&m_data[pos], data, size);
+	}
+
+	const eByteArray & getData() const
+	{
+		return m_data;
+	}
+
+private:
+	eByteArray		m_data;
+};
+
 #define ePARAM_ZERO(x) params[x] = 0.0f;
 #define ePARAM_ZERO_IF_ZERO(x, y) if (params[x] < 0.01f) params[y] = 0.0f;
 #define ePARAM_ZERO_IF_OFF(x, y) if (params[x] < 0.5f) params[y] = 0.0f;
@@ -133,7 +206,17 @@ eTfRecorder::eTfRecorder()
 {
 	eMemSet(m_synths, 0, sizeof(eTfVstSynth*) * TF_MAX_INSTR);
 	m_isRecording = eFALSE;
+	m_drainThread = nullptr;
 	m_tempo = 0;
+
+	for(eU32 i=0;i<TF_MAX_INSTR; i++) 
+	{
+		EventQueue &queue = m_queues[i];
+		queue.events.resize(TF_RECORDER_QUEUE_SIZE);
+		queue.writeCount = 0;
+		queue.readCount = 0;
+		queue.dropCount = 0;
+	}
 }
 
 eTfRecorder::~eTfRecorder()
@@ -148,9 +231,16 @@ eTfRecorder & eTfRecorder::getInstance()
 
 void eTfRecorder::reset()
 {
-	m_cs.enter();
+	eScopedLock lock(m_cs);
 	m_events.clear();
-	m_cs.leave();
+
+	// events queued before are dropped
+	for(eU32 i=0;i<TF_MAX_INSTR; i++) 
+	{
+		EventQueue &queue = m_queues[i];
+		eAtomicAdd(queue.readCount, queue.writeCount-queue.readCount);
+		queue.dropCount = 0;
+	}
 }
 
 void eTfRecorder::startRecording()
@@ -158,13 +248,19 @@ void eTfRecorder::startRecording()
 	if (!m_isRecording)
 	{
 		reset();
+		m_drainThread = new eTfRecorderThread(*this);
+		m_drainThread->resume();
 		m_isRecording = eTRUE;
 	}
 }
 
 void eTfRecorder::stopRecording()
 {
-	m_isRecording = eFALSE;
+	if (m_isRecording)
+	{
+		m_isRecording = eFALSE;
+		_stopDrainThread();
+	}
 }
 
 eBool eTfRecorder::isRecording()
@@ -176,22 +272,12 @@ eBool eTfRecorder::saveToFile(QString fileName)
 {
 	stopRecording();
 
-	m_cs.enter();
-
-	// write binary file
-	// -------------------------------------------------------------------
-	QFile fileLog(fileName + ".log");
-	QFile fileBin(fileName);
-
-	if (!fileBin.open(QIODevice::WriteOnly))
-		return eFALSE;
-
-	if (!fileLog.open(QIODevice::WriteOnly))
-		return eFALSE;
+	eScopedLock lock(m_cs);
 
 	// count stuff
 	eU16 synthCount = 0;
 	eU16 eventCount[TF_MAX_INSTR];
+	eArray<eTfEvent> events[TF_MAX_INSTR];
 
 	for(eU32 i=0;i<TF_MAX_INSTR; i++) 
 	{
@@ -205,37 +291,14 @@ eBool eTfRecorder::saveToFile(QString fileName)
 		eventCount[m_events[i].instr]++;
 	}
 
-	// write header values
-	fileBin.write((const char *)&synthCount, sizeof(eU16));
-	fileBin.write((const char *)&m_tempo, sizeof(eU16));
-
-	fileLog.write("Instruments: ");
-	fileLog.write(QString::number(synthCount).toAscii().constData());
-	fileLog.write("\r\n");
-
-	fileLog.write("Tempo: ");
-	fileLog.write(QString::number(m_tempo).toAscii().constData());
-	fileLog.write("\r\n");
-
 	for(eU32 i=0;i<TF_MAX_INSTR; i++) 
-	{
-		if (m_synths[i] != nullptr)
-		{
-			fileBin.write((const char *)&eventCount[i], sizeof(eU16));
+		events[i].reserve(eventCount[i]);
 
-			fileLog.write("Eventcount for instr ");
-			fileLog.write(QString::number(i).toAscii().constData());
-			fileLog.write(": ");
-			fileLog.write(QString::number(eventCount[i]).toAscii().constData());
-			fileLog.write("\r\n");
-		}
+	for(eU32 i=0;i<m_events.size();i++)
+	{
+		events[m_events[i].instr].append(m_events[i]);
 	}
 
-	fileLog.write("Instruments\r\n");
-	fileLog.write("-----------------------------------------\r\n");
-
-	fileBin.write("INST");
-
 	// optimize instruments
 	for(eU32 i=0;i<TF_MAX_INSTR; i++) 
 	{
@@ -247,6 +310,26 @@ eBool eTfRecorder::saveToFile(QString fileName)
 		}
 	}
 
+	// calculate speed values
+    const eU32 rows_per_beat = 4;
+	const eU32 rows_per_min = m_tempo * rows_per_beat;
+    const eF32 rows_per_sec = (eF32)rows_per_min / 60.0f;
+
+	// build binary file
+	// -------------------------------------------------------------------
+	eTfSongWriter bin(16 + synthCount*(sizeof(eU16) + TF_PARAM_COUNT) + m_events.size()*(sizeof(eU16) + 2));
+
+	bin.writeU16(synthCount);
+	bin.writeU16(m_tempo);
+
+	for(eU32 i=0;i<TF_MAX_INSTR; i++) 
+	{
+		if (m_synths[i] != nullptr)
+			bin.writeU16(eventCount[i]);
+	}
+
+	bin.writeTag("INST");
+
 	// write instruments  (grouped by instruments)
 	for(eU32 i=0;i<TF_MAX_INSTR; i++) 
 	{
@@ -256,75 +339,64 @@ eBool eTfRecorder::saveToFile(QString fileName)
 		{
 			eTfSynth *tf = synth->getTunefish();
 
-			fileLog.write("Params for instr ");
-			fileLog.write(QString::number(i).toAscii().constData());
-			fileLog.write("\r\n");
-			fileLog.write("-----------------------------------------\r\n");
-
 			for(eU32 j=0; j<TF_PARAM_COUNT; j++)
-			{
-				eF32 value = tf->instr[0]->params[j];
-				eU8 ivalue = (eU8)(value * 100.0f);
-
-				fileLog.write(TF_NAMES[j]);
-				fileLog.write(": ");
-				fileLog.write(QString::number(value).toAscii().constData());
-				fileLog.write(" -> ");
-				fileLog.write(QString::number(ivalue).toAscii().constData());
-				fileLog.write("\r\n");
-
-				fileBin.write((const char *)&ivalue, sizeof(eU8));
-			}
+				bin.writeU8((eU8)(tf->instr[0]->params[j] * 100.0f));
 		}
 	}
 
-	/*
-	// write instruments  (grouped by paramindex)		
-	for(eU32 j=0; j<TF_PARAM_COUNT; j++)
+	bin.writeTag("SONG");
+
+	for(eU32 i=0;i<TF_MAX_INSTR; i++) 
 	{
-		for(eU32 i=0;i<TF_MAX_INSTR; i++) 
+		if (m_synths[i] != nullptr)
 		{
-			eTfVstSynth *synth = m_synths[i];
+			const eArray<eTfEvent> &instrEvents = events[i];
 
-			if (synth != nullptr)
+			// write times
+			eU16 oldRow = 0;
+			for(eU32 j=0;j<instrEvents.size();j++)
 			{
-				eTfSynth *tf = synth->getTunefish();
+                eU16 row = eFtoL(eRound(instrEvents[j].time * rows_per_sec));
+                bin.writeU16(row - oldRow);
+                oldRow = row;
+			}
 
-				eF32 value = tf->instr[0]->params[j];
-				eU8 ivalue = (eU8)(value * 100.0f);
+			// write notes
+			for(eU32 j=0;j<instrEvents.size();j++)
+				bin.writeU8(instrEvents[j].note);
 
-				fileBin.write((const char *)&ivalue, sizeof(eU8));
-			}
+			// write velocities
+			for(eU32 j=0;j<instrEvents.size();j++)
+				bin.writeU8(instrEvents[j].velocity);
 		}
 	}
-	*/
-	fileLog.write("Events (Time, iTime, Instrument, Note, Velocity)\r\n");
-	fileLog.write("-----------------------------------------\r\n");
 
-	// calculate speed values
-    const eU32 rows_per_beat = 4;
-	const eU32 rows_per_min = m_tempo * rows_per_beat;
-    const eF32 rows_per_sec = (eF32)rows_per_min / 60.0f;
+    bin.writeTag("ENDS");
 
-    // write events
-	for(eU32 i=0;i<m_events.size();i++)
+	// build log file
+	// -------------------------------------------------------------------
+	QByteArray log;
+
+	log += "Instruments: " + QByteArray::number(synthCount) + "\r\n";
+	log += "Tempo: " + QByteArray::number(m_tempo) + "\r\n";
+
+	for(eU32 i=0;i<TF_MAX_INSTR; i++) 
 	{
-		eTfEvent &e = m_events[i];
+		if (m_synths[i] != nullptr)
+			log += "Eventcount for instr " + QByteArray::number(i) + ": " + QByteArray::number(eventCount[i]) + "\r\n";
+	}
+
+	// events lost because a queue was full
+	const eU32 dropCount = getDropCount();
 
-		fileLog.write("Event: ");
-		fileLog.write(QString::number(e.time).toAscii().constData());
-		fileLog.write("\t");
-		fileLog.write(QString::number((eU32)(e.time * rows_per_sec)).toAscii().constData());
-		fileLog.write("\t");
-		fileLog.write(QString::number(e.instr).toAscii().constData());
-		fileLog.write("\t");
-		fileLog.write(QString::number(e.note).toAscii().constData());
-		fileLog.write("\t");
-		fileLog.write(QString::number(e.velocity).toAscii().constData());
-		fileLog.write("\r\n");
+	for(eU32 i=0;i<TF_MAX_INSTR; i++) 
+	{
+		if (m_queues[i].dropCount > 0)
+			log += "Dropped events for instr " + QByteArray::number(i) + ": " + QByteArray::number(m_queues[i].dropCount) + "\r\n";
 	}
 
-	fileBin.write("SONG");
+	log += "Instruments\r\n";
+	log += "-----------------------------------------\r\n";
 
 	for(eU32 i=0;i<TF_MAX_INSTR; i++) 
 	{
@@ -332,107 +404,157 @@ eBool eTfRecorder::saveToFile(QString fileName)
 
 		if (synth != nullptr)
 		{
-			// write times
-			eU16 oldRow = 0;
-			for(eU32 j=0;j<m_events.size();j++)
-			{
-				eTfEvent &e = m_events[j];
-				if (e.instr == i)
-				{
-                    eU16 row = eFtoL(eRound(e.time * rows_per_sec));
-                    eU16 diff = row - oldRow;
-                    oldRow = row;
-
-                    fileBin.write((const char *)&diff, sizeof(eU16));
-				}
-			}
+			eTfSynth *tf = synth->getTunefish();
 
-			// write notes
-			for(eU32 j=0;j<m_events.size();j++)
-			{
-				eTfEvent &e = m_events[j];
-				if (e.instr == i)
-				{
-					fileBin.write((const char *)&e.note, sizeof(eU8));
-				}
-			}
+			log += "Params for instr " + QByteArray::number(i) + "\r\n";
+			log += "-----------------------------------------\r\n";
 
-			// write velocities
-			for(eU32 j=0;j<m_events.size();j++)
+			for(eU32 j=0; j<TF_PARAM_COUNT; j++)
 			{
-				eTfEvent &e = m_events[j];
-				if (e.instr == i)
-				{
-					eU8 vel = e.velocity;
-					fileBin.write((const char *)&vel, sizeof(eU8));
-				}	
+				eF32 value = tf->instr[0]->params[j];
+				eU8 ivalue = (eU8)(value * 100.0f);
+
+				log += QByteArray(TF_NAMES[j]) + ": " + QByteArray::number(value) + " -> " + QByteArray::number(ivalue) + "\r\n";
 			}
 		}
 	}
 
-    fileBin.write("ENDS");
-	fileBin.close();
-	fileLog.close();
+	log += "Events (Time, iTime, Instrument, Note, Velocity)\r\n";
+	log += "-----------------------------------------\r\n";
 
-	m_cs.leave();
+	// the drain thread appends the events grouped
+	// by instrument, so they're merged by time
+	eU32 eventPos[TF_MAX_INSTR];
+	eMemSet(eventPos, 0, sizeof(eventPos));
 
-	// write header file
-	// -------------------------------------------------------------------
-	QFile headerIn(fileName);
-	QFile headerOut(fileName + ".h");
+	for(eU32 i=0;i<m_events.size();i++)
+	{
+		eU32 instr = 0;
+		eF32 minTime = eF32_MAX;
 
-	if (!headerIn.open(QIODevice::ReadOnly))
-		return eFALSE;
+		for(eU32 j=0;j<TF_MAX_INSTR; j++) 
+		{
+			if (eventPos[j] < events[j].size() && events[j][eventPos[j]].time < minTime)
+			{
+				instr = j;
+				minTime = events[j][eventPos[j]].time;
+			}
+		}
 
-	QByteArray input = headerIn.readAll();
-	headerIn.close();
+		const eTfEvent &e = events[instr][eventPos[instr]++];
 
-	if (!headerOut.open(QIODevice::WriteOnly))
-		return eFALSE;
+		log += "Event: " + QByteArray::number(e.time) + "\t" + QByteArray::number((eU32)(e.time * rows_per_sec)) + "\t";
+		log += QByteArray::number(e.instr) + "\t" + QByteArray::number(e.note) + "\t" + QByteArray::number(e.velocity) + "\r\n";
+	}
 
-	headerOut.write("const unsigned char song[] = {\r\n");
+	// build header file
+	// -------------------------------------------------------------------
+	static const eChar hexDigits[] = "0123456789abcdef";
+	const eByteArray &data = bin.getData();
+	QByteArray header;
+
+	header.reserve(64 + data.size()*6 + data.size()/16*3);
+	header += "const unsigned char song[] = {\r\n";
 	
-	for(eS32 i=0;i<input.size();i++) 
+	for(eU32 i=0;i<data.size();i++) 
 	{
-		eBool lastByte = i == input.size()-1;
+		eBool lastByte = i == data.size()-1;
 		eBool lastInRow = i % 16 == 15;
 		eBool firstInRow = i % 16 == 0;
 
 		if (firstInRow)
-			headerOut.write("\t");
-
-		QString numstr = QString::number((const eU8)input[i], 16);
-		if (numstr.length() == 1)
-			numstr = "0" + numstr;
+			header += '\t';
 
-		numstr = QString("0x") + numstr;
-
-		headerOut.write(numstr.toAscii().constData());
+		header += "0x";
+		header += hexDigits[data[i]>>4];
+		header += hexDigits[data[i]&15];
 
 		if (!lastByte)
-			headerOut.write(", ");
+			header += ", ";
 
 		if (lastInRow || lastByte)
-			headerOut.write("\r\n");
+			header += "\r\n";
 	}
 
-	headerOut.write("};\r\n");
+	header += "};\r\n";
+
+	// write files
+	// -------------------------------------------------------------------
+	QFile fileBin(fileName);
+	QFile fileLog(fileName + ".log");
+	QFile fileHeader(fileName + ".h");
+
+	if (!fileBin.open(QIODevice::WriteOnly))
+		return eFALSE;
+
+	fileBin.write((const char *)&data[0], data.size());
+	fileBin.close();
+
+	if (!fileLog.open(QIODevice::WriteOnly))
+		return eFALSE;
+
+	fileLog.write(log);
+	fileLog.close();
+
+	if (!fileHeader.open(QIODevice::WriteOnly))
+		return eFALSE;
 
-	headerOut.close();
+	fileHeader.write(header);
+	fileHeader.close();
 
-	return eTRUE;
+	// the song is written nevertheless, but it's
+	// incomplete if events were lost
+	return (dropCount == 0);
 }
 
+// called from the synth's audio thread, so it
+// must never block. if the drain thread falls
+// behind and the queue is full the event is lost.
 void eTfRecorder::recordEvent(eTfEvent e)
 {
-	if (m_isRecording)
+	if (m_isRecording && e.instr < TF_MAX_INSTR)
+	{
+		EventQueue &queue = m_queues[e.instr];
+		const eU32 writeCount = (eU32)queue.writeCount;
+
+		if (writeCount-(eU32)queue.readCount >= TF_RECORDER_QUEUE_SIZE)
+		{
+			eAtomicInc(queue.dropCount);
+			return;
+		}
+
+		queue.events[writeCount%TF_RECORDER_QUEUE_SIZE] = e;
+		eAtomicInc(queue.writeCount);
+	}
+}
+
+void eTfRecorder::drain()
+{
+	eScopedLock lock(m_cs);
+
+	for(eU32 i=0;i<TF_MAX_INSTR; i++) 
 	{
-		m_cs.enter();
-		m_events.push(e);
-		m_cs.leave();
+		EventQueue &queue = m_queues[i];
+		const eU32 readCount = (eU32)queue.readCount;
+		const eU32 count = (eU32)queue.writeCount-readCount;
+
+		for(eU32 j=0;j<count;j++)
+			m_events.append(queue.events[(readCount+j)%TF_RECORDER_QUEUE_SIZE]);
+
+		eAtomicAdd(queue.readCount, count);
 	}
 }
 
+eU32 eTfRecorder::getDropCount()
+{
+	eU32 count = 0;
+
+	for(eU32 i=0;i<TF_MAX_INSTR; i++) 
+		count += m_queues[i].dropCount;
+
+	return count;
+}
+
 void eTfRecorder::setTempo(eU16 tempo)
 {
 	m_tempo = tempo;
@@ -459,14 +581,31 @@ eS32 eTfRecorder::addSynth(eTfVstSynth *synth)
 
 void eTfRecorder::removeSynth(eTfVstSynth *synth)
 {
+	eBool synthsLeft = eFALSE;
+
 	m_cs.enter();
 	for(eU32 i=0;i<TF_MAX_INSTR; i++) 
 	{
 		if (m_synths[i] == synth) 
-		{
 			m_synths[i] = nullptr;
-			break;
-		}
+		else if (m_synths[i] != nullptr)
+			synthsLeft = eTRUE;
 	}
 	m_cs.leave();
+
+	// the drain thread mustn't outlive the
+	// last synth (and the plugin module)
+	if (!synthsLeft)
+		stopRecording();
+}
+
+void eTfRecorder::_stopDrainThread()
+{
+	if (m_drainThread)
+	{
+		m_drainThread->requestJoin();
+		eDelete(m_drainThread);
+	}
+
+	drain();
 }
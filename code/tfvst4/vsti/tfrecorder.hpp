@@ -17,6 +17,10 @@
 
 #include <QtCore/QString>
 
+const eU32 TF_RECORDER_QUEUE_SIZE = 4096;
+
+class eTfRecorderThread;
+
 class eTfRecorder 
 {
 public:
@@ -32,17 +36,38 @@ public:
 
 	eBool				saveToFile(QString fileName);
 	void				recordEvent(eTfEvent e);
+	eU32				getDropCount();
 	void				setTempo(eU16 tempo);
 
 	eS32 				addSynth(eTfVstSynth *synth);
 	void				removeSynth(eTfVstSynth *synth);
 
+	void				drain();
+
+private:
+	void				_stopDrainThread();
+
+private:
+	// each synth records into its own queue from
+	// the audio thread, which is emptied by the
+	// drain thread. single producer and consumer,
+	// so no locks are needed.
+	struct EventQueue
+	{
+		eArray<eTfEvent>	events;
+		volatile eInt		writeCount;
+		volatile eInt		readCount;
+		volatile eInt		dropCount;
+	};
+
 private:
 	eMutex				m_cs;
 	eArray<eTfEvent>	m_events;
-	eU16				m_tempo;
+	EventQueue			m_queues[TF_MAX_INSTR];
+	eTfRecorderThread *	m_drainThread;
+	volatile eU16		m_tempo;
 	eTfVstSynth	*		m_synths[TF_MAX_INSTR];
-	eBool				m_isRecording;
+	volatile eBool		m_isRecording;
 
 	static eTfRecorder  m_recorder;
 };
@@ -14,6 +14,62 @@
 
 #include "tfvsti.hpp"
 
+// prepares the effect pool after an effect slot
+// or the whole program changed. hosts call
+// setParameter() from the audio thread during
+// automation, so requests only flag the work and
+// wake the thread, which sleeps on an event.
+class eTfPrepareThread : public eThread
+{
+public:
+	eTfPrepareThread(eTfInstrument &instr) : eThread(eTHP_LOW|eTHCF_SUSPENDED),
+		m_instr(instr),
+		m_wakeEvent(CreateEvent(NULL, FALSE, FALSE, NULL)),
+		m_pending(0),
+		m_joinRequest(eFALSE)
+	{
+		eASSERT(m_wakeEvent);
+	}
+
+	virtual ~eTfPrepareThread()
+	{
+		requestJoin();
+		join();
+		CloseHandle(m_wakeEvent);
+	}
+
+	virtual eU32 operator () ()
+	{
+		while (!m_joinRequest)
+		{
+			if (eAtomicCas(m_pending, 0, 1) == 1)
+				eTfInstrumentPrepareEffects(m_instr);
+			else
+				WaitForSingleObject(m_wakeEvent, INFINITE);
+		}
+
+		return 0;
+	}
+
+	void requestPrepare()
+	{
+		m_pending = 1;
+		SetEvent(m_wakeEvent);
+	}
+
+	void requestJoin()
+	{
+		m_joinRequest = eTRUE;
+		SetEvent(m_wakeEvent);
+	}
+
+private:
+	eTfInstrument &	m_instr;
+	HANDLE			m_wakeEvent;
+	volatile eInt	m_pending;
+	volatile eBool	m_joinRequest;
+};
+
 eTfVstSynth::eTfVstSynth (audioMasterCallback audioMaster, void* hInstance) : AudioEffectX (audioMaster, TF_VSTI_NUM_PROGRAMS, TF_PARAM_COUNT)
 {
 	modulePath = eTfGetModulePath((HINSTANCE)hInstance);
@@ -25,6 +81,9 @@ eTfVstSynth::eTfVstSynth (audioMasterCallback audioMaster, void* hInstance) : Au
     tf->instr[0] = new eTfInstrument;
     eTfInstrumentInit(*tf, *tf->instr[0]);
 
+    prepareThread = new eTfPrepareThread(*tf->instr[0]);
+    prepareThread->resume();
+
 	// Add to recorder
 	// -------------------------------------------------------
 	recorderIndex = eTfRecorder::getInstance().addSynth(this);
@@ -67,6 +126,7 @@ eTfVstSynth::~eTfVstSynth ()
 {
 	eTfRecorder::getInstance().removeSynth(this);
 	eDelete(editor);
+    eDelete(prepareThread);
     eDelete(tf->instr[0]);
 	eDelete(tf);
 }
@@ -92,6 +152,8 @@ void eTfVstSynth::setProgram (long program)
 	ap = &programs[curProgram];	
 	for(int i=0;i<TF_PARAM_COUNT;i++)
 		tf->instr[0]->params[i] = ap->params[i];
+
+    prepareThread->requestPrepare();
 }
 
 void eTfVstSynth::writeProgramToPresets()
@@ -106,6 +168,8 @@ void eTfVstSynth::loadProgramFromPresets()
     eTfSynthProgram *ap = &programs[curProgram];	
     for(int i=0;i<TF_PARAM_COUNT;i++)
         tf->instr[0]->params[i] = ap->params[i];
+
+    prepareThread->requestPrepare();
 }
 
 void eTfVstSynth::setProgramName (char *name)
@@ -148,6 +212,11 @@ void eTfVstSynth::setParameter (long index, float value)
 	eTfSynthProgram *ap = &programs[curProgram];
 	tf->instr[0]->params[index] = value;
     ap->params[index] = value;
+
+    // effect instances are allocated by the prepare
+    // thread, until then the new slot stays bypassed
+    if (index >= TF_EFFECT_1 && index < TF_EFFECT_1+TF_MAXEFFECTS)
+        prepareThread->requestPrepare();
 }
 
 float eTfVstSynth::getParameter (long index)
@@ -373,6 +442,8 @@ bool eTfVstSynth::loadProgramAll()
             eTfSynthProgram *ap = &programs[curProgram];	
             for(int i=0;i<TF_PARAM_COUNT;i++)
                 tf->instr[0]->params[i] = ap->params[i];
+
+            prepareThread->requestPrepare();
         }
 	}
 
@@ -479,6 +550,7 @@ bool eTfVstSynth::pasteProgram()
 	for(int i=0;i<TF_PARAM_COUNT;i++)    
         tf->instr[0]->params[i] = ap->params[i];
 
+    prepareThread->requestPrepare();
     eStrCopy(programs[curProgram].name, ap->name);
 
     return true;
@@ -591,5 +663,3 @@ long eTfVstSynth::processEvents (VstEvents* ev)
 	}
 	return 1;	// want more
 }
-
-
@@ -15,6 +15,8 @@
 #ifndef TF_VSTSYNTH_HPP
 #define TF_VSTSYNTH_HPP
 
+class eTfPrepareThread;
+
 class eTfVstSynth : public AudioEffectX
 {
 public:
@@ -83,6 +85,7 @@ private:
 	eTfSynthProgram		programs[TF_VSTI_NUM_PROGRAMS];
     eTfSynthProgram		copiedProgram;
 	eTfSynth *			tf;
+	eTfPrepareThread *	prepareThread;
 	eU32				recorderIndex;
 	long				channelPrograms[16];
 	QString				modulePath;
@@ -681,8 +681,15 @@ void tfWindow::recordStop(bool checked)
 	eTfRecorder::getInstance().stopRecording();
 
 	const QString filePath = QFileDialog::getSaveFileName(this, "", "", "Tunefish songs (*.tf4m)");
-	if (filePath != "")
-		eTfRecorder::getInstance().saveToFile(filePath);
+	if (filePath != "" && !eTfRecorder::getInstance().saveToFile(filePath))
+	{
+		const eU32 dropCount = eTfRecorder::getInstance().getDropCount();
+
+		if (dropCount > 0)
+			QMessageBox::warning(this, "Tunefish", QString::number(dropCount) + " events were lost while recording, the song is incomplete!");
+		else
+			QMessageBox::critical(this, "Tunefish", "Song could not be saved!");
+	}
 }
 
 void tfWindow::_createIcons()